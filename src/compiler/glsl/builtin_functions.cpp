@@ -39,7 +39,8 @@
  *
  *    The builtin_builder::create_builtins() function contains lists of all
  *    built-in function signatures, where they're available, what types they
- *    take, and so on.
+ *    take, and so on.  Functions are only created the first time a shader
+ *    refers to them.
  *
  * 4. Implementations of built-in function signatures
  *
@@ -83,6 +84,7 @@
 #include <math.h>
 #include "builtin_functions.h"
 #include "util/hash_table.h"
+#include "util/set.h"
 
 #define M_PIf   ((float) M_PI)
 #define M_PI_2f ((float) M_PI_2)
@@ -624,8 +626,9 @@ namespace {
  * builtin_builder: A singleton object representing the core of the built-in
  * function module.
  *
- * It generates IR for every built-in function signature, and organizes them
- * into functions.
+ * It generates IR for the built-in function signatures, and organizes them
+ * into functions.  Compiler intrinsics are created up front, everything else
+ * is created by name the first time it's looked up.
  */
 class builtin_builder {
 public:
@@ -636,22 +639,41 @@ public:
    void release();
    ir_function_signature *find(_mesa_glsl_parse_state *state,
                                const char *name, exec_list *actual_parameters);
+   ir_function *lookup_function(const char *name);
+   bool has_function(const char *name);
 
    /**
     * A shader to hold all the built-in signatures; created by this module.
     *
-    * This includes signatures for every built-in, regardless of version or
-    * enabled extensions.  The availability predicate associated with each
-    * signature allows matching_signature() to filter out the irrelevant ones.
+    * This includes signatures for every built-in that has been looked up so
+    * far, regardless of version or enabled extensions.  The availability
+    * predicate associated with each signature allows matching_signature() to
+    * filter out the irrelevant ones.
     */
    gl_shader *shader;
 
 private:
    void *mem_ctx;
 
+   /** Names of all functions create_builtins() can create. */
+   struct set *names;
+
+   /**
+    * Set while create_builtins() only records the function names in
+    * \c names without creating anything.
+    */
+   bool collect_names;
+
+   /**
+    * The only function create_builtins() should create, or NULL to create
+    * every function.
+    */
+   const char *requested_function;
+
    void create_shader();
    void create_intrinsics();
    void create_builtins();
+   bool want_function(const char *name);
 
    /**
     * IR builder helpers:
@@ -987,7 +1009,8 @@ enum image_function_flags {
  *  @{
  */
 builtin_builder::builtin_builder()
-   : shader(NULL)
+   : shader(NULL), names(NULL), collect_names(false),
+     requested_function(NULL)
 {
    mem_ctx = NULL;
 }
@@ -1010,7 +1033,7 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
     */
    state->uses_builtin_functions = true;
 
-   ir_function *f = shader->symbols->get_function(name);
+   ir_function *f = lookup_function(name);
    if (f == NULL)
       return NULL;
 
@@ -1022,6 +1045,30 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
    return sig;
 }
 
+/**
+ * Look up a built-in function by name, creating it on first use.
+ */
+ir_function *
+builtin_builder::lookup_function(const char *name)
+{
+   ir_function *f = shader->symbols->get_function(name);
+   if (f != NULL || _mesa_set_search(names, name) == NULL)
+      return f;
+
+   requested_function = name;
+   create_builtins();
+   requested_function = NULL;
+
+   return shader->symbols->get_function(name);
+}
+
+bool
+builtin_builder::has_function(const char *name)
+{
+   return _mesa_set_search(names, name) != NULL ||
+          shader->symbols->get_function(name) != NULL;
+}
+
 void
 builtin_builder::initialize()
 {
@@ -1032,7 +1079,15 @@ builtin_builder::initialize()
    mem_ctx = ralloc_context(NULL);
    create_shader();
    create_intrinsics();
+
+   /* Generating the IR for all built-ins takes a while and most shaders only
+    * use a handful of them, so only record their names here.
+    */
+   names = _mesa_set_create(mem_ctx, _mesa_key_hash_string,
+                            _mesa_key_string_equal);
+   collect_names = true;
    create_builtins();
+   collect_names = false;
 }
 
 void
@@ -1040,6 +1095,7 @@ builtin_builder::release()
 {
    ralloc_free(mem_ctx);
    mem_ctx = NULL;
+   names = NULL;
 
    ralloc_free(shader);
    shader = NULL;
@@ -1200,6 +1256,13 @@ builtin_builder::create_intrinsics()
 void
 builtin_builder::create_builtins()
 {
+   /* Skip building the signatures of functions which weren't asked for. */
+#define add_function(NAME, ...)                 \
+   do {                                         \
+      if (want_function(NAME))                  \
+         add_function(NAME, __VA_ARGS__);       \
+   } while (0)
+
 #define F(NAME)                                 \
    add_function(#NAME,                          \
                 _##NAME(glsl_type::float_type), \
@@ -3196,6 +3259,7 @@ builtin_builder::create_builtins()
                 generate_ir::umul64(mem_ctx, integer_functions_supported),
                 NULL);
 
+#undef add_function
 #undef F
 #undef FI
 #undef FIUD_VEC
@@ -3203,6 +3267,18 @@ builtin_builder::create_builtins()
 #undef FIU2_MIXED
 }
 
+bool
+builtin_builder::want_function(const char *name)
+{
+   if (collect_names) {
+      _mesa_set_add(names, name);
+      return false;
+   }
+
+   return requested_function == NULL ||
+          strcmp(name, requested_function) == 0;
+}
+
 void
 builtin_builder::add_function(const char *name, ...)
 {
@@ -3273,6 +3349,9 @@ builtin_builder::add_image_function(const char *name,
       glsl_type::uimage2DMSArray_type
    };
 
+   if (!want_function(name))
+      return;
+
    ir_function *f = new(mem_ctx) ir_function(name);
 
    for (unsigned i = 0; i < ARRAY_SIZE(types); ++i) {
@@ -6122,13 +6201,30 @@ _mesa_glsl_find_builtin_function(_mesa_glsl_parse_state *state,
 
 bool
 _mesa_glsl_has_builtin_function(const char *name)
+{
+   bool ret;
+   mtx_lock(&builtins_lock);
+   ret = builtins.has_function(name);
+   mtx_unlock(&builtins_lock);
+
+   return ret;
+}
+
+/**
+ * Look up a built-in function by name, without matching any signature.
+ *
+ * Built-ins are added to the shared built-in shader while other threads
+ * compile, so its symbol table must not be accessed without the lock.
+ */
+ir_function *
+_mesa_glsl_find_builtin_function_by_name(const char *name)
 {
    ir_function *f;
    mtx_lock(&builtins_lock);
-   f = builtins.shader->symbols->get_function(name);
+   f = builtins.lookup_function(name);
    mtx_unlock(&builtins_lock);
 
-   return f != NULL;
+   return f;
 }
 
 gl_shader *
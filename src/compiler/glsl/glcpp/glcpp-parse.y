@@ -209,7 +209,7 @@ line:
 |	SPACE control_line
 |	text_line {
 		_glcpp_parser_print_expanded_token_list (parser, $1);
-		ralloc_asprintf_rewrite_tail (&parser->output, &parser->output_length, "\n");
+		glcpp_strbuf_append (&parser->output, &parser->output_length, "\n", 1);
 	}
 |	expanded_line
 ;
@@ -228,9 +228,9 @@ expanded_line:
 |	LINE_EXPANDED integer_constant NEWLINE {
 		parser->has_new_line_number = 1;
 		parser->new_line_number = $2;
-		ralloc_asprintf_rewrite_tail (&parser->output,
-					      &parser->output_length,
-					      "#line %" PRIiMAX "\n",
+		glcpp_strbuf_printf (&parser->output,
+				     &parser->output_length,
+				     "#line %" PRIiMAX "\n",
 					      $2);
 	}
 |	LINE_EXPANDED integer_constant integer_constant NEWLINE {
@@ -238,9 +238,9 @@ expanded_line:
 		parser->new_line_number = $2;
 		parser->has_new_source_number = 1;
 		parser->new_source_number = $3;
-		ralloc_asprintf_rewrite_tail (&parser->output,
-					      &parser->output_length,
-					      "#line %" PRIiMAX " %" PRIiMAX "\n",
+		glcpp_strbuf_printf (&parser->output,
+				     &parser->output_length,
+				     "#line %" PRIiMAX " %" PRIiMAX "\n",
 					      $2, $3);
 	}
 ;
@@ -259,7 +259,7 @@ define:
 
 control_line:
 	control_line_success {
-		ralloc_asprintf_rewrite_tail (&parser->output, &parser->output_length, "\n");
+		glcpp_strbuf_append (&parser->output, &parser->output_length, "\n", 1);
 	}
 |	control_line_error
 |	HASH_TOKEN LINE pp_tokens NEWLINE {
@@ -435,7 +435,7 @@ control_line_success:
 		glcpp_parser_resolve_implicit_version(parser);
 	}
 |	HASH_TOKEN PRAGMA NEWLINE {
-		ralloc_asprintf_rewrite_tail (&parser->output, &parser->output_length, "#%s", $2);
+		glcpp_strbuf_printf (&parser->output, &parser->output_length, "#%s", $2);
 	}
 ;
 
@@ -1115,67 +1115,71 @@ _token_list_equal_ignoring_space(token_list_t *a, token_list_t *b)
 static void
 _token_print(char **out, size_t *len, token_t *token)
 {
+   const char *str;
+
    if (token->type < 256) {
-      ralloc_asprintf_rewrite_tail (out, len, "%c", token->type);
+      char c = token->type;
+      glcpp_strbuf_append (out, len, &c, 1);
       return;
    }
 
    switch (token->type) {
    case INTEGER:
-      ralloc_asprintf_rewrite_tail (out, len, "%" PRIiMAX, token->value.ival);
-      break;
+      glcpp_strbuf_printf (out, len, "%" PRIiMAX, token->value.ival);
+      return;
    case IDENTIFIER:
    case INTEGER_STRING:
    case OTHER:
-      ralloc_asprintf_rewrite_tail (out, len, "%s", token->value.str);
+      str = token->value.str;
       break;
    case SPACE:
-      ralloc_asprintf_rewrite_tail (out, len, " ");
+      str = " ";
       break;
    case LEFT_SHIFT:
-      ralloc_asprintf_rewrite_tail (out, len, "<<");
+      str = "<<";
       break;
    case RIGHT_SHIFT:
-      ralloc_asprintf_rewrite_tail (out, len, ">>");
+      str = ">>";
       break;
    case LESS_OR_EQUAL:
-      ralloc_asprintf_rewrite_tail (out, len, "<=");
+      str = "<=";
       break;
    case GREATER_OR_EQUAL:
-      ralloc_asprintf_rewrite_tail (out, len, ">=");
+      str = ">=";
       break;
    case EQUAL:
-      ralloc_asprintf_rewrite_tail (out, len, "==");
+      str = "==";
       break;
    case NOT_EQUAL:
-      ralloc_asprintf_rewrite_tail (out, len, "!=");
+      str = "!=";
       break;
    case AND:
-      ralloc_asprintf_rewrite_tail (out, len, "&&");
+      str = "&&";
       break;
    case OR:
-      ralloc_asprintf_rewrite_tail (out, len, "||");
+      str = "||";
       break;
    case PASTE:
-      ralloc_asprintf_rewrite_tail (out, len, "##");
+      str = "##";
       break;
    case PLUS_PLUS:
-      ralloc_asprintf_rewrite_tail (out, len, "++");
+      str = "++";
       break;
    case MINUS_MINUS:
-      ralloc_asprintf_rewrite_tail (out, len, "--");
+      str = "--";
       break;
    case DEFINED:
-      ralloc_asprintf_rewrite_tail (out, len, "defined");
+      str = "defined";
       break;
    case PLACEHOLDER:
       /* Nothing to print. */
-      break;
+      return;
    default:
       assert(!"Error: Don't know how to print token.");
-
-      break;
+      return;
    }
+
+   glcpp_strbuf_append (out, len, str, strlen(str));
 }
 
 /* Return a new token formed by pasting 'token' and 'other'. Note that this
@@ -1293,11 +1297,11 @@ _token_paste(glcpp_parser_t *parser, token_t *token, token_t *other)
 
     FAIL:
    glcpp_error (&token->location, parser, "");
-   ralloc_asprintf_rewrite_tail (&parser->info_log, &parser->info_log_length, "Pasting \"");
+   glcpp_strbuf_printf (&parser->info_log, &parser->info_log_length, "Pasting \"");
    _token_print (&parser->info_log, &parser->info_log_length, token);
-   ralloc_asprintf_rewrite_tail (&parser->info_log, &parser->info_log_length, "\" and \"");
+   glcpp_strbuf_printf (&parser->info_log, &parser->info_log_length, "\" and \"");
    _token_print (&parser->info_log, &parser->info_log_length, other);
-   ralloc_asprintf_rewrite_tail (&parser->info_log, &parser->info_log_length, "\" does not give a valid preprocessing token.\n");
+   glcpp_strbuf_printf (&parser->info_log, &parser->info_log_length, "\" does not give a valid preprocessing token.\n");
 
    return token;
 }
@@ -1363,9 +1367,9 @@ glcpp_parser_create(const struct gl_extensions *extension_list,
    parser->lex_from_list = NULL;
    parser->lex_from_node = NULL;
 
-   parser->output = ralloc_strdup(parser, "");
+   parser->output = glcpp_strbuf_create(parser);
    parser->output_length = 0;
-   parser->info_log = ralloc_strdup(parser, "");
+   parser->info_log = glcpp_strbuf_create(parser);
    parser->info_log_length = 0;
    parser->error = 0;
 
@@ -2353,10 +2357,10 @@ _glcpp_parser_handle_version_declaration(glcpp_parser_t *parser, intmax_t versio
    }
 
    if (explicitly_set) {
-      ralloc_asprintf_rewrite_tail(&parser->output, &parser->output_length,
-                                   "#version %" PRIiMAX "%s%s", version,
-                                   es_identifier ? " " : "",
-                                   es_identifier ? es_identifier : "");
+      glcpp_strbuf_printf(&parser->output, &parser->output_length,
+                          "#version %" PRIiMAX "%s%s", version,
+                          es_identifier ? " " : "",
+                          es_identifier ? es_identifier : "");
    }
 }
 
@@ -106,6 +106,63 @@ init_fake_gl_context (struct gl_context *gl_ctx)
 	gl_ctx->Const.DisableGLSLLineContinuations = false;
 }
 
+/* Reduce preprocessed text to what the GLSL lexer cares about: runs of
+ * spaces and tabs become a single space, spaces at the start or end of a
+ * line and "//" comments are dropped (glcpp passes those through on
+ * #extension and #pragma lines, and the GLSL lexer ignores them), and so
+ * are newlines at the end.  Newlines elsewhere are kept, since they make
+ * up the line numbers in error messages.
+ */
+static char *
+normalize_output (void *ctx, const char *str)
+{
+	char *out = ralloc_size (ctx, strlen (str) + 1);
+	char *dst = out;
+	bool space = false;
+
+	for (; *str; str++) {
+		if (*str == ' ' || *str == '\t') {
+			space = true;
+		} else if (str[0] == '/' && str[1] == '/') {
+			while (str[1] && str[1] != '\n')
+				str++;
+		} else {
+			if (space && *str != '\n' && dst > out && dst[-1] != '\n')
+				*dst++ = ' ';
+			space = false;
+			*dst++ = *str;
+		}
+	}
+
+	while (dst > out && dst[-1] == '\n')
+		dst--;
+	*dst = '\0';
+
+	return out;
+}
+
+/* Compare the output of glcpp_preprocess_trivial with that of the full
+ * preprocessor.
+ *
+ * Returns the number of the first line that differs, or 0 if none does.
+ */
+static int
+compare_trivial (void *ctx, const char *trivial, const char *full)
+{
+	const char *a = normalize_output (ctx, trivial);
+	const char *b = normalize_output (ctx, full);
+	int line = 1;
+
+	for (; *a == *b; a++, b++) {
+		if (*a == '\0')
+			return 0;
+		if (*a == '\n')
+			line++;
+	}
+
+	return line;
+}
+
 static void
 usage (void)
 {
@@ -115,16 +172,21 @@ usage (void)
 		 "Pre-process the given filename (stdin if no filename given).\n"
 		 "The following options are supported:\n"
 		 "    --disable-line-continuations      Do not interpret lines ending with a\n"
-		 "                                      backslash ('\\') as a line continuation.\n");
+		 "                                      backslash ('\\') as a line continuation.\n"
+		 "    --check-trivial                   If the compiler would skip the\n"
+		 "                                      preprocessor for this input, check\n"
+		 "                                      that doing so gives the same tokens.\n");
 }
 
 enum {
-	DISABLE_LINE_CONTINUATIONS_OPT = CHAR_MAX + 1
+	DISABLE_LINE_CONTINUATIONS_OPT = CHAR_MAX + 1,
+	CHECK_TRIVIAL_OPT
 };
 
 static const struct option
 long_options[] = {
 	{"disable-line-continuations", no_argument, 0, DISABLE_LINE_CONTINUATIONS_OPT },
+	{"check-trivial",              no_argument, 0, CHECK_TRIVIAL_OPT },
         {"debug",                      no_argument, 0, 'd'},
 	{0,                            0,           0, 0 }
 };
@@ -135,7 +197,8 @@ main (int argc, char *argv[])
 	char *filename = NULL;
 	void *ctx = ralloc(NULL, void*);
 	char *info_log = ralloc_strdup(ctx, "");
-	const char *shader;
+	const char *shader, *trivial;
+	bool check_trivial = false;
 	int ret;
 	struct gl_context gl_ctx;
 	int c;
@@ -147,6 +210,9 @@ main (int argc, char *argv[])
 		case DISABLE_LINE_CONTINUATIONS_OPT:
 			gl_ctx.Const.DisableGLSLLineContinuations = true;
 			break;
+		case CHECK_TRIVIAL_OPT:
+			check_trivial = true;
+			break;
                 case 'd':
 			glcpp_parser_debug = 1;
 			break;
@@ -171,11 +237,25 @@ main (int argc, char *argv[])
 
 	_mesa_locale_init();
 
+	trivial = shader;
+	if (check_trivial && !glcpp_preprocess_trivial(ctx, &trivial))
+		check_trivial = false;
+
 	ret = glcpp_preprocess(ctx, &shader, &info_log, NULL, NULL, &gl_ctx);
 
 	printf("%s", shader);
 	fprintf(stderr, "%s", info_log);
 
+	if (check_trivial && ret == 0) {
+		int line = compare_trivial(ctx, trivial, shader);
+
+		if (line) {
+			fprintf(stderr, "glcpp: skipping the preprocessor "
+				"changes line %d\n", line);
+			ret = 1;
+		}
+	}
+
 	ralloc_free(ctx);
 
 	return ret;
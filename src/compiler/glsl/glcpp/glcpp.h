@@ -243,6 +243,24 @@ glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
 		 glcpp_extension_iterator extensions, void *state,
 		 struct gl_context *g_ctx);
 
+bool
+glcpp_preprocess_trivial(void *ralloc_ctx, const char **shader);
+
+/* Functions for appending to the output and the info log */
+
+char *
+glcpp_strbuf_create(void *ctx);
+
+void
+glcpp_strbuf_append(char **str, size_t *length, const char *src, size_t n);
+
+void
+glcpp_strbuf_vprintf(char **str, size_t *length, const char *fmt, va_list ap);
+
+void
+glcpp_strbuf_printf(char **str, size_t *length, const char *fmt, ...)
+	PRINTFLIKE(3, 4);
+
 /* Functions for writing to the info log */
 
 void
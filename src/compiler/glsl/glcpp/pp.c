@@ -26,26 +26,94 @@
 #include <ctype.h>
 #include "glcpp.h"
 
+/* The output and the info log are built up a token at a time.  Instead of
+ * resizing them to the exact length on every append, as
+ * ralloc_asprintf_rewrite_tail does, they are grown to the next power of
+ * two, so that the allocated size can be worked out from the length alone.
+ * That only holds if every write to them goes through these functions.
+ */
+static size_t
+strbuf_size(size_t length)
+{
+	size_t size = 64;
+
+	while (size < length + 1)
+		size *= 2;
+
+	return size;
+}
+
+char *
+glcpp_strbuf_create(void *ctx)
+{
+	char *str = ralloc_size(ctx, strbuf_size(0));
+
+	if (str)
+		str[0] = '\0';
+
+	return str;
+}
+
+void
+glcpp_strbuf_append(char **str, size_t *length, const char *src, size_t n)
+{
+	size_t size = strbuf_size(*length + n);
+
+	if (size != strbuf_size(*length)) {
+		char *ptr = reralloc_size(ralloc_parent(*str), *str, size);
+
+		if (unlikely(ptr == NULL))
+			return;
+		*str = ptr;
+	}
+
+	memcpy(*str + *length, src, n);
+	*length += n;
+	(*str)[*length] = '\0';
+}
+
+void
+glcpp_strbuf_vprintf(char **str, size_t *length, const char *fmt, va_list ap)
+{
+	char *tmp = ralloc_vasprintf(NULL, fmt, ap);
+
+	if (unlikely(tmp == NULL))
+		return;
+
+	glcpp_strbuf_append(str, length, tmp, strlen(tmp));
+	ralloc_free(tmp);
+}
+
+void
+glcpp_strbuf_printf(char **str, size_t *length, const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	glcpp_strbuf_vprintf(str, length, fmt, ap);
+	va_end(ap);
+}
+
 void
 glcpp_error (YYLTYPE *locp, glcpp_parser_t *parser, const char *fmt, ...)
 {
 	va_list ap;
 
 	parser->error = 1;
-	ralloc_asprintf_rewrite_tail(&parser->info_log,
-				     &parser->info_log_length,
-				     "%u:%u(%u): "
-				     "preprocessor error: ",
-				     locp->source,
-				     locp->first_line,
-				     locp->first_column);
+	glcpp_strbuf_printf(&parser->info_log,
+			    &parser->info_log_length,
+			    "%u:%u(%u): "
+			    "preprocessor error: ",
+			    locp->source,
+			    locp->first_line,
+			    locp->first_column);
 	va_start(ap, fmt);
-	ralloc_vasprintf_rewrite_tail(&parser->info_log,
-				      &parser->info_log_length,
-				      fmt, ap);
+	glcpp_strbuf_vprintf(&parser->info_log,
+			     &parser->info_log_length,
+			     fmt, ap);
 	va_end(ap);
-	ralloc_asprintf_rewrite_tail(&parser->info_log,
-				     &parser->info_log_length, "\n");
+	glcpp_strbuf_printf(&parser->info_log,
+			    &parser->info_log_length, "\n");
 }
 
 void
@@ -53,20 +121,20 @@ glcpp_warning (YYLTYPE *locp, glcpp_parser_t *parser, const char *fmt, ...)
 {
 	va_list ap;
 
-	ralloc_asprintf_rewrite_tail(&parser->info_log,
-				     &parser->info_log_length,
-				     "%u:%u(%u): "
-				     "preprocessor warning: ",
-				     locp->source,
-				     locp->first_line,
-				     locp->first_column);
+	glcpp_strbuf_printf(&parser->info_log,
+			    &parser->info_log_length,
+			    "%u:%u(%u): "
+			    "preprocessor warning: ",
+			    locp->source,
+			    locp->first_line,
+			    locp->first_column);
 	va_start(ap, fmt);
-	ralloc_vasprintf_rewrite_tail(&parser->info_log,
-				      &parser->info_log_length,
-				      fmt, ap);
+	glcpp_strbuf_vprintf(&parser->info_log,
+			     &parser->info_log_length,
+			     fmt, ap);
 	va_end(ap);
-	ralloc_asprintf_rewrite_tail(&parser->info_log,
-				     &parser->info_log_length, "\n");
+	glcpp_strbuf_printf(&parser->info_log,
+			    &parser->info_log_length, "\n");
 }
 
 /* Given str, (that's expected to start with a newline terminator of some
@@ -241,3 +309,195 @@ glcpp_preprocess(void *ralloc_ctx, const char **shader, char **info_log,
 	glcpp_parser_destroy (parser);
 	return errors;
 }
+
+/* Is str the start of a word that the preprocessor may have to expand?
+ *
+ * Without any #define in the shader the only macros are the predefined
+ * ones, which all either begin with "GL_" or contain "__".
+ */
+static bool
+word_may_be_macro(const char *str, size_t len)
+{
+	size_t i;
+
+	if (len >= 3 && strncmp(str, "GL_", 3) == 0)
+		return true;
+
+	for (i = 0; i + 1 < len; i++) {
+		if (str[i] == '_' && str[i + 1] == '_')
+			return true;
+	}
+
+	return false;
+}
+
+static bool
+is_word_char(char c)
+{
+	return isalnum((unsigned char) c) || c == '_';
+}
+
+/* Skip the preprocessor for shaders that could not be changed by it.
+ *
+ * A shader qualifies when its only directives are #version (before any
+ * other text), #extension and #pragma, it has no line continuations and
+ * it does not refer to any predefined macro.  The GLSL lexer handles
+ * those three directives itself, so all that is left to do is to blank
+ * out comments while keeping every newline, which keeps line numbers in
+ * error messages the same as with the full preprocessor.
+ *
+ * Returns true and replaces *shader with the stripped copy (allocated
+ * from ralloc_ctx) on success, or returns false and leaves *shader alone
+ * if glcpp_preprocess has to be used.
+ */
+bool
+glcpp_preprocess_trivial(void *ralloc_ctx, const char **shader)
+{
+	const char *src = *shader;
+	size_t len = strlen(src);
+	bool seen_text = false;
+	bool line_start = true;
+	char *out, *dst;
+	size_t i = 0;
+
+	/* Check everything before copying, so that shaders that need the
+	 * preprocessor do not pay for an extra allocation.  Line
+	 * continuations, carriage returns and the whitespace characters that
+	 * only glcpp knows about are left to the full preprocessor.
+	 */
+	if (strpbrk(src, "\\\r\v\f") != NULL)
+		return false;
+
+	while (i < len) {
+		char c = src[i];
+
+		if (c == '\n') {
+			line_start = true;
+			i++;
+			continue;
+		}
+
+		if (c == ' ' || c == '\t') {
+			i++;
+			continue;
+		}
+
+		if (c == '#') {
+			const char *name;
+			size_t name_len;
+
+			if (!line_start)
+				return false;
+
+			i++;
+			while (src[i] == ' ' || src[i] == '\t')
+				i++;
+
+			name = src + i;
+			while (is_word_char(src[i]))
+				i++;
+			name_len = src + i - name;
+
+			if (name_len == 7 && strncmp(name, "version", 7) == 0) {
+				if (seen_text)
+					return false;
+			} else if (name_len == 6 &&
+				   strncmp(name, "pragma", 6) == 0) {
+				/* glcpp swallows a #pragma without
+				 * arguments, but the GLSL lexer only knows
+				 * the ones followed by something.
+				 */
+				size_t j = i;
+
+				while (src[j] == ' ' || src[j] == '\t')
+					j++;
+				if (src[j] == '\n' || src[j] == '\0')
+					return false;
+			} else if (!(name_len == 9 &&
+				     strncmp(name, "extension", 9) == 0)) {
+				return false;
+			}
+
+			/* The rest of the line goes to the GLSL lexer as is. */
+			while (i < len && src[i] != '\n') {
+				if (src[i] == '/' && src[i + 1] == '*')
+					return false;
+				i++;
+			}
+
+			seen_text = true;
+			continue;
+		}
+
+		line_start = false;
+
+		if (c == '/' && src[i + 1] == '/') {
+			while (i < len && src[i] != '\n')
+				i++;
+			continue;
+		}
+
+		if (c == '/' && src[i + 1] == '*') {
+			const char *end = strstr(src + i + 2, "*/");
+
+			if (end == NULL)
+				return false;
+			i = end + 2 - src;
+			continue;
+		}
+
+		seen_text = true;
+
+		if (is_word_char(c)) {
+			size_t start = i;
+
+			while (is_word_char(src[i]))
+				i++;
+			if (word_may_be_macro(src + start, i - start))
+				return false;
+			continue;
+		}
+
+		i++;
+	}
+
+	out = ralloc_size(ralloc_ctx, len + 1);
+	if (out == NULL)
+		return false;
+
+	memcpy(out, src, len + 1);
+
+	/* Blank out the comments.  Comment openers inside directives were
+	 * rejected above, so only text lines have to be considered here.
+	 */
+	dst = out;
+	line_start = true;
+	while (*dst) {
+		if (*dst == '\n') {
+			line_start = true;
+			dst++;
+		} else if (*dst == ' ' || *dst == '\t') {
+			dst++;
+		} else if (*dst == '#' && line_start) {
+			while (*dst && *dst != '\n')
+				dst++;
+		} else if (dst[0] == '/' && dst[1] == '/') {
+			while (*dst && *dst != '\n')
+				*dst++ = ' ';
+		} else if (dst[0] == '/' && dst[1] == '*') {
+			char *end = strstr(dst + 2, "*/") + 2;
+
+			for (; dst < end; dst++) {
+				if (*dst != '\n')
+					*dst = ' ';
+			}
+			line_start = false;
+		} else {
+			line_start = false;
+			dst++;
+		}
+	}
+
+	*shader = out;
+	return true;
+}
@@ -0,0 +1,10 @@
+#version 130
+/* The compiler does not run shaders like this one through the
+ * preprocessor. */
+#extension GL_ARB_explicit_attrib_location : enable
+ #pragma optimize(off)
+uniform vec4 color;// a comment
+void main()
+{
+	gl_FragColor = color/**/* 2.0;
+}
@@ -90,6 +90,23 @@ if [ $total -eq 0 ]; then
     exit 1
 fi
 
+echo ""
+echo "====== Testing the trivial path ======"
+for test in $testdir/*.c; do
+    out=$outdir/${test##*/}.trivial.out
+
+    printf "Testing `basename $test` with --check-trivial... "
+    $glcpp --check-trivial $(test_specific_args $test) < $test > /dev/null 2>$out
+    total=$((total+1))
+    if grep -q '^glcpp: skipping the preprocessor' $out; then
+	echo "FAIL"
+	cat $out
+    else
+	echo "PASS"
+	pass=$((pass+1))
+    fi
+done
+
 echo ""
 echo "$pass/$total tests returned correct results"
 echo ""
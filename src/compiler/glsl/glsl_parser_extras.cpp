@@ -32,6 +32,7 @@
 #include "main/formats.h"
 #include "main/shaderobj.h"
 #include "util/u_atomic.h" /* for p_atomic_cmpxchg */
+#include "util/u_thread.h"
 #include "util/ralloc.h"
 #include "util/disk_cache.h"
 #include "util/mesa-sha1.h"
@@ -1922,9 +1923,24 @@ do_late_parsing_checks(struct _mesa_glsl_parse_state *state)
    }
 }
 
+/**
+ * Copy the live IR of \c shader out of the compile arena into memory owned
+ * by \c shader->ir.  Everything left behind in the arena is garbage and is
+ * freed in one go with it.
+ */
+static void
+retain_ir_from_arena(struct gl_shader *shader)
+{
+   exec_list arena_ir;
+
+   shader->ir->move_nodes_to(&arena_ir);
+   clone_ir_list(shader->ir, shader->ir, &arena_ir);
+}
+
 static void
 opt_shader_and_create_symbol_table(struct gl_context *ctx,
-                                   struct gl_shader *shader)
+                                   struct gl_shader *shader,
+                                   bool ir_in_arena)
 {
    assert(shader->CompileStatus != compile_failure &&
           !shader->ir->is_empty());
@@ -1941,8 +1957,9 @@ opt_shader_and_create_symbol_table(struct gl_context *ctx,
                              ctx->Const.NativeIntegers);
    } else {
       /* Repeat it until it stops making changes. */
+      opt_pass_tracker tracker;
       while (do_common_optimization(shader->ir, false, false, options,
-                                    ctx->Const.NativeIntegers))
+                                    ctx->Const.NativeIntegers, &tracker))
          ;
    }
 
@@ -1969,7 +1986,10 @@ opt_shader_and_create_symbol_table(struct gl_context *ctx,
    validate_ir_tree(shader->ir);
 
    /* Retain any live IR, but trash the rest. */
-   reparent_ir(shader->ir, shader->ir);
+   if (ir_in_arena)
+      retain_ir_from_arena(shader);
+   else
+      reparent_ir(shader->ir, shader->ir);
 
    /* Destroy the symbol table.  Create a new symbol table that contains only
     * the variables and functions that still exist in the IR.  The symbol
@@ -2008,6 +2028,12 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
    const char *source = force_recompile && shader->FallbackSource ?
       shader->FallbackSource : shader->Source;
 
+   /* This may run on a compiler thread while the application rebinds
+    * ctx->_Shader.  The flags all come from MESA_GLSL, so use the copy in
+    * the context's default pipeline, which is set once at context creation.
+    */
+   const GLbitfield flags = ctx->Shader.Flags;
+
    if (!force_recompile) {
       if (ctx->Cache) {
          char buf[41];
@@ -2015,7 +2041,7 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
                                 shader->sha1);
          if (disk_cache_has_key(ctx->Cache, shader->sha1)) {
             /* We've seen this shader before and know it compiles */
-            if (ctx->_Shader->Flags & GLSL_CACHE_INFO) {
+            if (flags & GLSL_CACHE_INFO) {
                _mesa_sha1_format(buf, shader->sha1);
                fprintf(stderr, "deferring compile of shader: %s\n", buf);
             }
@@ -2035,21 +2061,30 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
          return;
 
       if (shader->CompileStatus == compiled_no_opts) {
-         opt_shader_and_create_symbol_table(ctx, shader);
+         opt_shader_and_create_symbol_table(ctx, shader, false);
          shader->CompileStatus = compile_success;
          return;
       }
    }
 
+   /* The parse state, the AST and all of the IR built and thrown away by
+    * the compile live in an arena.  Only the final IR is copied out of it.
+    */
+   void *arena = ralloc_arena_context(shader);
    struct _mesa_glsl_parse_state *state =
-      new(shader) _mesa_glsl_parse_state(ctx, shader->Stage, shader);
+      new(arena) _mesa_glsl_parse_state(ctx, shader->Stage, shader);
 
    if (ctx->Const.GenerateTemporaryNames)
       (void) p_atomic_cmpxchg(&ir_variable::temporaries_allocate_names,
                               false, true);
 
-   state->error = glcpp_preprocess(state, &source, &state->info_log,
-                                   add_builtin_defines, state, ctx);
+   /* Most shaders only use #version and #extension, in which case there is
+    * nothing for the preprocessor to do.
+    */
+   if (!glcpp_preprocess_trivial(state, &source)) {
+      state->error = glcpp_preprocess(state, &source, &state->info_log,
+                                      add_builtin_defines, state, ctx);
+   }
 
    if (!state->error) {
      _mesa_glsl_lexer_ctor(state, source);
@@ -2096,11 +2131,14 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
       lower_subroutine(shader->ir, state);
 
       if (!ctx->Cache || force_recompile)
-         opt_shader_and_create_symbol_table(ctx, shader);
+         opt_shader_and_create_symbol_table(ctx, shader, true);
       else {
-         reparent_ir(shader->ir, shader->ir);
+         retain_ir_from_arena(shader);
          shader->CompileStatus = compiled_no_opts;
       }
+   } else {
+      /* Nothing in the arena survives a failed compile. */
+      shader->ir->make_empty();
    }
 
    if (!force_recompile) {
@@ -2108,11 +2146,107 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
       shader->FallbackSource = NULL;
    }
 
+   if (flags & GLSL_MEM_INFO) {
+      fprintf(stderr, "GLSL %s shader %u: %u bytes of compile memory\n",
+              _mesa_shader_stage_to_string(shader->Stage), shader->Name,
+              (unsigned) ralloc_arena_size(arena));
+   }
+
    delete state->symbols;
-   ralloc_free(state);
+   ralloc_free(arena);
 }
 
 } /* extern "C" */
+
+opt_pass_tracker::opt_pass_tracker()
+   : num_passes(0), current(NULL), start_ns(0), generation(0), rounds(0)
+{
+   static int opt_stats = -1;
+
+   if (opt_stats < 0) {
+      const char *env = getenv("MESA_GLSL");
+      opt_stats = env && strstr(env, "opt_stats");
+   }
+   print_stats = opt_stats;
+}
+
+opt_pass_tracker::~opt_pass_tracker()
+{
+   if (!print_stats || num_passes == 0)
+      return;
+
+   int64_t total_ns = 0;
+   for (unsigned i = 0; i < num_passes; i++)
+      total_ns += passes[i].time_ns;
+
+   fprintf(stderr, "GLSL optimization: %u rounds, %.3f ms\n",
+           rounds, total_ns / 1000000.0);
+   fprintf(stderr, "  %-32s %6s %6s %8s %10s\n",
+           "pass", "runs", "skips", "progress", "time (us)");
+   for (unsigned i = 0; i < num_passes; i++) {
+      const pass_info *p = &passes[i];
+      fprintf(stderr, "  %-32s %6u %6u %8u %10.1f\n", p->name, p->runs,
+              p->skips, p->progress, p->time_ns / 1000.0);
+   }
+}
+
+bool
+opt_pass_tracker::begin_pass(const char *name)
+{
+   pass_info *p = NULL;
+
+   assert(current == NULL);
+
+   for (unsigned i = 0; i < num_passes; i++) {
+      if (passes[i].name == name) {
+         p = &passes[i];
+         break;
+      }
+   }
+
+   if (p == NULL && num_passes < ARRAY_SIZE(passes)) {
+      p = &passes[num_passes++];
+      memset(p, 0, sizeof(*p));
+      p->name = name;
+   }
+
+   /* Out of slots, just run the pass every time. */
+   if (p == NULL)
+      return true;
+
+   if (p->clean && p->generation == generation) {
+      p->skips++;
+      return false;
+   }
+
+   current = p;
+   if (print_stats)
+      start_ns = u_thread_get_time_nano(thrd_current());
+   return true;
+}
+
+void
+opt_pass_tracker::end_pass(bool progress)
+{
+   pass_info *p = current;
+
+   if (p == NULL)
+      return;
+
+   if (print_stats)
+      p->time_ns += u_thread_get_time_nano(thrd_current()) - start_ns;
+
+   if (progress) {
+      generation++;
+      p->progress++;
+   }
+
+   p->runs++;
+   p->clean = !progress;
+   p->generation = generation;
+   current = NULL;
+}
+
 /**
  * Do the set of common optimizations passes
  *
@@ -2131,27 +2265,43 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
  *                                    implementations supporting integers
  *                                    natively (as opposed to supporting
  *                                    integers in floating point registers).
+ * \param tracker                     Passes state between the calls of an
+ *                                    optimization loop, so that passes which
+ *                                    can't make progress are skipped.  May be
+ *                                    NULL.
  */
 bool
 do_common_optimization(exec_list *ir, bool linked,
 		       bool uniform_locations_assigned,
                        const struct gl_shader_compiler_options *options,
-                       bool native_integers)
+                       bool native_integers,
+                       opt_pass_tracker *tracker)
 {
    const bool debug = false;
    GLboolean progress = GL_FALSE;
+   opt_pass_tracker local_tracker;
+
+   if (tracker == NULL)
+      tracker = &local_tracker;
+
+   tracker->begin_round();
 
 #define OPT(PASS, ...) do {                                             \
+      if (!tracker->begin_pass(#PASS))                                  \
+         break;                                                         \
       if (debug) {                                                      \
          fprintf(stderr, "START GLSL optimization %s\n", #PASS);        \
          const bool opt_progress = PASS(__VA_ARGS__);                   \
+         tracker->end_pass(opt_progress);                               \
          progress = opt_progress || progress;                           \
          if (opt_progress)                                              \
             _mesa_print_ir(stderr, ir, NULL);                           \
          fprintf(stderr, "GLSL optimization %s: %s progress\n",         \
                  #PASS, opt_progress ? "made" : "no");                  \
       } else {                                                          \
-         progress = PASS(__VA_ARGS__) || progress;                      \
+         const bool opt_progress = PASS(__VA_ARGS__);                   \
+         tracker->end_pass(opt_progress);                               \
+         progress = opt_progress || progress;                           \
       }                                                                 \
    } while (false)
 
@@ -2162,7 +2312,15 @@ do_common_optimization(exec_list *ir, bool linked,
       OPT(do_dead_functions, ir);
       OPT(do_structure_splitting, ir);
    }
-   propagate_invariance(ir);
+
+   /* This only marks variables invariant, so it never counts as progress,
+    * but it has to see any IR the other passes changed.
+    */
+   if (tracker->begin_pass("propagate_invariance")) {
+      propagate_invariance(ir);
+      tracker->end_pass(false);
+   }
+
    OPT(do_if_simplification, ir);
    OPT(opt_flatten_nested_if_blocks, ir);
    OPT(opt_conditional_discard, ir);
@@ -2201,13 +2359,20 @@ do_common_optimization(exec_list *ir, bool linked,
    OPT(optimize_split_arrays, ir, linked);
    OPT(optimize_redundant_jumps, ir);
 
-   if (options->MaxUnrollIterations) {
+   /* The loop analysis is only worth redoing if the IR changed since the
+    * loop passes last ran without making progress.
+    */
+   if (options->MaxUnrollIterations &&
+       tracker->begin_pass("analyze_loop_variables")) {
+      bool loop_progress = false;
       loop_state *ls = analyze_loop_variables(ir);
       if (ls->loop_found) {
-         OPT(set_loop_controls, ir, ls);
-         OPT(unroll_loops, ir, ls, options);
+         loop_progress = set_loop_controls(ir, ls);
+         loop_progress = unroll_loops(ir, ls, options) || loop_progress;
       }
       delete ls;
+      tracker->end_pass(loop_progress);
+      progress = loop_progress || progress;
    }
 
 #undef OPT
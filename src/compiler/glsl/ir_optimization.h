@@ -30,6 +30,8 @@
 #ifndef GLSL_IR_OPTIMIZATION_H
 #define GLSL_IR_OPTIMIZATION_H
 
+#include <stdint.h>
+
 /* Operations for lower_instructions() */
 #define SUB_TO_ADD_NEG     0x01
 #define FDIV_TO_MUL_RCP    0x02
@@ -86,10 +88,70 @@ enum lower_packing_builtins_op {
    LOWER_PACK_USE_BFE                   = 0x0800,
 };
 
+/**
+ * Bookkeeping for running do_common_optimization() repeatedly on one IR
+ * tree until it stops making progress.
+ *
+ * Every pass remembers the IR generation it last ran on and whether it made
+ * progress then.  A pass that made no progress is skipped until another pass
+ * changes the IR, because running it again on the same IR can't do anything.
+ * Code that modifies the IR between two do_common_optimization() calls
+ * sharing a tracker has to call invalidate().
+ *
+ * With MESA_GLSL=opt_stats, the number of times each pass ran, was skipped
+ * and made progress, along with the time spent in it, is printed to stderr
+ * when the tracker is destroyed.
+ */
+class opt_pass_tracker {
+public:
+   opt_pass_tracker();
+   ~opt_pass_tracker();
+
+   /** The IR was changed by code outside of the tracked passes. */
+   void invalidate()
+   {
+      generation++;
+   }
+
+   void begin_round()
+   {
+      rounds++;
+   }
+
+   /**
+    * Returns false if the pass named \c name can be skipped.  Otherwise it
+    * has to be followed by a call to end_pass() once the pass has run.
+    */
+   bool begin_pass(const char *name);
+   void end_pass(bool progress);
+
+private:
+   struct pass_info {
+      const char *name;
+      unsigned generation;
+      bool clean;
+
+      unsigned runs;
+      unsigned skips;
+      unsigned progress;
+      int64_t time_ns;
+   };
+
+   pass_info passes[48];
+   unsigned num_passes;
+   pass_info *current;
+   int64_t start_ns;
+
+   unsigned generation;
+   unsigned rounds;
+   bool print_stats;
+};
+
 bool do_common_optimization(exec_list *ir, bool linked,
 			    bool uniform_locations_assigned,
                             const struct gl_shader_compiler_options *options,
-                            bool native_integers);
+                            bool native_integers,
+                            opt_pass_tracker *tracker = NULL);
 
 bool ir_constant_fold(ir_rvalue **rvalue);
 
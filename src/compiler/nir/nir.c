@@ -37,6 +37,13 @@ nir_shader_create(void *mem_ctx,
 {
    nir_shader *shader = rzalloc(mem_ctx, nir_shader);
 
+   /* Passes create and drop instructions all the time.  Allocating them from
+    * a pool keeps them close together and lets nir_sweep() hand the memory
+    * of dead ones back to the next pass instead of to malloc.  This fails
+    * harmlessly if mem_ctx is an arena.
+    */
+   ralloc_enable_pool(shader);
+
    exec_list_make_empty(&shader->uniforms);
    exec_list_make_empty(&shader->inputs);
    exec_list_make_empty(&shader->outputs);
@@ -1835,6 +1835,12 @@ typedef struct nir_shader_compiler_options {
     */
    bool use_interpolated_input_intrinsics;
 
+   /**
+    * Should the optimization loop run nir_opt_pre?  Hoisting loop invariants
+    * trades instructions for register pressure, so backends opt in.
+    */
+   bool opt_pre;
+
    unsigned max_unroll_iterations;
 } nir_shader_compiler_options;
 
@@ -2615,6 +2621,8 @@ bool nir_opt_dead_cf(nir_shader *shader);
 
 bool nir_opt_gcm(nir_shader *shader, bool value_number);
 
+bool nir_opt_pre(nir_shader *shader);
+
 bool nir_opt_if(nir_shader *shader);
 
 bool nir_opt_loop_unroll(nir_shader *shader, nir_variable_mode indirect_mask);
@@ -495,6 +495,156 @@ class SearchAndReplace(object):
 
       BitSizeValidator(varset).validate(self.search, self.replace)
 
+class TreeAutomaton(object):
+   """This class calculates a bottom-up tree automaton to quickly search for
+   the left-hand sides of transforms. Tree automatons are a generalization of
+   classical NFA's and DFA's, where the transition function determines the
+   state of the parent node based on the state of its children. We construct
+   a deterministic automaton to match patterns, using a similar algorithm to
+   the classical NFA to DFA construction. At the moment, it only matches
+   opcodes and constants (without checking the actual value), leaving more
+   detailed checking to the search function which actually checks the
+   leaves. The automaton acts as a quick filter for the search function,
+   requiring only n + 1 table lookups for each n-source operation. The
+   implementation is based on the theory described in "Tree Automatons:
+   Two Taxonomies and a Toolkit." In the language of that reference, this
+   is a frontier-to-root deterministic automaton using only symbol
+   filtering. The filtering is crucial to reduce both the time taken to
+   generate the tables and the size of the tables.
+
+   Every search expression is turned into an "item", which is its tree of
+   opcodes with each variable replaced by a wildcard and each constant (or
+   '#' variable) replaced by a "constant" leaf. A state is a set of items,
+   and the state of an SSA value is the set of items it may match. State 0
+   only contains the wildcard, which is what anything that isn't an ALU
+   instruction or a load_const gets. State 1 is the state of a load_const.
+
+   The automaton ignores bit sizes, swizzles, exact flags and conditions, so
+   it may claim an item matches when nir_replace_instr() won't, but never
+   the other way around.
+   """
+   def __init__(self, transforms):
+      self.items = {}
+      self.item_list = []
+
+      self.wildcard = self._get_item('__wildcard', ())
+      self.const = self._get_item('__const', ())
+
+      # The root item of each transform
+      self.xforms = []
+      for xform in transforms:
+         self.xforms.append((self._build_item(xform.search), xform))
+
+      # Items with a given opcode at the root, and the items which appear as
+      # a source of those.  Only the latter are relevant when computing the
+      # state of an instruction with that opcode, so every state is
+      # "filtered" down to them first.
+      self.opcodes = sorted(set(item[0] for item in self.item_list
+                                if not item[0].startswith('__')))
+      self.opcode_items = dict((op, []) for op in self.opcodes)
+      self.opcode_src_items = dict((op, set()) for op in self.opcodes)
+      for i, item in enumerate(self.item_list):
+         if item[0].startswith('__'):
+            continue
+         self.opcode_items[item[0]].append(i)
+         self.opcode_src_items[item[0]].update(item[1])
+
+      self._compute_states()
+
+   def _get_item(self, opcode, srcs):
+      key = (opcode, srcs)
+      if key not in self.items:
+         self.items[key] = len(self.item_list)
+         self.item_list.append(key)
+      return self.items[key]
+
+   def _build_item(self, val):
+      if isinstance(val, Constant):
+         return self.const
+      elif isinstance(val, Variable):
+         return self.const if val.is_constant else self.wildcard
+      else:
+         srcs = tuple(self._build_item(src) for src in val.sources)
+         return self._get_item(val.opcode, srcs)
+
+   def _get_state(self, state):
+      state = frozenset(state)
+      if state not in self.state_index:
+         self.state_index[state] = len(self.states)
+         self.states.append(state)
+      return self.state_index[state]
+
+   def _compute_result(self, op, srcs):
+      filtered = [self.filtered_states[op][s] for s in srcs]
+      commutative = "commutative" in opcodes[op].algebraic_properties
+
+      result = set([self.wildcard])
+      for i in self.opcode_items[op]:
+         item_srcs = self.item_list[i][1]
+         if all(item_srcs[j] in filtered[j] for j in range(len(srcs))):
+            result.add(i)
+         elif commutative and \
+              item_srcs[0] in filtered[1] and item_srcs[1] in filtered[0]:
+            result.add(i)
+
+      return result
+
+   def _compute_states(self):
+      self.states = []
+      self.state_index = {}
+      self._get_state([self.wildcard])
+      self._get_state([self.wildcard, self.const])
+
+      # For every opcode, the list of distinct filtered states, the filtered
+      # state index of each state and the transition table, which is indexed
+      # by the filtered state indices of the sources.
+      self.filtered_states = dict((op, []) for op in self.opcodes)
+      filtered_index = dict((op, {}) for op in self.opcodes)
+      self.filter = dict((op, []) for op in self.opcodes)
+      self.table = dict((op, {}) for op in self.opcodes)
+
+      # States are only ever appended, so walking the list in order is the
+      # worklist.
+      i = 0
+      while i < len(self.states):
+         state = self.states[i]
+         i += 1
+
+         for op in self.opcodes:
+            filtered = state & self.opcode_src_items[op]
+            if filtered in filtered_index[op]:
+               self.filter[op].append(filtered_index[op][filtered])
+               continue
+
+            f = len(self.filtered_states[op])
+            filtered_index[op][filtered] = f
+            self.filtered_states[op].append(filtered)
+            self.filter[op].append(f)
+
+            # Compute the transitions for every combination of sources
+            # which contains the new filtered state.  Combinations of only
+            # older ones have been handled already.
+            num_srcs = opcodes[op].num_inputs
+            for srcs in itertools.product(range(f + 1), repeat=num_srcs):
+               if f not in srcs:
+                  continue
+               result = self._compute_result(op, srcs)
+               self.table[op][srcs] = self._get_state(result)
+
+      assert len(self.states) < (1 << 16)
+
+      # The transforms to try for each state, in the order they were given.
+      self.state_xforms = []
+      for state in self.states:
+         self.state_xforms.append([xform for (item, xform) in self.xforms
+                                   if item in state])
+
+   def flat_table(self, op):
+      n = len(self.filtered_states[op])
+      num_srcs = opcodes[op].num_inputs
+      return [self.table[op][srcs]
+              for srcs in itertools.product(range(n), repeat=num_srcs)]
+
 _algebraic_pass_template = mako.template.Template("""
 #include "nir.h"
 #include "nir_search.h"
@@ -509,24 +659,67 @@ struct transform {
    unsigned condition_offset;
 };
 
+struct transform_list {
+   const struct transform *xforms;
+   unsigned num_xforms;
+};
+
 #endif
 
-% for (opcode, xform_list) in xform_dict.iteritems():
-% for xform in xform_list:
+% for xform in xforms:
    ${xform.search.render()}
    ${xform.replace.render()}
 % endfor
 
-static const struct transform ${pass_name}_${opcode}_xforms[] = {
-% for xform in xform_list:
+% for state_id, state_xforms in enumerate(automaton.state_xforms):
+% if state_xforms:
+static const struct transform ${pass_name}_state${state_id}_xforms[] = {
+% for xform in state_xforms:
    { &${xform.search.name}, ${xform.replace.c_ptr}, ${xform.condition_index} },
 % endfor
 };
+% endif
+% endfor
+
+static const struct transform_list ${pass_name}_state_xforms[] = {
+% for state_id, state_xforms in enumerate(automaton.state_xforms):
+% if state_xforms:
+   { ${pass_name}_state${state_id}_xforms, ARRAY_SIZE(${pass_name}_state${state_id}_xforms) },
+% else:
+   { NULL, 0 },
+% endif
+% endfor
+};
+
+% for op in automaton.opcodes:
+<% op_filter = automaton.filter[op] %>
+<% table = automaton.flat_table(op) %>
+static const uint16_t ${pass_name}_${op}_filter[] = {
+% for i in range(0, len(op_filter), 16):
+   ${', '.join(str(f) for f in op_filter[i:i + 16])},
+% endfor
+};
+
+static const uint16_t ${pass_name}_${op}_table[] = {
+% for i in range(0, len(table), 16):
+   ${', '.join(str(t) for t in table[i:i + 16])},
+% endfor
+};
 % endfor
 
+static const struct per_op_table ${pass_name}_table[nir_num_opcodes] = {
+% for op in automaton.opcodes:
+   [nir_op_${op}] = {
+      ${pass_name}_${op}_filter,
+      ${len(automaton.filtered_states[op])},
+      ${pass_name}_${op}_table,
+   },
+% endfor
+};
+
 static bool
 ${pass_name}_block(nir_block *block, const bool *condition_flags,
-                   void *mem_ctx)
+                   const uint16_t *states, void *mem_ctx)
 {
    bool progress = false;
 
@@ -538,22 +731,23 @@ ${pass_name}_block(nir_block *block, const bool *condition_flags,
       if (!alu->dest.dest.is_ssa)
          continue;
 
-      switch (alu->op) {
-      % for opcode in xform_dict.keys():
-      case nir_op_${opcode}:
-         for (unsigned i = 0; i < ARRAY_SIZE(${pass_name}_${opcode}_xforms); i++) {
-            const struct transform *xform = &${pass_name}_${opcode}_xforms[i];
-            if (condition_flags[xform->condition_offset] &&
-                nir_replace_instr(alu, xform->search, xform->replace,
-                                  mem_ctx)) {
-               progress = true;
-               break;
-            }
+      /* Only the transforms whose search expression the automaton says can
+       * match this instruction are tried.  Instructions created while
+       * rewriting are inserted before alu and never visited, so the state
+       * is always one computed up-front.
+       */
+      assert(alu->dest.dest.ssa.index != UINT_MAX);
+      const struct transform_list *list =
+         &${pass_name}_state_xforms[states[alu->dest.dest.ssa.index]];
+
+      for (unsigned i = 0; i < list->num_xforms; i++) {
+         const struct transform *xform = &list->xforms[i];
+         if (condition_flags[xform->condition_offset] &&
+             nir_replace_instr(alu, xform->search, xform->replace,
+                               mem_ctx)) {
+            progress = true;
+            break;
          }
-         break;
-      % endfor
-      default:
-         break;
       }
    }
 
@@ -566,10 +760,27 @@ ${pass_name}_impl(nir_function_impl *impl, const bool *condition_flags)
    void *mem_ctx = ralloc_parent(impl);
    bool progress = false;
 
+   /* Compute the automaton state of every SSA value in a single forward
+    * walk.  Sources always come before their uses (phis are never ALU
+    * instructions), and rewriting an instruction doesn't change the state
+    * of anything which is visited after it in the reverse walk below.
+    */
+   nir_index_ssa_defs(impl);
+   uint16_t *states = calloc(impl->ssa_alloc, sizeof(*states));
+   if (!states)
+      return false;
+
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block)
+         nir_algebraic_automaton(instr, states, ${pass_name}_table);
+   }
+
    nir_foreach_block_reverse(block, impl) {
-      progress |= ${pass_name}_block(block, condition_flags, mem_ctx);
+      progress |= ${pass_name}_block(block, condition_flags, states, mem_ctx);
    }
 
+   free(states);
+
    if (progress)
       nir_metadata_preserve(impl, nir_metadata_block_index |
                                   nir_metadata_dominance);
@@ -601,7 +812,7 @@ ${pass_name}(nir_shader *shader)
 
 class AlgebraicPass(object):
    def __init__(self, pass_name, transforms):
-      self.xform_dict = {}
+      self.xforms = []
       self.pass_name = pass_name
 
       error = False
@@ -618,15 +829,15 @@ class AlgebraicPass(object):
                error = True
                continue
 
-         if xform.search.opcode not in self.xform_dict:
-            self.xform_dict[xform.search.opcode] = []
-
-         self.xform_dict[xform.search.opcode].append(xform)
+         self.xforms.append(xform)
 
       if error:
          sys.exit(1)
 
+      self.automaton = TreeAutomaton(self.xforms)
+
    def render(self):
       return _algebraic_pass_template.render(pass_name=self.pass_name,
-                                             xform_dict=self.xform_dict,
+                                             xforms=self.xforms,
+                                             automaton=self.automaton,
                                              condition_list=condition_list)
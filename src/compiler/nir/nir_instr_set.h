@@ -61,4 +61,10 @@ void nir_instr_set_remove(struct set *instr_set, nir_instr *instr);
 
 /*@}*/
 
+/**
+ * Returns true if the two instructions compute the same value.  Only
+ * meaningful for instructions that could be put into an instruction set.
+ */
+bool nir_instrs_equal(const nir_instr *instr1, const nir_instr *instr2);
+
 #endif /* NIR_INSTR_SET_H */
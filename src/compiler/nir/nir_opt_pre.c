@@ -0,0 +1,290 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "nir.h"
+#include "nir_instr_set.h"
+
+/*
+ * Implements a simple form of partial redundancy elimination.
+ *
+ * nir_opt_cse only removes an expression when an equal one dominates it.
+ * This pass handles the two most common cases where a computation is
+ * redundant only along some paths:
+ *
+ *  - Loop-invariant expressions are computed on every iteration.  They are
+ *    moved to the block before the loop.  Only the top-level blocks of the
+ *    loop body are looked at, which run on every iteration that gets that
+ *    far.  Expressions inside an if in the loop are left alone, hoisting
+ *    them would compute them even when the branch is never taken and keep
+ *    their results live through the whole loop.
+ *
+ *  - An expression computed on both sides of an if is hoisted above the if
+ *    and the copy in the other branch is removed.
+ *
+ * Only ALU instructions that take no implicit derivatives are moved.  They
+ * have no side effects, so executing them speculatively (e.g. when a loop
+ * runs zero times) is harmless.  Constants used by a hoisted instruction
+ * are copied along with it.
+ */
+
+static bool
+instr_can_hoist(nir_instr *instr)
+{
+   if (instr->type != nir_instr_type_alu)
+      return false;
+
+   nir_alu_instr *alu = nir_instr_as_alu(instr);
+   if (!alu->dest.dest.is_ssa)
+      return false;
+
+   switch (alu->op) {
+   case nir_op_fddx:
+   case nir_op_fddy:
+   case nir_op_fddx_fine:
+   case nir_op_fddy_fine:
+   case nir_op_fddx_coarse:
+   case nir_op_fddy_coarse:
+      /* These can only go in uniform control flow */
+      return false;
+   default:
+      break;
+   }
+
+   for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
+      if (!alu->src[i].src.is_ssa)
+         return false;
+   }
+
+   return true;
+}
+
+static bool
+src_is_const(nir_src *src)
+{
+   return src->ssa->parent_instr->type == nir_instr_type_load_const;
+}
+
+/* Moves instr to the end of block, copying any constant sources that are
+ * not already available there.
+ */
+static void
+hoist_instr(nir_instr *instr, nir_block *block)
+{
+   nir_alu_instr *alu = nir_instr_as_alu(instr);
+   nir_cursor cursor = nir_after_block_before_jump(block);
+
+   for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
+      nir_ssa_def *def = alu->src[i].src.ssa;
+
+      if (!src_is_const(&alu->src[i].src) ||
+          nir_block_dominates(def->parent_instr->block, block))
+         continue;
+
+      nir_load_const_instr *orig = nir_instr_as_load_const(def->parent_instr);
+      nir_load_const_instr *load =
+         nir_load_const_instr_create(ralloc_parent(orig),
+                                     def->num_components, def->bit_size);
+      load->value = orig->value;
+      nir_instr_insert(cursor, &load->instr);
+      nir_instr_rewrite_src(instr, &alu->src[i].src,
+                            nir_src_for_ssa(&load->def));
+   }
+
+   nir_instr_remove(instr);
+   nir_instr_insert(nir_after_block_before_jump(block), instr);
+}
+
+/* Whether all of the sources of instr are available at the end of block,
+ * either because they are defined in a block dominating it or because they
+ * are constants that can be copied.
+ */
+static bool
+srcs_available(nir_instr *instr, nir_block *block)
+{
+   nir_alu_instr *alu = nir_instr_as_alu(instr);
+
+   for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
+      nir_src *src = &alu->src[i].src;
+
+      if (!src_is_const(src) &&
+          !nir_block_dominates(src->ssa->parent_instr->block, block))
+         return false;
+   }
+
+   return true;
+}
+
+static bool
+hoist_loop_invariants(nir_loop *loop)
+{
+   nir_block *preheader =
+      nir_cf_node_as_block(nir_cf_node_prev(&loop->cf_node));
+   unsigned first_index = nir_loop_first_block(loop)->index;
+   bool progress = false;
+
+   foreach_list_typed(nir_cf_node, node, node, &loop->body) {
+      if (node->type != nir_cf_node_block)
+         continue;
+
+      nir_foreach_instr_safe(instr, nir_cf_node_as_block(node)) {
+         if (!instr_can_hoist(instr))
+            continue;
+
+         /* Blocks are numbered in source order and the blocks of a loop are
+          * contiguous, so a source is defined outside of the loop iff its
+          * block comes before the first one of the loop.  The preheader
+          * dominates the loop, so such sources are available there.
+          */
+         nir_alu_instr *alu = nir_instr_as_alu(instr);
+         bool invariant = true;
+         for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
+            nir_src *src = &alu->src[i].src;
+            if (!src_is_const(src) &&
+                src->ssa->parent_instr->block->index >= first_index) {
+               invariant = false;
+               break;
+            }
+         }
+
+         if (invariant) {
+            hoist_instr(instr, preheader);
+            progress = true;
+         }
+      }
+   }
+
+   return progress;
+}
+
+/* Finds an instruction equal to instr in the top-level blocks of list. */
+static nir_instr *
+find_equal_instr(struct exec_list *list, nir_instr *instr)
+{
+   foreach_list_typed(nir_cf_node, node, node, list) {
+      if (node->type != nir_cf_node_block)
+         continue;
+
+      nir_foreach_instr(other, nir_cf_node_as_block(node)) {
+         if (nir_instrs_equal(instr, other))
+            return other;
+      }
+   }
+
+   return NULL;
+}
+
+static bool
+hoist_if_common_exprs(nir_if *nif)
+{
+   nir_block *pred = nir_cf_node_as_block(nir_cf_node_prev(&nif->cf_node));
+   bool progress = false;
+
+   /* Only the top-level blocks of either branch are considered: they run
+    * whenever their branch is taken, so hoisting never adds work to a path.
+    */
+   foreach_list_typed(nir_cf_node, node, node, &nif->then_list) {
+      if (node->type != nir_cf_node_block)
+         continue;
+
+      nir_foreach_instr_safe(instr, nir_cf_node_as_block(node)) {
+         if (!instr_can_hoist(instr) || !srcs_available(instr, pred))
+            continue;
+
+         nir_instr *other = find_equal_instr(&nif->else_list, instr);
+         if (other == NULL)
+            continue;
+
+         hoist_instr(instr, pred);
+
+         nir_ssa_def *def = &nir_instr_as_alu(instr)->dest.dest.ssa;
+         nir_ssa_def_rewrite_uses(&nir_instr_as_alu(other)->dest.dest.ssa,
+                                  nir_src_for_ssa(def));
+         nir_instr_remove(other);
+         progress = true;
+      }
+   }
+
+   return progress;
+}
+
+static bool
+opt_pre_cf_list(struct exec_list *cf_list)
+{
+   bool progress = false;
+
+   foreach_list_typed(nir_cf_node, node, node, cf_list) {
+      switch (node->type) {
+      case nir_cf_node_block:
+         break;
+
+      case nir_cf_node_if: {
+         nir_if *nif = nir_cf_node_as_if(node);
+         progress |= opt_pre_cf_list(&nif->then_list);
+         progress |= opt_pre_cf_list(&nif->else_list);
+         progress |= hoist_if_common_exprs(nif);
+         break;
+      }
+
+      case nir_cf_node_loop: {
+         nir_loop *loop = nir_cf_node_as_loop(node);
+         progress |= opt_pre_cf_list(&loop->body);
+         progress |= hoist_loop_invariants(loop);
+         break;
+      }
+
+      default:
+         unreachable("Invalid CF node type");
+      }
+   }
+
+   return progress;
+}
+
+static bool
+nir_opt_pre_impl(nir_function_impl *impl)
+{
+   nir_metadata_require(impl, nir_metadata_block_index |
+                              nir_metadata_dominance);
+
+   bool progress = opt_pre_cf_list(&impl->body);
+
+   /* Only instructions were moved, the control flow is untouched. */
+   if (progress)
+      nir_metadata_preserve(impl, nir_metadata_block_index |
+                                  nir_metadata_dominance);
+
+   return progress;
+}
+
+bool
+nir_opt_pre(nir_shader *shader)
+{
+   bool progress = false;
+
+   nir_foreach_function(function, shader) {
+      if (function->impl)
+         progress |= nir_opt_pre_impl(function->impl);
+   }
+
+   return progress;
+}
@@ -567,6 +567,53 @@ construct_value(const nir_search_value *value,
    }
 }
 
+static uint16_t
+automaton_src_state(nir_src src, const uint16_t *states)
+{
+   return src.is_ssa ? states[src.ssa->index] : 0;
+}
+
+/**
+ * Computes the automaton state of the value produced by instr.
+ *
+ * State 0 is the state of anything which can only be matched by a variable
+ * and is what states has to be initialized to, state 1 is the state of a
+ * load_const.  The states of the sources of an ALU instruction have to be
+ * computed before the instruction itself.
+ */
+void
+nir_algebraic_automaton(nir_instr *instr, uint16_t *states,
+                        const struct per_op_table *pass_op_table)
+{
+   switch (instr->type) {
+   case nir_instr_type_alu: {
+      nir_alu_instr *alu = nir_instr_as_alu(instr);
+      const struct per_op_table *tbl = &pass_op_table[alu->op];
+
+      if (!alu->dest.dest.is_ssa || tbl->num_filtered_states == 0)
+         return;
+
+      unsigned index = 0;
+      for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
+         index *= tbl->num_filtered_states;
+         index += tbl->filter[automaton_src_state(alu->src[i].src, states)];
+      }
+
+      states[alu->dest.dest.ssa.index] = tbl->table[index];
+      break;
+   }
+
+   case nir_instr_type_load_const: {
+      nir_load_const_instr *load_const = nir_instr_as_load_const(instr);
+      states[load_const->def.index] = 1;
+      break;
+   }
+
+   default:
+      break;
+   }
+}
+
 nir_alu_instr *
 nir_replace_instr(nir_alu_instr *instr, const nir_search_expression *search,
                   const nir_search_value *replace, void *mem_ctx)
@@ -123,6 +123,22 @@ NIR_DEFINE_CAST(nir_search_value_as_expression, nir_search_value,
                 nir_search_expression, value,
                 type, nir_search_value_expression)
 
+/** Per-opcode transition table of a nir_algebraic automaton
+ *
+ * filter maps the state of a source to one of num_filtered_states indices,
+ * and table is indexed by the filtered indices of all sources, with the
+ * first source being the most significant digit.
+ */
+struct per_op_table {
+   const uint16_t *filter;
+   unsigned num_filtered_states;
+   const uint16_t *table;
+};
+
+void
+nir_algebraic_automaton(nir_instr *instr, uint16_t *states,
+                        const struct per_op_table *pass_op_table);
+
 nir_alu_instr *
 nir_replace_instr(nir_alu_instr *instr, const nir_search_expression *search,
                   const nir_search_value *replace, void *mem_ctx);
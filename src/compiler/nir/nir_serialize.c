@@ -0,0 +1,1268 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "nir_serialize.h"
+#include "nir_control_flow.h"
+
+/* Secret Decoder Ring:
+ *   write_foo():
+ *        Serialize a foo into the blob.
+ *   read_foo():
+ *        Allocate a foo and fill it in from the blob.
+ *
+ * Everything that can be referenced by pointer from elsewhere in the shader
+ * (variables, registers, functions, SSA definitions and blocks) is given an
+ * object index in the order it is written, and references are written as
+ * that index.  Index 0 is reserved for NULL.  The reader creates objects in
+ * exactly the same order, so it can map the indices back to pointers with a
+ * simple table.
+ */
+
+typedef struct {
+   const nir_shader *nir;
+
+   struct blob *blob;
+
+   /* maps pointer to index */
+   struct hash_table *remap_table;
+
+   /* the next index to assign to an object */
+   uint32_t next_idx;
+} write_ctx;
+
+typedef struct {
+   nir_shader *nir;
+
+   struct blob_reader *blob;
+
+   /* the next index to assign to an object */
+   uint32_t next_idx;
+
+   /* the length of the index -> object table */
+   uint32_t num_object_ids;
+
+   /* maps index to deserialized pointer */
+   void **idx_table;
+
+   /* List of phi sources, fixed up once the whole function is read. */
+   struct list_head phi_srcs;
+} read_ctx;
+
+static void
+write_add_object(write_ctx *ctx, const void *obj)
+{
+   uint32_t index = ctx->next_idx++;
+   _mesa_hash_table_insert(ctx->remap_table, obj, (void *)(uintptr_t) index);
+}
+
+static uint32_t
+write_lookup_object(write_ctx *ctx, const void *obj)
+{
+   if (obj == NULL)
+      return 0;
+
+   struct hash_entry *entry = _mesa_hash_table_search(ctx->remap_table, obj);
+   assert(entry);
+   return (uint32_t)(uintptr_t) entry->data;
+}
+
+static void
+write_object(write_ctx *ctx, const void *obj)
+{
+   blob_write_uint32(ctx->blob, write_lookup_object(ctx, obj));
+}
+
+static void
+read_add_object(read_ctx *ctx, void *obj)
+{
+   if (ctx->next_idx >= ctx->num_object_ids) {
+      ctx->blob->overrun = true;
+      return;
+   }
+   ctx->idx_table[ctx->next_idx++] = obj;
+}
+
+static void *
+read_lookup_object(read_ctx *ctx, uint32_t idx)
+{
+   if (idx >= ctx->num_object_ids) {
+      /* Corrupt stream; make sure the caller sees it. */
+      ctx->blob->overrun = true;
+      return NULL;
+   }
+   return ctx->idx_table[idx];
+}
+
+static void *
+read_object(read_ctx *ctx)
+{
+   return read_lookup_object(ctx, blob_read_uint32(ctx->blob));
+}
+
+static void
+write_string(write_ctx *ctx, const char *str)
+{
+   blob_write_uint32(ctx->blob, str != NULL);
+   if (str)
+      blob_write_string(ctx->blob, str);
+}
+
+static char *
+read_string(read_ctx *ctx, void *mem_ctx)
+{
+   if (!blob_read_uint32(ctx->blob))
+      return NULL;
+   return ralloc_strdup(mem_ctx, blob_read_string(ctx->blob));
+}
+
+static void
+write_type(write_ctx *ctx, const struct glsl_type *type)
+{
+   blob_write_uint32(ctx->blob, type != NULL);
+   if (type)
+      encode_type_to_blob(ctx->blob, type);
+}
+
+static const struct glsl_type *
+read_type(read_ctx *ctx)
+{
+   if (!blob_read_uint32(ctx->blob))
+      return NULL;
+   return decode_type_from_blob(ctx->blob);
+}
+
+static void
+write_constant(write_ctx *ctx, const nir_constant *c)
+{
+   blob_write_bytes(ctx->blob, c->values, sizeof(c->values));
+   blob_write_uint32(ctx->blob, c->num_elements);
+   for (unsigned i = 0; i < c->num_elements; i++)
+      write_constant(ctx, c->elements[i]);
+}
+
+static nir_constant *
+read_constant(read_ctx *ctx, nir_variable *nvar)
+{
+   nir_constant *c = ralloc(nvar, nir_constant);
+
+   blob_copy_bytes(ctx->blob, (uint8_t *) c->values, sizeof(c->values));
+   c->num_elements = blob_read_uint32(ctx->blob);
+   c->elements = ralloc_array(nvar, nir_constant *, c->num_elements);
+   for (unsigned i = 0; i < c->num_elements; i++) {
+      if (ctx->blob->overrun) {
+         c->num_elements = i;
+         break;
+      }
+      c->elements[i] = read_constant(ctx, nvar);
+   }
+
+   return c;
+}
+
+static void
+write_variable(write_ctx *ctx, const nir_variable *var)
+{
+   write_add_object(ctx, var);
+   write_type(ctx, var->type);
+   write_string(ctx, var->name);
+   blob_write_bytes(ctx->blob, &var->data, sizeof(var->data));
+   blob_write_uint32(ctx->blob, var->num_state_slots);
+   blob_write_bytes(ctx->blob, var->state_slots,
+                    var->num_state_slots * sizeof(nir_state_slot));
+   blob_write_uint32(ctx->blob, var->constant_initializer != NULL);
+   if (var->constant_initializer)
+      write_constant(ctx, var->constant_initializer);
+   write_type(ctx, var->interface_type);
+}
+
+/* NOTE: like nir_variable_clone(), bypass nir_variable_create to avoid
+ * having to deal with locals and globals separately:
+ */
+static nir_variable *
+read_variable(read_ctx *ctx)
+{
+   nir_variable *var = rzalloc(ctx->nir, nir_variable);
+   read_add_object(ctx, var);
+
+   var->type = read_type(ctx);
+   var->name = read_string(ctx, var);
+   blob_copy_bytes(ctx->blob, (uint8_t *) &var->data, sizeof(var->data));
+   var->num_state_slots = blob_read_uint32(ctx->blob);
+   var->state_slots = ralloc_array(var, nir_state_slot, var->num_state_slots);
+   blob_copy_bytes(ctx->blob, (uint8_t *) var->state_slots,
+                   var->num_state_slots * sizeof(nir_state_slot));
+   if (blob_read_uint32(ctx->blob))
+      var->constant_initializer = read_constant(ctx, var);
+   var->interface_type = read_type(ctx);
+
+   return var;
+}
+
+static void
+write_var_list(write_ctx *ctx, const struct exec_list *src)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(src));
+   foreach_list_typed(nir_variable, var, node, src)
+      write_variable(ctx, var);
+}
+
+static void
+read_var_list(read_ctx *ctx, struct exec_list *dst)
+{
+   exec_list_make_empty(dst);
+   unsigned num_vars = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_vars && !ctx->blob->overrun; i++) {
+      nir_variable *var = read_variable(ctx);
+      exec_list_push_tail(dst, &var->node);
+   }
+}
+
+static void
+write_register(write_ctx *ctx, const nir_register *reg)
+{
+   write_add_object(ctx, reg);
+   blob_write_uint32(ctx->blob, reg->num_components);
+   blob_write_uint32(ctx->blob, reg->bit_size);
+   blob_write_uint32(ctx->blob, reg->num_array_elems);
+   blob_write_uint32(ctx->blob, reg->index);
+   write_string(ctx, reg->name);
+   blob_write_uint32(ctx->blob, reg->is_global << 1 | reg->is_packed);
+}
+
+static nir_register *
+read_register(read_ctx *ctx)
+{
+   nir_register *reg = rzalloc(ctx->nir, nir_register);
+   read_add_object(ctx, reg);
+
+   reg->num_components = blob_read_uint32(ctx->blob);
+   reg->bit_size = blob_read_uint32(ctx->blob);
+   reg->num_array_elems = blob_read_uint32(ctx->blob);
+   reg->index = blob_read_uint32(ctx->blob);
+   reg->name = read_string(ctx, reg);
+   unsigned flags = blob_read_uint32(ctx->blob);
+   reg->is_global = flags & 0x2;
+   reg->is_packed = flags & 0x1;
+
+   /* reconstructing uses/defs/if_uses handled by nir_instr_insert() */
+   list_inithead(&reg->uses);
+   list_inithead(&reg->defs);
+   list_inithead(&reg->if_uses);
+
+   return reg;
+}
+
+static void
+write_reg_list(write_ctx *ctx, const struct exec_list *src)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(src));
+   foreach_list_typed(nir_register, reg, node, src)
+      write_register(ctx, reg);
+}
+
+static void
+read_reg_list(read_ctx *ctx, struct exec_list *dst)
+{
+   exec_list_make_empty(dst);
+   unsigned num_regs = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_regs && !ctx->blob->overrun; i++) {
+      nir_register *reg = read_register(ctx);
+      exec_list_push_tail(dst, &reg->node);
+   }
+}
+
+/* Sources and register destinations start with a header word holding the
+ * object index of the SSA value or register in the upper bits.
+ */
+#define SRC_IS_SSA       (1 << 0)
+#define SRC_HAS_INDIRECT (1 << 1)
+#define SRC_INDEX_SHIFT  2
+
+static void
+write_src(write_ctx *ctx, const nir_src *src)
+{
+   if (src->is_ssa) {
+      uint32_t idx = write_lookup_object(ctx, src->ssa);
+      blob_write_uint32(ctx->blob, idx << SRC_INDEX_SHIFT | SRC_IS_SSA);
+   } else {
+      uint32_t idx = write_lookup_object(ctx, src->reg.reg);
+      blob_write_uint32(ctx->blob, idx << SRC_INDEX_SHIFT |
+                        (src->reg.indirect ? SRC_HAS_INDIRECT : 0));
+      blob_write_uint32(ctx->blob, src->reg.base_offset);
+      if (src->reg.indirect)
+         write_src(ctx, src->reg.indirect);
+   }
+}
+
+static void
+read_src(read_ctx *ctx, nir_src *src, void *mem_ctx)
+{
+   uint32_t header = blob_read_uint32(ctx->blob);
+
+   src->is_ssa = header & SRC_IS_SSA;
+   if (src->is_ssa) {
+      src->ssa = read_lookup_object(ctx, header >> SRC_INDEX_SHIFT);
+   } else {
+      src->reg.reg = read_lookup_object(ctx, header >> SRC_INDEX_SHIFT);
+      src->reg.base_offset = blob_read_uint32(ctx->blob);
+      if (header & SRC_HAS_INDIRECT) {
+         src->reg.indirect = ralloc(mem_ctx, nir_src);
+         read_src(ctx, src->reg.indirect, mem_ctx);
+      } else {
+         src->reg.indirect = NULL;
+      }
+   }
+}
+
+static void
+write_dest(write_ctx *ctx, const nir_dest *dst)
+{
+   if (dst->is_ssa) {
+      blob_write_uint32(ctx->blob, SRC_IS_SSA);
+      blob_write_uint32(ctx->blob, dst->ssa.num_components |
+                                   dst->ssa.bit_size << 8);
+      write_string(ctx, dst->ssa.name);
+   } else {
+      uint32_t idx = write_lookup_object(ctx, dst->reg.reg);
+      blob_write_uint32(ctx->blob, idx << SRC_INDEX_SHIFT |
+                        (dst->reg.indirect ? SRC_HAS_INDIRECT : 0));
+      blob_write_uint32(ctx->blob, dst->reg.base_offset);
+      if (dst->reg.indirect)
+         write_src(ctx, dst->reg.indirect);
+   }
+}
+
+static void
+read_dest(read_ctx *ctx, nir_dest *dst, nir_instr *instr)
+{
+   uint32_t header = blob_read_uint32(ctx->blob);
+
+   dst->is_ssa = header & SRC_IS_SSA;
+   if (dst->is_ssa) {
+      uint32_t size = blob_read_uint32(ctx->blob);
+      char *name = read_string(ctx, instr);
+      nir_ssa_dest_init(instr, dst, size & 0xff, size >> 8, name);
+      read_add_object(ctx, &dst->ssa);
+   } else {
+      dst->reg.reg = read_lookup_object(ctx, header >> SRC_INDEX_SHIFT);
+      dst->reg.base_offset = blob_read_uint32(ctx->blob);
+      if (header & SRC_HAS_INDIRECT) {
+         dst->reg.indirect = ralloc(instr, nir_src);
+         read_src(ctx, dst->reg.indirect, instr);
+      } else {
+         dst->reg.indirect = NULL;
+      }
+   }
+}
+
+static void
+write_deref_chain(write_ctx *ctx, const nir_deref_var *deref_var)
+{
+   write_object(ctx, deref_var->var);
+
+   uint32_t len = 0;
+   for (const nir_deref *d = deref_var->deref.child; d; d = d->child)
+      len++;
+   blob_write_uint32(ctx->blob, len);
+
+   for (const nir_deref *d = deref_var->deref.child; d; d = d->child) {
+      blob_write_uint32(ctx->blob, d->deref_type);
+      switch (d->deref_type) {
+      case nir_deref_type_array: {
+         const nir_deref_array *deref_array = nir_deref_as_array(d);
+         blob_write_uint32(ctx->blob, deref_array->deref_array_type);
+         blob_write_uint32(ctx->blob, deref_array->base_offset);
+         if (deref_array->deref_array_type == nir_deref_array_type_indirect)
+            write_src(ctx, &deref_array->indirect);
+         break;
+      }
+      case nir_deref_type_struct: {
+         const nir_deref_struct *deref_struct = nir_deref_as_struct(d);
+         blob_write_uint32(ctx->blob, deref_struct->index);
+         break;
+      }
+      default:
+         unreachable("Invalid deref type");
+      }
+
+      encode_type_to_blob(ctx->blob, d->type);
+   }
+}
+
+static nir_deref_var *
+read_deref_chain(read_ctx *ctx, nir_instr *instr)
+{
+   nir_variable *var = read_object(ctx);
+   if (var == NULL) {
+      ctx->blob->overrun = true;
+      return NULL;
+   }
+
+   nir_deref_var *deref_var = nir_deref_var_create(instr, var);
+
+   uint32_t len = blob_read_uint32(ctx->blob);
+
+   nir_deref *tail = &deref_var->deref;
+   for (uint32_t i = 0; i < len && !ctx->blob->overrun; i++) {
+      nir_deref_type deref_type = blob_read_uint32(ctx->blob);
+      nir_deref *deref = NULL;
+      switch (deref_type) {
+      case nir_deref_type_array: {
+         nir_deref_array *deref_array = nir_deref_array_create(tail);
+         deref_array->deref_array_type = blob_read_uint32(ctx->blob);
+         deref_array->base_offset = blob_read_uint32(ctx->blob);
+         if (deref_array->deref_array_type == nir_deref_array_type_indirect)
+            read_src(ctx, &deref_array->indirect, instr);
+         deref = &deref_array->deref;
+         break;
+      }
+      case nir_deref_type_struct: {
+         uint32_t index = blob_read_uint32(ctx->blob);
+         nir_deref_struct *deref_struct = nir_deref_struct_create(tail, index);
+         deref = &deref_struct->deref;
+         break;
+      }
+      default:
+         ctx->blob->overrun = true;
+         return deref_var;
+      }
+
+      deref->type = decode_type_from_blob(ctx->blob);
+
+      tail->child = deref;
+      tail = deref;
+   }
+
+   return deref_var;
+}
+
+static void
+write_deref_var(write_ctx *ctx, const nir_deref_var *deref_var)
+{
+   blob_write_uint32(ctx->blob, deref_var != NULL);
+   if (deref_var)
+      write_deref_chain(ctx, deref_var);
+}
+
+static nir_deref_var *
+read_deref_var(read_ctx *ctx, nir_instr *instr)
+{
+   if (!blob_read_uint32(ctx->blob))
+      return NULL;
+   return read_deref_chain(ctx, instr);
+}
+
+static void
+write_alu(write_ctx *ctx, const nir_alu_instr *alu)
+{
+   blob_write_uint32(ctx->blob, alu->op);
+   blob_write_uint32(ctx->blob, alu->exact |
+                                alu->dest.saturate << 1 |
+                                alu->dest.write_mask << 2);
+
+   write_dest(ctx, &alu->dest.dest);
+
+   for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
+      const nir_alu_src *src = &alu->src[i];
+      write_src(ctx, &src->src);
+      blob_write_uint32(ctx->blob, src->negate |
+                                   src->abs << 1 |
+                                   src->swizzle[0] << 2 |
+                                   src->swizzle[1] << 4 |
+                                   src->swizzle[2] << 6 |
+                                   src->swizzle[3] << 8);
+   }
+}
+
+static nir_alu_instr *
+read_alu(read_ctx *ctx)
+{
+   nir_op op = blob_read_uint32(ctx->blob);
+   if (op >= nir_num_opcodes) {
+      ctx->blob->overrun = true;
+      return NULL;
+   }
+
+   nir_alu_instr *alu = nir_alu_instr_create(ctx->nir, op);
+
+   unsigned flags = blob_read_uint32(ctx->blob);
+   alu->exact = flags & 0x1;
+   alu->dest.saturate = flags & 0x2;
+   alu->dest.write_mask = flags >> 2;
+
+   read_dest(ctx, &alu->dest.dest, &alu->instr);
+
+   for (unsigned i = 0; i < nir_op_infos[op].num_inputs; i++) {
+      nir_alu_src *src = &alu->src[i];
+      read_src(ctx, &src->src, &alu->instr);
+      unsigned mods = blob_read_uint32(ctx->blob);
+      src->negate = mods & 0x1;
+      src->abs = mods & 0x2;
+      for (unsigned c = 0; c < 4; c++)
+         src->swizzle[c] = (mods >> (2 + c * 2)) & 0x3;
+   }
+
+   return alu;
+}
+
+static void
+write_intrinsic(write_ctx *ctx, const nir_intrinsic_instr *intrin)
+{
+   const nir_intrinsic_info *info = &nir_intrinsic_infos[intrin->intrinsic];
+
+   blob_write_uint32(ctx->blob, intrin->intrinsic);
+   blob_write_uint32(ctx->blob, intrin->num_components);
+
+   if (info->has_dest)
+      write_dest(ctx, &intrin->dest);
+
+   for (unsigned i = 0; i < info->num_variables; i++)
+      write_deref_chain(ctx, intrin->variables[i]);
+
+   for (unsigned i = 0; i < info->num_srcs; i++)
+      write_src(ctx, &intrin->src[i]);
+
+   for (unsigned i = 0; i < info->num_indices; i++)
+      blob_write_uint32(ctx->blob, intrin->const_index[i]);
+}
+
+static nir_intrinsic_instr *
+read_intrinsic(read_ctx *ctx)
+{
+   nir_intrinsic_op op = blob_read_uint32(ctx->blob);
+   if (op >= nir_num_intrinsics) {
+      ctx->blob->overrun = true;
+      return NULL;
+   }
+
+   nir_intrinsic_instr *intrin = nir_intrinsic_instr_create(ctx->nir, op);
+   const nir_intrinsic_info *info = &nir_intrinsic_infos[op];
+
+   intrin->num_components = blob_read_uint32(ctx->blob);
+
+   if (info->has_dest)
+      read_dest(ctx, &intrin->dest, &intrin->instr);
+
+   for (unsigned i = 0; i < info->num_variables; i++)
+      intrin->variables[i] = read_deref_chain(ctx, &intrin->instr);
+
+   for (unsigned i = 0; i < info->num_srcs; i++)
+      read_src(ctx, &intrin->src[i], &intrin->instr);
+
+   for (unsigned i = 0; i < info->num_indices; i++)
+      intrin->const_index[i] = blob_read_uint32(ctx->blob);
+
+   return intrin;
+}
+
+static void
+write_load_const(write_ctx *ctx, const nir_load_const_instr *lc)
+{
+   blob_write_uint32(ctx->blob, lc->def.num_components |
+                                lc->def.bit_size << 8);
+   /* All the members of nir_const_value start at offset 0, so only the
+    * components actually used need to be stored.
+    */
+   blob_write_bytes(ctx->blob, &lc->value,
+                    lc->def.num_components * lc->def.bit_size / 8);
+}
+
+static nir_load_const_instr *
+read_load_const(read_ctx *ctx)
+{
+   uint32_t size = blob_read_uint32(ctx->blob);
+   unsigned num_components = size & 0xff;
+   unsigned bit_size = size >> 8;
+
+   if (num_components > 4 || bit_size > 64) {
+      ctx->blob->overrun = true;
+      return NULL;
+   }
+
+   nir_load_const_instr *lc =
+      nir_load_const_instr_create(ctx->nir, num_components, bit_size);
+
+   memset(&lc->value, 0, sizeof(lc->value));
+   blob_copy_bytes(ctx->blob, (uint8_t *) &lc->value,
+                   num_components * bit_size / 8);
+   read_add_object(ctx, &lc->def);
+
+   return lc;
+}
+
+static void
+write_ssa_undef(write_ctx *ctx, const nir_ssa_undef_instr *undef)
+{
+   blob_write_uint32(ctx->blob, undef->def.num_components |
+                                undef->def.bit_size << 8);
+}
+
+static nir_ssa_undef_instr *
+read_ssa_undef(read_ctx *ctx)
+{
+   uint32_t size = blob_read_uint32(ctx->blob);
+
+   nir_ssa_undef_instr *undef =
+      nir_ssa_undef_instr_create(ctx->nir, size & 0xff, size >> 8);
+   read_add_object(ctx, &undef->def);
+
+   return undef;
+}
+
+static void
+write_tex(write_ctx *ctx, const nir_tex_instr *tex)
+{
+   blob_write_uint32(ctx->blob, tex->num_srcs);
+   blob_write_uint32(ctx->blob, tex->op |
+                                tex->sampler_dim << 8 |
+                                tex->coord_components << 16 |
+                                tex->component << 20 |
+                                tex->is_array << 22 |
+                                tex->is_shadow << 23 |
+                                tex->is_new_style_shadow << 24);
+   blob_write_uint32(ctx->blob, tex->dest_type);
+   blob_write_uint32(ctx->blob, tex->texture_index);
+   blob_write_uint32(ctx->blob, tex->texture_array_size);
+   blob_write_uint32(ctx->blob, tex->sampler_index);
+
+   write_dest(ctx, &tex->dest);
+   for (unsigned i = 0; i < tex->num_srcs; i++) {
+      blob_write_uint32(ctx->blob, tex->src[i].src_type);
+      write_src(ctx, &tex->src[i].src);
+   }
+
+   write_deref_var(ctx, tex->texture);
+   write_deref_var(ctx, tex->sampler);
+}
+
+static nir_tex_instr *
+read_tex(read_ctx *ctx)
+{
+   unsigned num_srcs = blob_read_uint32(ctx->blob);
+   nir_tex_instr *tex = nir_tex_instr_create(ctx->nir, num_srcs);
+
+   unsigned packed = blob_read_uint32(ctx->blob);
+   tex->op = packed & 0xff;
+   tex->sampler_dim = (packed >> 8) & 0xff;
+   tex->coord_components = (packed >> 16) & 0xf;
+   tex->component = (packed >> 20) & 0x3;
+   tex->is_array = (packed >> 22) & 0x1;
+   tex->is_shadow = (packed >> 23) & 0x1;
+   tex->is_new_style_shadow = (packed >> 24) & 0x1;
+   tex->dest_type = blob_read_uint32(ctx->blob);
+   tex->texture_index = blob_read_uint32(ctx->blob);
+   tex->texture_array_size = blob_read_uint32(ctx->blob);
+   tex->sampler_index = blob_read_uint32(ctx->blob);
+
+   read_dest(ctx, &tex->dest, &tex->instr);
+   for (unsigned i = 0; i < tex->num_srcs; i++) {
+      tex->src[i].src_type = blob_read_uint32(ctx->blob);
+      read_src(ctx, &tex->src[i].src, &tex->instr);
+   }
+
+   tex->texture = read_deref_var(ctx, &tex->instr);
+   tex->sampler = read_deref_var(ctx, &tex->instr);
+
+   return tex;
+}
+
+static void
+write_phi(write_ctx *ctx, const nir_phi_instr *phi)
+{
+   write_dest(ctx, &phi->dest);
+
+   /* Phi sources may reference SSA values and blocks which are written
+    * later on, but write_function_impl() assigned indices to all of them
+    * before writing the body, so they can be looked up right away.
+    */
+   blob_write_uint32(ctx->blob, exec_list_length(&phi->srcs));
+   nir_foreach_phi_src(src, phi) {
+      assert(src->src.is_ssa);
+      write_object(ctx, src->src.ssa);
+      write_object(ctx, src->pred);
+   }
+}
+
+static void
+read_phi(read_ctx *ctx, nir_block *blk)
+{
+   nir_phi_instr *phi = nir_phi_instr_create(ctx->nir);
+
+   read_dest(ctx, &phi->dest, &phi->instr);
+
+   /* Just like in nir_clone, the phi has to be inserted before its sources
+    * are set up, so that nir_instr_insert() doesn't try to add the sources
+    * to the use lists of SSA values which may not exist yet.
+    */
+   nir_instr_insert_after_block(blk, &phi->instr);
+
+   unsigned num_srcs = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_srcs && !ctx->blob->overrun; i++) {
+      nir_phi_src *src = ralloc(phi, nir_phi_src);
+
+      /* Stash the indices; they are resolved in read_fixup_phis(). */
+      src->src.is_ssa = true;
+      src->src.ssa = (nir_ssa_def *)(uintptr_t) blob_read_uint32(ctx->blob);
+      src->pred = (nir_block *)(uintptr_t) blob_read_uint32(ctx->blob);
+
+      src->src.parent_instr = &phi->instr;
+      list_add(&src->src.use_link, &ctx->phi_srcs);
+
+      exec_list_push_tail(&phi->srcs, &src->node);
+   }
+}
+
+static void
+read_fixup_phis(read_ctx *ctx)
+{
+   list_for_each_entry_safe(nir_phi_src, src, &ctx->phi_srcs, src.use_link) {
+      src->pred = read_lookup_object(ctx, (uintptr_t) src->pred);
+      src->src.ssa = read_lookup_object(ctx, (uintptr_t) src->src.ssa);
+
+      /* Remove from this list */
+      list_del(&src->src.use_link);
+
+      if (src->src.ssa)
+         list_addtail(&src->src.use_link, &src->src.ssa->uses);
+      else
+         ctx->blob->overrun = true;
+   }
+   assert(list_empty(&ctx->phi_srcs));
+}
+
+static void
+write_jump(write_ctx *ctx, const nir_jump_instr *jmp)
+{
+   blob_write_uint32(ctx->blob, jmp->type);
+}
+
+static nir_jump_instr *
+read_jump(read_ctx *ctx)
+{
+   nir_jump_type type = blob_read_uint32(ctx->blob);
+   return nir_jump_instr_create(ctx->nir, type);
+}
+
+static void
+write_call(write_ctx *ctx, const nir_call_instr *call)
+{
+   write_object(ctx, call->callee);
+
+   for (unsigned i = 0; i < call->num_params; i++)
+      write_deref_chain(ctx, call->params[i]);
+
+   write_deref_var(ctx, call->return_deref);
+}
+
+static nir_call_instr *
+read_call(read_ctx *ctx)
+{
+   nir_function *callee = read_object(ctx);
+   if (callee == NULL) {
+      ctx->blob->overrun = true;
+      return NULL;
+   }
+
+   nir_call_instr *call = nir_call_instr_create(ctx->nir, callee);
+
+   for (unsigned i = 0; i < call->num_params; i++)
+      call->params[i] = read_deref_chain(ctx, &call->instr);
+
+   call->return_deref = read_deref_var(ctx, &call->instr);
+
+   return call;
+}
+
+static void
+write_instr(write_ctx *ctx, const nir_instr *instr)
+{
+   blob_write_uint32(ctx->blob, instr->type);
+   switch (instr->type) {
+   case nir_instr_type_alu:
+      write_alu(ctx, nir_instr_as_alu(instr));
+      break;
+   case nir_instr_type_intrinsic:
+      write_intrinsic(ctx, nir_instr_as_intrinsic(instr));
+      break;
+   case nir_instr_type_load_const:
+      write_load_const(ctx, nir_instr_as_load_const(instr));
+      break;
+   case nir_instr_type_ssa_undef:
+      write_ssa_undef(ctx, nir_instr_as_ssa_undef(instr));
+      break;
+   case nir_instr_type_tex:
+      write_tex(ctx, nir_instr_as_tex(instr));
+      break;
+   case nir_instr_type_phi:
+      write_phi(ctx, nir_instr_as_phi(instr));
+      break;
+   case nir_instr_type_jump:
+      write_jump(ctx, nir_instr_as_jump(instr));
+      break;
+   case nir_instr_type_call:
+      write_call(ctx, nir_instr_as_call(instr));
+      break;
+   case nir_instr_type_parallel_copy:
+      unreachable("Cannot write parallel copies");
+   default:
+      unreachable("bad instr type");
+   }
+}
+
+static void
+read_instr(read_ctx *ctx, nir_block *block)
+{
+   nir_instr_type type = blob_read_uint32(ctx->blob);
+   nir_instr *instr;
+   switch (type) {
+   case nir_instr_type_alu: {
+      nir_alu_instr *alu = read_alu(ctx);
+      instr = alu ? &alu->instr : NULL;
+      break;
+   }
+   case nir_instr_type_intrinsic: {
+      nir_intrinsic_instr *intrin = read_intrinsic(ctx);
+      instr = intrin ? &intrin->instr : NULL;
+      break;
+   }
+   case nir_instr_type_load_const: {
+      nir_load_const_instr *lc = read_load_const(ctx);
+      instr = lc ? &lc->instr : NULL;
+      break;
+   }
+   case nir_instr_type_ssa_undef:
+      instr = &read_ssa_undef(ctx)->instr;
+      break;
+   case nir_instr_type_tex:
+      instr = &read_tex(ctx)->instr;
+      break;
+   case nir_instr_type_phi:
+      /* Phis insert themselves, see read_phi(). */
+      read_phi(ctx, block);
+      return;
+   case nir_instr_type_jump:
+      instr = &read_jump(ctx)->instr;
+      break;
+   case nir_instr_type_call: {
+      nir_call_instr *call = read_call(ctx);
+      instr = call ? &call->instr : NULL;
+      break;
+   }
+   default:
+      ctx->blob->overrun = true;
+      return;
+   }
+
+   /* Don't try to hook up use/def chains of a half-read instruction. */
+   if (instr == NULL || ctx->blob->overrun)
+      return;
+
+   nir_instr_insert_after_block(block, instr);
+}
+
+static void
+write_block(write_ctx *ctx, const nir_block *block)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(&block->instr_list));
+   nir_foreach_instr(instr, block)
+      write_instr(ctx, instr);
+}
+
+static void
+read_block(read_ctx *ctx, struct exec_list *cf_list)
+{
+   /* Don't actually create a new block.  Just use the one from the tail of
+    * the list.  NIR guarantees that the tail of the list is a block and that
+    * no two blocks are side-by-side in the IR;  It should be empty.
+    */
+   nir_block *block =
+      exec_node_data(nir_block, exec_list_get_tail(cf_list), cf_node.node);
+   assert(block->cf_node.type == nir_cf_node_block);
+   assert(exec_list_is_empty(&block->instr_list));
+
+   read_add_object(ctx, block);
+   unsigned num_instrs = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_instrs && !ctx->blob->overrun; i++)
+      read_instr(ctx, block);
+}
+
+static void
+write_cf_list(write_ctx *ctx, const struct exec_list *cf_list);
+
+static void
+read_cf_list(read_ctx *ctx, struct exec_list *cf_list);
+
+static void
+write_if(write_ctx *ctx, nir_if *nif)
+{
+   write_src(ctx, &nif->condition);
+
+   write_cf_list(ctx, &nif->then_list);
+   write_cf_list(ctx, &nif->else_list);
+}
+
+static void
+read_if(read_ctx *ctx, struct exec_list *cf_list)
+{
+   nir_if *nif = nir_if_create(ctx->nir);
+
+   read_src(ctx, &nif->condition, nif);
+
+   nir_cf_node_insert_end(cf_list, &nif->cf_node);
+
+   read_cf_list(ctx, &nif->then_list);
+   read_cf_list(ctx, &nif->else_list);
+}
+
+static void
+write_loop(write_ctx *ctx, nir_loop *loop)
+{
+   write_cf_list(ctx, &loop->body);
+}
+
+static void
+read_loop(read_ctx *ctx, struct exec_list *cf_list)
+{
+   nir_loop *loop = nir_loop_create(ctx->nir);
+
+   nir_cf_node_insert_end(cf_list, &loop->cf_node);
+
+   read_cf_list(ctx, &loop->body);
+}
+
+static void
+write_cf_node(write_ctx *ctx, nir_cf_node *cf)
+{
+   blob_write_uint32(ctx->blob, cf->type);
+
+   switch (cf->type) {
+   case nir_cf_node_block:
+      write_block(ctx, nir_cf_node_as_block(cf));
+      break;
+   case nir_cf_node_if:
+      write_if(ctx, nir_cf_node_as_if(cf));
+      break;
+   case nir_cf_node_loop:
+      write_loop(ctx, nir_cf_node_as_loop(cf));
+      break;
+   default:
+      unreachable("bad cf type");
+   }
+}
+
+static void
+read_cf_node(read_ctx *ctx, struct exec_list *list)
+{
+   nir_cf_node_type type = blob_read_uint32(ctx->blob);
+
+   switch (type) {
+   case nir_cf_node_block:
+      read_block(ctx, list);
+      break;
+   case nir_cf_node_if:
+      read_if(ctx, list);
+      break;
+   case nir_cf_node_loop:
+      read_loop(ctx, list);
+      break;
+   default:
+      ctx->blob->overrun = true;
+   }
+}
+
+static void
+write_cf_list(write_ctx *ctx, const struct exec_list *cf_list)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(cf_list));
+   foreach_list_typed(nir_cf_node, cf, node, cf_list)
+      write_cf_node(ctx, cf);
+}
+
+static void
+read_cf_list(read_ctx *ctx, struct exec_list *cf_list)
+{
+   uint32_t num_cf_nodes = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_cf_nodes && !ctx->blob->overrun; i++)
+      read_cf_node(ctx, cf_list);
+}
+
+static bool
+write_add_ssa_def(nir_ssa_def *def, void *state)
+{
+   write_add_object(state, def);
+   return true;
+}
+
+static void
+write_function_impl(write_ctx *ctx, const nir_function_impl *fi)
+{
+   write_var_list(ctx, &fi->locals);
+   write_reg_list(ctx, &fi->registers);
+   blob_write_uint32(ctx->blob, fi->reg_alloc);
+
+   blob_write_uint32(ctx->blob, fi->num_params);
+   for (unsigned i = 0; i < fi->num_params; i++)
+      write_variable(ctx, fi->params[i]);
+
+   blob_write_uint32(ctx->blob, fi->return_var != NULL);
+   if (fi->return_var)
+      write_variable(ctx, fi->return_var);
+
+   /* Hand out indices to all the blocks and SSA values up front, so that
+    * phi sources can refer to values defined further down.  The reader
+    * visits them in the same order while it builds the body, so the indices
+    * match without any fixups on this side.
+    */
+   nir_foreach_block(block, (nir_function_impl *) fi) {
+      write_add_object(ctx, block);
+      nir_foreach_instr(instr, block)
+         nir_foreach_ssa_def(instr, write_add_ssa_def, ctx);
+   }
+
+   write_cf_list(ctx, &fi->body);
+}
+
+static nir_function_impl *
+read_function_impl(read_ctx *ctx, nir_function *fxn)
+{
+   nir_function_impl *fi = nir_function_impl_create_bare(ctx->nir);
+   fi->function = fxn;
+
+   read_var_list(ctx, &fi->locals);
+   read_reg_list(ctx, &fi->registers);
+   fi->reg_alloc = blob_read_uint32(ctx->blob);
+
+   fi->num_params = blob_read_uint32(ctx->blob);
+   fi->params = ralloc_array(ctx->nir, nir_variable *, fi->num_params);
+   for (unsigned i = 0; i < fi->num_params && !ctx->blob->overrun; i++)
+      fi->params[i] = read_variable(ctx);
+
+   if (blob_read_uint32(ctx->blob))
+      fi->return_var = read_variable(ctx);
+
+   assert(list_empty(&ctx->phi_srcs));
+
+   read_cf_list(ctx, &fi->body);
+
+   read_fixup_phis(ctx);
+
+   if (!ctx->blob->overrun)
+      nir_index_ssa_defs(fi);
+
+   fi->valid_metadata = 0;
+
+   return fi;
+}
+
+static void
+write_function(write_ctx *ctx, const nir_function *fxn)
+{
+   write_add_object(ctx, fxn);
+
+   write_string(ctx, fxn->name);
+
+   blob_write_uint32(ctx->blob, fxn->num_params);
+   for (unsigned i = 0; i < fxn->num_params; i++) {
+      blob_write_uint32(ctx->blob, fxn->params[i].param_type);
+      encode_type_to_blob(ctx->blob, fxn->params[i].type);
+   }
+
+   /* encode_type_to_blob() can't handle void, which is what almost all
+    * functions return.
+    */
+   bool returns_value = !glsl_type_is_void(fxn->return_type);
+   blob_write_uint32(ctx->blob, returns_value);
+   if (returns_value)
+      encode_type_to_blob(ctx->blob, fxn->return_type);
+
+   /* At first glance, it looks like we should write the function_impl here.
+    * However, call instructions need to be able to reference at least the
+    * function and those will get processed as we write the function_impls.
+    * We stop here and write function_impls as a second pass.
+    */
+}
+
+static void
+read_function(read_ctx *ctx)
+{
+   const char *name = NULL;
+   if (blob_read_uint32(ctx->blob))
+      name = blob_read_string(ctx->blob);
+
+   nir_function *fxn = nir_function_create(ctx->nir, name);
+
+   read_add_object(ctx, fxn);
+
+   fxn->num_params = blob_read_uint32(ctx->blob);
+   fxn->params = ralloc_array(fxn, nir_parameter, fxn->num_params);
+   for (unsigned i = 0; i < fxn->num_params && !ctx->blob->overrun; i++) {
+      fxn->params[i].param_type = blob_read_uint32(ctx->blob);
+      fxn->params[i].type = decode_type_from_blob(ctx->blob);
+   }
+
+   /* nir_function_create() made it return void. */
+   if (blob_read_uint32(ctx->blob))
+      fxn->return_type = decode_type_from_blob(ctx->blob);
+}
+
+/**
+ * Serialize NIR into a binary blob.
+ *
+ * The shader must not contain any parallel copies; the usual place to call
+ * this is right after optimization, before the backend goes out of SSA.
+ */
+void
+nir_serialize(struct blob *blob, const nir_shader *nir)
+{
+   write_ctx ctx;
+   ctx.nir = nir;
+   ctx.blob = blob;
+   ctx.remap_table = _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+                                             _mesa_key_pointer_equal);
+   ctx.next_idx = 1;
+
+   /* Written once we know how many objects there are. */
+   blob_write_uint32(blob, 0);
+   size_t idx_size_offset = blob->size - sizeof(uint32_t);
+
+   blob_write_uint32(blob, nir->stage);
+
+   struct shader_info info = *nir->info;
+   uint32_t strings = 0;
+   if (info.name)
+      strings |= 0x1;
+   if (info.label)
+      strings |= 0x2;
+   blob_write_uint32(blob, strings);
+   if (info.name)
+      blob_write_string(blob, info.name);
+   if (info.label)
+      blob_write_string(blob, info.label);
+   info.name = info.label = NULL;
+   blob_write_bytes(blob, (uint8_t *) &info, sizeof(info));
+
+   write_var_list(&ctx, &nir->uniforms);
+   write_var_list(&ctx, &nir->inputs);
+   write_var_list(&ctx, &nir->outputs);
+   write_var_list(&ctx, &nir->shared);
+   write_var_list(&ctx, &nir->globals);
+   write_var_list(&ctx, &nir->system_values);
+
+   write_reg_list(&ctx, &nir->registers);
+   blob_write_uint32(blob, nir->reg_alloc);
+   blob_write_uint32(blob, nir->num_inputs);
+   blob_write_uint32(blob, nir->num_uniforms);
+   blob_write_uint32(blob, nir->num_outputs);
+   blob_write_uint32(blob, nir->num_shared);
+
+   blob_write_uint32(blob, exec_list_length(&nir->functions));
+   nir_foreach_function(fxn, nir) {
+      write_function(&ctx, fxn);
+   }
+
+   nir_foreach_function(fxn, nir) {
+      blob_write_uint32(blob, fxn->impl != NULL);
+      if (fxn->impl)
+         write_function_impl(&ctx, fxn->impl);
+   }
+
+   blob_overwrite_uint32(blob, idx_size_offset, ctx.next_idx);
+
+   _mesa_hash_table_destroy(ctx.remap_table, NULL);
+}
+
+/**
+ * Create a shader from a blob written by nir_serialize().
+ *
+ * Returns NULL if the blob is truncated or otherwise malformed, in which
+ * case \p blob->overrun is also set.
+ */
+nir_shader *
+nir_deserialize(void *mem_ctx,
+                const struct nir_shader_compiler_options *options,
+                struct blob_reader *blob)
+{
+   read_ctx ctx;
+   ctx.blob = blob;
+   list_inithead(&ctx.phi_srcs);
+   ctx.num_object_ids = blob_read_uint32(blob);
+   ctx.next_idx = 1;
+   if (blob->overrun || ctx.num_object_ids == 0)
+      return NULL;
+
+   /* Every object takes up at least a word in the blob, which bounds how
+    * large a table a corrupt item can make us allocate.
+    */
+   if (ctx.num_object_ids > (blob->end - blob->current) / sizeof(uint32_t)) {
+      blob->overrun = true;
+      return NULL;
+   }
+
+   ctx.idx_table = calloc(ctx.num_object_ids, sizeof(void *));
+   if (ctx.idx_table == NULL)
+      return NULL;
+
+   gl_shader_stage stage = blob_read_uint32(blob);
+   ctx.nir = nir_shader_create(mem_ctx, stage, options, NULL);
+
+   uint32_t strings = blob_read_uint32(blob);
+   char *name = (strings & 0x1) ? blob_read_string(blob) : NULL;
+   char *label = (strings & 0x2) ? blob_read_string(blob) : NULL;
+   blob_copy_bytes(blob, (uint8_t *) ctx.nir->info, sizeof(*ctx.nir->info));
+   ctx.nir->info->name = name ? ralloc_strdup(ctx.nir, name) : NULL;
+   ctx.nir->info->label = label ? ralloc_strdup(ctx.nir, label) : NULL;
+
+   read_var_list(&ctx, &ctx.nir->uniforms);
+   read_var_list(&ctx, &ctx.nir->inputs);
+   read_var_list(&ctx, &ctx.nir->outputs);
+   read_var_list(&ctx, &ctx.nir->shared);
+   read_var_list(&ctx, &ctx.nir->globals);
+   read_var_list(&ctx, &ctx.nir->system_values);
+
+   read_reg_list(&ctx, &ctx.nir->registers);
+   ctx.nir->reg_alloc = blob_read_uint32(blob);
+   ctx.nir->num_inputs = blob_read_uint32(blob);
+   ctx.nir->num_uniforms = blob_read_uint32(blob);
+   ctx.nir->num_outputs = blob_read_uint32(blob);
+   ctx.nir->num_shared = blob_read_uint32(blob);
+
+   unsigned num_functions = blob_read_uint32(blob);
+   for (unsigned i = 0; i < num_functions && !blob->overrun; i++)
+      read_function(&ctx);
+
+   nir_foreach_function(fxn, ctx.nir) {
+      if (blob->overrun)
+         break;
+      if (blob_read_uint32(blob))
+         fxn->impl = read_function_impl(&ctx, fxn);
+   }
+
+   free(ctx.idx_table);
+
+   if (blob->overrun) {
+      ralloc_free(ctx.nir);
+      return NULL;
+   }
+
+   return ctx.nir;
+}
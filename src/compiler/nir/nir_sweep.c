@@ -33,6 +33,10 @@
  * The expectation is that drivers should call this when finished compiling the shader
  * (after any optimization, lowering, and so on).  However, it's also fine to call it
  * earlier, and even many times, trading CPU cycles for memory savings.
+ *
+ * Shaders allocate from a ralloc pool (see nir_shader_create), so freeing the dead
+ * memory just puts it on the pool's free lists, where later allocations pick it up.
+ * The pool itself is only released with the shader.
  */
 
 #define steal_list(mem_ctx, type, list) \
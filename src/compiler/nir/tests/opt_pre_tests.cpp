@@ -0,0 +1,255 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <gtest/gtest.h>
+#include "nir.h"
+#include "nir_builder.h"
+
+class nir_opt_pre_test : public ::testing::Test {
+protected:
+   nir_opt_pre_test();
+   ~nir_opt_pre_test();
+
+   bool run_pre();
+   void add_break_if(nir_ssa_def *cond);
+
+   nir_builder b;
+   nir_variable *out;
+   nir_variable *counter;
+   nir_ssa_def *x, *y;
+};
+
+nir_opt_pre_test::nir_opt_pre_test()
+{
+   static const nir_shader_compiler_options options = { };
+   nir_builder_init_simple_shader(&b, NULL, MESA_SHADER_FRAGMENT, &options);
+
+   nir_variable *in_x = nir_variable_create(b.shader, nir_var_shader_in,
+                                            glsl_float_type(), "in_x");
+   nir_variable *in_y = nir_variable_create(b.shader, nir_var_shader_in,
+                                            glsl_float_type(), "in_y");
+   out = nir_variable_create(b.shader, nir_var_shader_out,
+                             glsl_float_type(), "out");
+   counter = nir_local_variable_create(b.impl, glsl_float_type(), "counter");
+
+   x = nir_load_var(&b, in_x);
+   y = nir_load_var(&b, in_y);
+}
+
+nir_opt_pre_test::~nir_opt_pre_test()
+{
+   ralloc_free(b.shader);
+}
+
+bool
+nir_opt_pre_test::run_pre()
+{
+   nir_validate_shader(b.shader);
+   bool progress = nir_opt_pre(b.shader);
+   nir_validate_shader(b.shader);
+   return progress;
+}
+
+/* Adds "if (cond) break;" at the cursor. */
+void
+nir_opt_pre_test::add_break_if(nir_ssa_def *cond)
+{
+   nir_push_if(&b, cond);
+   nir_jump_instr *brk = nir_jump_instr_create(b.shader, nir_jump_break);
+   nir_builder_instr_insert(&b, &brk->instr);
+   nir_pop_if(&b, NULL);
+}
+
+static nir_block *
+block_before(nir_cf_node *node)
+{
+   return nir_cf_node_as_block(nir_cf_node_prev(node));
+}
+
+static unsigned
+count_alu(nir_shader *shader, nir_op op)
+{
+   unsigned count = 0;
+
+   nir_foreach_block(block, nir_shader_get_entrypoint(shader)) {
+      nir_foreach_instr(instr, block) {
+         if (instr->type == nir_instr_type_alu &&
+             nir_instr_as_alu(instr)->op == op)
+            count++;
+      }
+   }
+   return count;
+}
+
+TEST_F(nir_opt_pre_test, loop_invariant)
+{
+   /* loop {
+    *    c = counter + x * y;
+    *    counter = c;
+    *    if (c >= x + 2.0) break;
+    * }
+    */
+   nir_loop *loop = nir_push_loop(&b);
+   nir_ssa_def *inv = nir_fmul(&b, x, y);
+   nir_ssa_def *c = nir_fadd(&b, nir_load_var(&b, counter), inv);
+   nir_store_var(&b, counter, c, 0x1);
+   nir_ssa_def *limit = nir_fadd(&b, x, nir_imm_float(&b, 2.0));
+   add_break_if(nir_fge(&b, c, limit));
+   nir_pop_loop(&b, loop);
+   nir_store_var(&b, out, nir_load_var(&b, counter), 0x1);
+
+   EXPECT_TRUE(run_pre());
+
+   nir_block *preheader = block_before(&loop->cf_node);
+   EXPECT_EQ(preheader, inv->parent_instr->block);
+   EXPECT_EQ(preheader, limit->parent_instr->block);
+
+   /* The constant used by the hoisted add is copied along with it. */
+   nir_alu_instr *add = nir_instr_as_alu(limit->parent_instr);
+   EXPECT_TRUE(nir_block_dominates(add->src[1].src.ssa->parent_instr->block,
+                                   preheader));
+
+   /* Anything depending on the loop stays in it. */
+   EXPECT_EQ(nir_loop_first_block(loop), c->parent_instr->block);
+
+   EXPECT_FALSE(run_pre());
+}
+
+TEST_F(nir_opt_pre_test, loop_invariant_in_if)
+{
+   /* loop {
+    *    c = counter + 1.0;
+    *    counter = c;
+    *    if (c < 4.0)
+    *       out = x * y;
+    *    else
+    *       break;
+    * }
+    *
+    * x * y is only computed when the branch is taken, hoisting it would be
+    * speculative.
+    */
+   nir_loop *loop = nir_push_loop(&b);
+   nir_ssa_def *c = nir_fadd(&b, nir_load_var(&b, counter),
+                             nir_imm_float(&b, 1.0));
+   nir_store_var(&b, counter, c, 0x1);
+   nir_if *nif = nir_push_if(&b, nir_flt(&b, c, nir_imm_float(&b, 4.0)));
+   nir_ssa_def *inv = nir_fmul(&b, x, y);
+   nir_store_var(&b, out, inv, 0x1);
+   nir_push_else(&b, nif);
+   nir_jump_instr *brk = nir_jump_instr_create(b.shader, nir_jump_break);
+   nir_builder_instr_insert(&b, &brk->instr);
+   nir_pop_if(&b, nif);
+   nir_pop_loop(&b, loop);
+
+   nir_block *then_block = inv->parent_instr->block;
+
+   EXPECT_FALSE(run_pre());
+   EXPECT_EQ(then_block, inv->parent_instr->block);
+}
+
+TEST_F(nir_opt_pre_test, nested_loop_invariant)
+{
+   /* loop {
+    *    loop {
+    *       c = counter + x * y;
+    *       counter = c;
+    *       if (c >= 8.0) break;
+    *    }
+    *    if (counter >= 16.0) break;
+    * }
+    *
+    * x * y goes to the block before the inner loop, which is in the body
+    * of the outer loop, and from there to the block before the outer loop.
+    */
+   nir_loop *outer = nir_push_loop(&b);
+   nir_loop *inner = nir_push_loop(&b);
+   nir_ssa_def *inv = nir_fmul(&b, x, y);
+   nir_ssa_def *c = nir_fadd(&b, nir_load_var(&b, counter), inv);
+   nir_store_var(&b, counter, c, 0x1);
+   add_break_if(nir_fge(&b, c, nir_imm_float(&b, 8.0)));
+   nir_pop_loop(&b, inner);
+   add_break_if(nir_fge(&b, nir_load_var(&b, counter),
+                        nir_imm_float(&b, 16.0)));
+   nir_pop_loop(&b, outer);
+
+   EXPECT_TRUE(run_pre());
+   EXPECT_EQ(block_before(&outer->cf_node), inv->parent_instr->block);
+   EXPECT_EQ(nir_loop_first_block(inner), c->parent_instr->block);
+}
+
+TEST_F(nir_opt_pre_test, if_else_common)
+{
+   /* if (x < y) out = x + y; else out = (x + y) * 2.0; */
+   nir_if *nif = nir_push_if(&b, nir_flt(&b, x, y));
+   nir_ssa_def *then_add = nir_fadd(&b, x, y);
+   nir_store_var(&b, out, then_add, 0x1);
+   nir_push_else(&b, nif);
+   nir_ssa_def *else_add = nir_fadd(&b, x, y);
+   nir_ssa_def *mul = nir_fmul(&b, else_add, nir_imm_float(&b, 2.0));
+   nir_store_var(&b, out, mul, 0x1);
+   nir_pop_if(&b, nif);
+
+   EXPECT_TRUE(run_pre());
+
+   EXPECT_EQ(1u, count_alu(b.shader, nir_op_fadd));
+   EXPECT_EQ(block_before(&nif->cf_node), then_add->parent_instr->block);
+
+   nir_alu_instr *mul_alu = nir_instr_as_alu(mul->parent_instr);
+   EXPECT_EQ(then_add, mul_alu->src[0].src.ssa);
+   EXPECT_EQ(nir_if_first_else_block(nif), mul->parent_instr->block);
+
+   EXPECT_FALSE(run_pre());
+}
+
+TEST_F(nir_opt_pre_test, if_else_different)
+{
+   /* if (x < y) out = x + y; else out = x * y; */
+   nir_if *nif = nir_push_if(&b, nir_flt(&b, x, y));
+   nir_ssa_def *add = nir_fadd(&b, x, y);
+   nir_store_var(&b, out, add, 0x1);
+   nir_push_else(&b, nif);
+   nir_ssa_def *mul = nir_fmul(&b, x, y);
+   nir_store_var(&b, out, mul, 0x1);
+   nir_pop_if(&b, nif);
+
+   EXPECT_FALSE(run_pre());
+   EXPECT_EQ(nir_if_first_then_block(nif), add->parent_instr->block);
+   EXPECT_EQ(nir_if_first_else_block(nif), mul->parent_instr->block);
+}
+
+TEST_F(nir_opt_pre_test, if_else_derivative)
+{
+   /* Derivatives are only defined in uniform control flow, so they must
+    * not be moved even when both branches compute the same one.
+    */
+   nir_if *nif = nir_push_if(&b, nir_flt(&b, x, y));
+   nir_ssa_def *then_ddx = nir_fddx(&b, x);
+   nir_store_var(&b, out, then_ddx, 0x1);
+   nir_push_else(&b, nif);
+   nir_ssa_def *else_ddx = nir_fddx(&b, x);
+   nir_store_var(&b, out, nir_fneg(&b, else_ddx), 0x1);
+   nir_pop_if(&b, nif);
+
+   EXPECT_FALSE(run_pre());
+   EXPECT_EQ(2u, count_alu(b.shader, nir_op_fddx));
+}
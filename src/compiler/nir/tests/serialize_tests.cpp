@@ -0,0 +1,194 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <gtest/gtest.h>
+#include "nir.h"
+#include "nir_builder.h"
+#include "nir_serialize.h"
+
+class nir_serialize_test : public ::testing::Test {
+protected:
+   nir_serialize_test();
+   ~nir_serialize_test();
+
+   nir_shader *serialize_and_deserialize();
+
+   nir_builder b;
+   nir_variable *out;
+};
+
+static const nir_shader_compiler_options options = { };
+
+nir_serialize_test::nir_serialize_test()
+{
+   nir_builder_init_simple_shader(&b, NULL, MESA_SHADER_FRAGMENT, &options);
+   out = nir_variable_create(b.shader, nir_var_shader_out,
+                             glsl_vec4_type(), "out");
+}
+
+nir_serialize_test::~nir_serialize_test()
+{
+   ralloc_free(b.shader);
+}
+
+nir_shader *
+nir_serialize_test::serialize_and_deserialize()
+{
+   struct blob *blob = blob_create();
+   struct blob_reader reader;
+
+   nir_validate_shader(b.shader);
+   nir_serialize(blob, b.shader);
+
+   blob_reader_init(&reader, blob->data, blob->size);
+   nir_shader *copy = nir_deserialize(b.shader, &options, &reader);
+   EXPECT_FALSE(reader.overrun);
+   EXPECT_EQ(reader.current, reader.end);
+
+   blob_destroy(blob);
+   return copy;
+}
+
+static unsigned
+count_instrs(nir_shader *shader, nir_instr_type type)
+{
+   unsigned count = 0;
+
+   nir_foreach_block(block, nir_shader_get_entrypoint(shader)) {
+      nir_foreach_instr(instr, block) {
+         if (instr->type == type)
+            count++;
+      }
+   }
+   return count;
+}
+
+static nir_instr *
+src_instr(const nir_src *src)
+{
+   EXPECT_TRUE(src->is_ssa);
+   EXPECT_NE((void *) NULL, src->ssa);
+   return src->ssa->parent_instr;
+}
+
+/* Constants and undefs must keep their uses, including from phis that
+ * refer to values defined further down in the shader.
+ */
+TEST_F(nir_serialize_test, load_const_undef_phi)
+{
+   nir_ssa_def *c = nir_imm_vec4(&b, 1.0, 2.0, 3.0, 4.0);
+   nir_ssa_def *undef = nir_ssa_undef(&b, 4, 32);
+
+   nir_push_if(&b, nir_imm_int(&b, 1));
+   nir_ssa_def *then_def = nir_fadd(&b, c, c);
+   nir_push_else(&b, NULL);
+   nir_ssa_def *else_def = nir_fmul(&b, c, undef);
+   nir_pop_if(&b, NULL);
+   nir_ssa_def *if_phi = nir_if_phi(&b, then_def, else_def);
+
+   /* loop { phi = (c, sum); sum = phi + c; if (sum.x < 0) break; } */
+   nir_block *before_loop = nir_cursor_current_block(b.cursor);
+   nir_loop *loop = nir_push_loop(&b);
+   nir_phi_instr *loop_phi = nir_phi_instr_create(b.shader);
+   nir_ssa_dest_init(&loop_phi->instr, &loop_phi->dest, 4, 32, NULL);
+   nir_builder_instr_insert(&b, &loop_phi->instr);
+   nir_ssa_def *sum = nir_fadd(&b, &loop_phi->dest.ssa, c);
+   nir_push_if(&b, nir_flt(&b, nir_channel(&b, sum, 0),
+                           nir_imm_float(&b, 0.0)));
+   nir_jump_instr *brk = nir_jump_instr_create(b.shader, nir_jump_break);
+   nir_builder_instr_insert(&b, &brk->instr);
+   nir_pop_if(&b, NULL);
+   nir_pop_loop(&b, loop);
+
+   /* The phi is already in the shader, so add its sources with their uses. */
+   nir_phi_src *phi_src = rzalloc(loop_phi, nir_phi_src);
+   phi_src->pred = before_loop;
+   exec_list_push_tail(&loop_phi->srcs, &phi_src->node);
+   nir_instr_rewrite_src(&loop_phi->instr, &phi_src->src, nir_src_for_ssa(c));
+   phi_src = rzalloc(loop_phi, nir_phi_src);
+   phi_src->pred = nir_loop_last_block(loop);
+   exec_list_push_tail(&loop_phi->srcs, &phi_src->node);
+   nir_instr_rewrite_src(&loop_phi->instr, &phi_src->src, nir_src_for_ssa(sum));
+
+   nir_store_var(&b, out, nir_fadd(&b, if_phi, sum), 0xf);
+
+   nir_shader *copy = serialize_and_deserialize();
+   ASSERT_NE((void *) NULL, copy);
+   nir_validate_shader(copy);
+
+   nir_function_impl *impl = nir_shader_get_entrypoint(copy);
+   ASSERT_NE((void *) NULL, impl);
+
+   nir_foreach_block(block, impl) {
+      nir_foreach_instr(instr, block) {
+         if (instr->type == nir_instr_type_phi) {
+            nir_foreach_phi_src(src, nir_instr_as_phi(instr))
+               src_instr(&src->src);
+         } else if (instr->type == nir_instr_type_alu) {
+            nir_alu_instr *alu = nir_instr_as_alu(instr);
+            for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++)
+               src_instr(&alu->src[i].src);
+            if (alu->op == nir_op_fmul) {
+               EXPECT_EQ(nir_instr_type_load_const,
+                         src_instr(&alu->src[0].src)->type);
+               EXPECT_EQ(nir_instr_type_ssa_undef,
+                         src_instr(&alu->src[1].src)->type);
+            }
+         }
+      }
+   }
+
+   static const nir_instr_type types[] = {
+      nir_instr_type_alu,
+      nir_instr_type_intrinsic,
+      nir_instr_type_load_const,
+      nir_instr_type_jump,
+      nir_instr_type_ssa_undef,
+      nir_instr_type_phi,
+   };
+   for (unsigned i = 0; i < ARRAY_SIZE(types); i++) {
+      EXPECT_EQ(count_instrs(b.shader, types[i]),
+                count_instrs(copy, types[i]));
+   }
+}
+
+/* Functions which don't return anything have a void return type, which
+ * the glsl_type blob encoding doesn't handle.
+ */
+TEST_F(nir_serialize_test, function_return_types)
+{
+   nir_function *f = nir_function_create(b.shader, "f");
+   f->return_type = glsl_float_type();
+
+   nir_store_var(&b, out, nir_imm_vec4(&b, 0.0, 0.0, 0.0, 0.0), 0xf);
+
+   nir_shader *copy = serialize_and_deserialize();
+   ASSERT_NE((void *) NULL, copy);
+   nir_validate_shader(copy);
+
+   nir_foreach_function(fxn, copy) {
+      if (strcmp(fxn->name, "main") == 0)
+         EXPECT_EQ(glsl_void_type(), fxn->return_type);
+      else
+         EXPECT_EQ(glsl_float_type(), fxn->return_type);
+   }
+}
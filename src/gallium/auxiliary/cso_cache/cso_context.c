@@ -61,6 +61,24 @@ struct sampler_info
 };
 
 
+#define CSO_RECENT_STATES 4
+
+/**
+ * The most recently used states of one kind, most recent first.
+ *
+ * Applications tend to switch between a handful of blend, depth/stencil,
+ * rasterizer and vertex element states.  Comparing the template against
+ * these is much cheaper than hashing it and walking the hash bucket.
+ * state points to the template copy kept in the cso, so entries are only
+ * valid while the cso is in the cache.
+ */
+struct cso_recent_states
+{
+   const void *state[CSO_RECENT_STATES];
+   void *handle[CSO_RECENT_STATES];
+};
+
+
 
 struct cso_context {
    struct pipe_context *pipe;
@@ -112,6 +130,11 @@ struct cso_context {
    void *tesseval_shader, *tesseval_shader_saved;
    void *compute_shader;
    void *velements, *velements_saved;
+
+   struct cso_recent_states recent_blend;
+   struct cso_recent_states recent_depth_stencil;
+   struct cso_recent_states recent_rasterizer;
+   struct cso_recent_states recent_velements;
    struct pipe_query *render_condition, *render_condition_saved;
    uint render_condition_mode, render_condition_mode_saved;
    boolean render_condition_cond, render_condition_cond_saved;
@@ -125,6 +148,47 @@ struct cso_context {
 };
 
 
+/**
+ * Look for templ among the recently used states.  On a hit the entry is
+ * moved to the front and its driver handle is returned.
+ */
+static inline boolean
+cso_recent_lookup(struct cso_recent_states *recent, const void *templ,
+                  unsigned key_size, void **handle)
+{
+   unsigned i;
+
+   for (i = 0; i < CSO_RECENT_STATES && recent->state[i]; i++) {
+      if (memcmp(recent->state[i], templ, key_size) == 0) {
+         const void *state = recent->state[i];
+
+         *handle = recent->handle[i];
+         for (; i > 0; i--) {
+            recent->state[i] = recent->state[i - 1];
+            recent->handle[i] = recent->handle[i - 1];
+         }
+         recent->state[0] = state;
+         recent->handle[0] = *handle;
+         return TRUE;
+      }
+   }
+   return FALSE;
+}
+
+static inline void
+cso_recent_add(struct cso_recent_states *recent, const void *state,
+               void *handle)
+{
+   unsigned i;
+
+   for (i = CSO_RECENT_STATES - 1; i > 0; i--) {
+      recent->state[i] = recent->state[i - 1];
+      recent->handle[i] = recent->handle[i - 1];
+   }
+   recent->state[0] = state;
+   recent->handle[0] = handle;
+}
+
 static boolean delete_blend_state(struct cso_context *ctx, void *state)
 {
    struct cso_blend *cso = (struct cso_blend *)state;
@@ -230,6 +294,25 @@ sanitize_hash(struct cso_hash *hash, enum cso_cache_type type,
    if (to_remove == 0)
       return;
 
+   /* Any of the recently used states may be deleted below. */
+   switch (type) {
+   case CSO_BLEND:
+      memset(&ctx->recent_blend, 0, sizeof(ctx->recent_blend));
+      break;
+   case CSO_DEPTH_STENCIL_ALPHA:
+      memset(&ctx->recent_depth_stencil, 0,
+             sizeof(ctx->recent_depth_stencil));
+      break;
+   case CSO_RASTERIZER:
+      memset(&ctx->recent_rasterizer, 0, sizeof(ctx->recent_rasterizer));
+      break;
+   case CSO_VELEMENTS:
+      memset(&ctx->recent_velements, 0, sizeof(ctx->recent_velements));
+      break;
+   default:
+      break;
+   }
+
    if (type == CSO_SAMPLER) {
       int i, j;
 
@@ -455,6 +538,10 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
    key_size = templ->independent_blend_enable ?
       sizeof(struct pipe_blend_state) :
       (char *)&(templ->rt[1]) - (char *)templ;
+
+   if (cso_recent_lookup(&ctx->recent_blend, templ, key_size, &handle))
+      goto bind;
+
    hash_key = cso_construct_key((void*)templ, key_size);
    iter = cso_find_state_template(ctx->cache, hash_key, CSO_BLEND,
                                   (void*)templ, key_size);
@@ -477,11 +564,15 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
       }
 
       handle = cso->data;
+      cso_recent_add(&ctx->recent_blend, &cso->state, handle);
    }
    else {
-      handle = ((struct cso_blend *)cso_hash_iter_data(iter))->data;
+      struct cso_blend *cso = (struct cso_blend *)cso_hash_iter_data(iter);
+      handle = cso->data;
+      cso_recent_add(&ctx->recent_blend, &cso->state, handle);
    }
 
+bind:
    if (ctx->blend != handle) {
       ctx->blend = handle;
       ctx->pipe->bind_blend_state(ctx->pipe, handle);
@@ -513,13 +604,19 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
                             const struct pipe_depth_stencil_alpha_state *templ)
 {
    unsigned key_size = sizeof(struct pipe_depth_stencil_alpha_state);
-   unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_DEPTH_STENCIL_ALPHA,
-                                                       (void*)templ, key_size);
+   unsigned hash_key;
+   struct cso_hash_iter iter;
    void *handle;
 
+   if (cso_recent_lookup(&ctx->recent_depth_stencil, templ, key_size,
+                         &handle))
+      goto bind;
+
+   hash_key = cso_construct_key((void*)templ, key_size);
+   iter = cso_find_state_template(ctx->cache, hash_key,
+                                  CSO_DEPTH_STENCIL_ALPHA,
+                                  (void*)templ, key_size);
+
    if (cso_hash_iter_is_null(iter)) {
       struct cso_depth_stencil_alpha *cso =
          MALLOC(sizeof(struct cso_depth_stencil_alpha));
@@ -541,12 +638,16 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
       }
 
       handle = cso->data;
+      cso_recent_add(&ctx->recent_depth_stencil, &cso->state, handle);
    }
    else {
-      handle = ((struct cso_depth_stencil_alpha *)
-                cso_hash_iter_data(iter))->data;
+      struct cso_depth_stencil_alpha *cso =
+         (struct cso_depth_stencil_alpha *)cso_hash_iter_data(iter);
+      handle = cso->data;
+      cso_recent_add(&ctx->recent_depth_stencil, &cso->state, handle);
    }
 
+bind:
    if (ctx->depth_stencil != handle) {
       ctx->depth_stencil = handle;
       ctx->pipe->bind_depth_stencil_alpha_state(ctx->pipe, handle);
@@ -578,13 +679,17 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
                                    const struct pipe_rasterizer_state *templ)
 {
    unsigned key_size = sizeof(struct pipe_rasterizer_state);
-   unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_RASTERIZER,
-                                                       (void*)templ, key_size);
+   unsigned hash_key;
+   struct cso_hash_iter iter;
    void *handle = NULL;
 
+   if (cso_recent_lookup(&ctx->recent_rasterizer, templ, key_size, &handle))
+      goto bind;
+
+   hash_key = cso_construct_key((void*)templ, key_size);
+   iter = cso_find_state_template(ctx->cache, hash_key, CSO_RASTERIZER,
+                                  (void*)templ, key_size);
+
    if (cso_hash_iter_is_null(iter)) {
       struct cso_rasterizer *cso = MALLOC(sizeof(struct cso_rasterizer));
       if (!cso)
@@ -603,11 +708,16 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
       }
 
       handle = cso->data;
+      cso_recent_add(&ctx->recent_rasterizer, &cso->state, handle);
    }
    else {
-      handle = ((struct cso_rasterizer *)cso_hash_iter_data(iter))->data;
+      struct cso_rasterizer *cso =
+         (struct cso_rasterizer *)cso_hash_iter_data(iter);
+      handle = cso->data;
+      cso_recent_add(&ctx->recent_rasterizer, &cso->state, handle);
    }
 
+bind:
    if (ctx->rasterizer != handle) {
       ctx->rasterizer = handle;
       ctx->pipe->bind_rasterizer_state(ctx->pipe, handle);
@@ -1063,6 +1173,11 @@ cso_set_vertex_elements(struct cso_context *ctx,
    velems_state.count = count;
    memcpy(velems_state.velems, states,
           sizeof(struct pipe_vertex_element) * count);
+
+   if (cso_recent_lookup(&ctx->recent_velements, &velems_state, key_size,
+                         &handle))
+      goto bind;
+
    hash_key = cso_construct_key((void*)&velems_state, key_size);
    iter = cso_find_state_template(ctx->cache, hash_key, CSO_VELEMENTS,
                                   (void*)&velems_state, key_size);
@@ -1086,11 +1201,16 @@ cso_set_vertex_elements(struct cso_context *ctx,
       }
 
       handle = cso->data;
+      cso_recent_add(&ctx->recent_velements, &cso->state, handle);
    }
    else {
-      handle = ((struct cso_velements *)cso_hash_iter_data(iter))->data;
+      struct cso_velements *cso =
+         (struct cso_velements *)cso_hash_iter_data(iter);
+      handle = cso->data;
+      cso_recent_add(&ctx->recent_velements, &cso->state, handle);
    }
 
+bind:
    if (ctx->velements != handle) {
       ctx->velements = handle;
       ctx->pipe->bind_vertex_elements_state(ctx->pipe, handle);
@@ -1732,6 +1852,42 @@ cso_draw_vbo(struct cso_context *cso,
    }
 }
 
+/**
+ * Draw several ranges with the same draw parameters otherwise, see
+ * pipe_context::multi_draw_vbo.  Falls back to one draw_vbo per range
+ * when the driver doesn't implement it or u_vbuf has to translate.
+ */
+void
+cso_multi_draw_vbo(struct cso_context *cso,
+                   const struct pipe_draw_info *info,
+                   const struct pipe_draw_start_count *draws,
+                   unsigned num_draws)
+{
+   struct pipe_context *pipe = cso->pipe;
+   struct pipe_draw_info single;
+   unsigned i;
+
+   assert(!info->indirect && !info->count_from_stream_output);
+
+   if (!cso->vbuf && pipe->multi_draw_vbo) {
+      pipe->multi_draw_vbo(pipe, info, draws, num_draws);
+      return;
+   }
+
+   single = *info;
+   for (i = 0; i < num_draws; i++) {
+      single.start = draws[i].start;
+      single.count = draws[i].count;
+      single.index_bias = draws[i].index_bias;
+      single.drawid = info->drawid + i;
+      if (!info->indexed) {
+         single.min_index = single.start;
+         single.max_index = single.start + single.count - 1;
+      }
+      cso_draw_vbo(cso, &single);
+   }
+}
+
 void
 cso_draw_arrays(struct cso_context *cso, uint mode, uint start, uint count)
 {
@@ -26,9 +26,115 @@
  **************************************************************************/
 
 
+#include "util/u_debug.h"
+#include "util/u_format.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+
 #include "lp_bld_format.h"
 
 
+unsigned lp_build_format_cache_size = LP_BUILD_FORMAT_CACHE_SIZE;
+
+
+/**
+ * Pick up the cache size from the environment.
+ * Called once from lp_build_init(), before any code using the cache
+ * is generated.
+ */
+void
+lp_build_format_cache_init(void)
+{
+   unsigned size = debug_get_num_option("LP_TEXTURE_CACHE_SIZE",
+                                        LP_BUILD_FORMAT_CACHE_SIZE);
+
+   if (size) {
+      /* The hash needs at least a couple of bits to work with. */
+      size = CLAMP(size, 16, LP_BUILD_FORMAT_CACHE_MAX_SIZE);
+      size = util_next_power_of_two(size);
+   }
+   lp_build_format_cache_size = size;
+}
+
+
+struct lp_build_format_cache *
+lp_build_format_cache_create(void)
+{
+   struct lp_build_format_cache *cache;
+
+   assert(lp_build_format_cache_size);
+
+   cache = CALLOC_STRUCT(lp_build_format_cache);
+   if (!cache) {
+      return NULL;
+   }
+
+   cache->cache_data = align_malloc(lp_build_format_cache_size *
+                                    sizeof(*cache->cache_data), 16);
+   cache->cache_tags = MALLOC(lp_build_format_cache_size *
+                              sizeof(*cache->cache_tags));
+   if (!cache->cache_data || !cache->cache_tags) {
+      lp_build_format_cache_destroy(cache);
+      return NULL;
+   }
+
+   lp_build_format_cache_clear(cache);
+
+   return cache;
+}
+
+
+void
+lp_build_format_cache_destroy(struct lp_build_format_cache *cache)
+{
+   if (cache) {
+      align_free(cache->cache_data);
+      FREE(cache->cache_tags);
+      FREE(cache);
+   }
+}
+
+
+/**
+ * Invalidate all entries (texture data may have changed) and reset the
+ * access counters.
+ */
+void
+lp_build_format_cache_clear(struct lp_build_format_cache *cache)
+{
+   memset(cache->cache_tags, 0,
+          lp_build_format_cache_size * sizeof(*cache->cache_tags));
+   cache->cache_access_total = 0;
+   cache->cache_access_miss = 0;
+}
+
+
+/**
+ * Whether texel fetches for this format go through the block cache.
+ *
+ * This is the case for all 4x4 block based formats which are decoded by
+ * calling the util_format fetch_rgba_8unorm function per texel, as long as
+ * the decoded values fit into 4x8 bits. Everything else is decoded inline
+ * with generated code, which is cheap enough that the cache wouldn't help.
+ */
+boolean
+lp_build_format_is_cached(const struct util_format_description *format_desc)
+{
+   if (!lp_build_format_cache_size) {
+      return FALSE;
+   }
+
+   if (format_desc->block.width != 4 ||
+       format_desc->block.height != 4 ||
+       !format_desc->fetch_rgba_8unorm) {
+      return FALSE;
+   }
+
+   /* s3tc srgb formats get fetched through their linear variants */
+   return format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC ||
+          util_format_fits_8unorm(format_desc);
+}
+
 
 LLVMTypeRef
 lp_build_format_cache_type(struct gallivm_state *gallivm)
@@ -37,17 +143,13 @@ lp_build_format_cache_type(struct gallivm_state *gallivm)
    LLVMTypeRef s;
 
    elem_types[LP_BUILD_FORMAT_CACHE_MEMBER_DATA] =
-         LLVMArrayType(LLVMInt32TypeInContext(gallivm->context),
-                       LP_BUILD_FORMAT_CACHE_SIZE * 16);
+         LLVMPointerType(LLVMInt32TypeInContext(gallivm->context), 0);
    elem_types[LP_BUILD_FORMAT_CACHE_MEMBER_TAGS] =
-         LLVMArrayType(LLVMInt64TypeInContext(gallivm->context),
-                       LP_BUILD_FORMAT_CACHE_SIZE);
-#if LP_BUILD_FORMAT_CACHE_DEBUG
+         LLVMPointerType(LLVMInt64TypeInContext(gallivm->context), 0);
    elem_types[LP_BUILD_FORMAT_CACHE_MEMBER_ACCESS_TOTAL] =
          LLVMInt64TypeInContext(gallivm->context);
    elem_types[LP_BUILD_FORMAT_CACHE_MEMBER_ACCESS_MISS] =
          LLVMInt64TypeInContext(gallivm->context);
-#endif
 
    s = LLVMStructTypeInContext(gallivm->context, elem_types,
                                LP_BUILD_FORMAT_CACHE_MEMBER_COUNT, 0);
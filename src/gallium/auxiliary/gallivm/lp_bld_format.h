@@ -44,41 +44,67 @@ struct lp_type;
 struct lp_build_context;
 
 
+/*
+ * Whether the jit code keeps track of cache accesses/misses (this adds
+ * a couple of loads/stores per lookup, hence only for debug builds).
+ */
+#ifdef DEBUG
+#define LP_BUILD_FORMAT_CACHE_DEBUG 1
+#else
 #define LP_BUILD_FORMAT_CACHE_DEBUG 0
+#endif
+
 /*
  * Block cache
  *
  * Optional block cache to be used when unpacking big pixel blocks.
- * Must be a power of 2
+ * The number of entries defaults to LP_BUILD_FORMAT_CACHE_SIZE but can be
+ * overridden with the LP_TEXTURE_CACHE_SIZE env var (rounded up to a power
+ * of 2, 0 disables the cache).
  */
 
 #define LP_BUILD_FORMAT_CACHE_SIZE 128
+#define LP_BUILD_FORMAT_CACHE_MAX_SIZE 4096
+
+/** Number of cache entries used by the generated code (0 if disabled) */
+extern unsigned lp_build_format_cache_size;
 
 /*
  * Note: cache_data needs 16 byte alignment.
  */
 struct lp_build_format_cache
 {
-   PIPE_ALIGN_VAR(16) uint32_t cache_data[LP_BUILD_FORMAT_CACHE_SIZE][4][4];
-   uint64_t cache_tags[LP_BUILD_FORMAT_CACHE_SIZE];
-#if LP_BUILD_FORMAT_CACHE_DEBUG
+   uint32_t (*cache_data)[4][4];
+   uint64_t *cache_tags;
    uint64_t cache_access_total;
    uint64_t cache_access_miss;
-#endif
 };
 
 
 enum {
    LP_BUILD_FORMAT_CACHE_MEMBER_DATA = 0,
    LP_BUILD_FORMAT_CACHE_MEMBER_TAGS,
-#if LP_BUILD_FORMAT_CACHE_DEBUG
    LP_BUILD_FORMAT_CACHE_MEMBER_ACCESS_TOTAL,
    LP_BUILD_FORMAT_CACHE_MEMBER_ACCESS_MISS,
-#endif
    LP_BUILD_FORMAT_CACHE_MEMBER_COUNT
 };
 
 
+void
+lp_build_format_cache_init(void);
+
+struct lp_build_format_cache *
+lp_build_format_cache_create(void);
+
+void
+lp_build_format_cache_destroy(struct lp_build_format_cache *cache);
+
+void
+lp_build_format_cache_clear(struct lp_build_format_cache *cache);
+
+boolean
+lp_build_format_is_cached(const struct util_format_description *format_desc);
+
 LLVMTypeRef
 lp_build_format_cache_type(struct gallivm_state *gallivm);
 
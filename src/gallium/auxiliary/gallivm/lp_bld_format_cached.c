@@ -39,6 +39,8 @@
  * @file
  * Complex block-compression based formats are handled here by using a cache,
  * so re-decoding of every pixel is not required.
+ * This applies to all formats which would otherwise need a C function call
+ * per texel (see lp_build_format_is_cached()).
  * Especially for bilinear filtering, texel reuse is very high hence even
  * a small cache helps.
  * The elements in the cache are the decoded blocks - currently things
@@ -74,6 +76,29 @@ update_cache_access(struct gallivm_state *gallivm,
 #endif
 
 
+/*
+ * Get a pointer to the element with the given index of one of the cache
+ * arrays (the arrays themselves are allocated separately, as their size
+ * is only known at runtime).
+ */
+static LLVMValueRef
+get_cache_elem_ptr(struct gallivm_state *gallivm,
+                   LLVMValueRef cache,
+                   unsigned member,
+                   LLVMValueRef index)
+{
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMValueRef member_ptr, array_ptr;
+
+   assert(member == LP_BUILD_FORMAT_CACHE_MEMBER_DATA ||
+          member == LP_BUILD_FORMAT_CACHE_MEMBER_TAGS);
+
+   member_ptr = lp_build_struct_get_ptr(gallivm, cache, member, "");
+   array_ptr = LLVMBuildLoad(builder, member_ptr, "cache_array");
+   return LLVMBuildGEP(builder, array_ptr, &index, 1, "");
+}
+
+
 static void
 store_cached_block(struct gallivm_state *gallivm,
                    LLVMValueRef *col,
@@ -82,23 +107,20 @@ store_cached_block(struct gallivm_state *gallivm,
                    LLVMValueRef cache)
 {
    LLVMBuilderRef builder = gallivm->builder;
-   LLVMValueRef ptr, indices[3];
+   LLVMValueRef ptr;
    LLVMTypeRef type_ptr4x32;
    unsigned count;
 
    type_ptr4x32 = LLVMPointerType(LLVMVectorType(LLVMInt32TypeInContext(gallivm->context), 4), 0);
-   indices[0] = lp_build_const_int32(gallivm, 0);
-   indices[1] = lp_build_const_int32(gallivm, LP_BUILD_FORMAT_CACHE_MEMBER_TAGS);
-   indices[2] = hash_index;
-   ptr = LLVMBuildGEP(builder, cache, indices, ARRAY_SIZE(indices), "");
+   ptr = get_cache_elem_ptr(gallivm, cache,
+                            LP_BUILD_FORMAT_CACHE_MEMBER_TAGS, hash_index);
    LLVMBuildStore(builder, tag_value, ptr);
 
-   indices[1] = lp_build_const_int32(gallivm, LP_BUILD_FORMAT_CACHE_MEMBER_DATA);
    hash_index = LLVMBuildMul(builder, hash_index,
                              lp_build_const_int32(gallivm, 16), "");
    for (count = 0; count < 4; count++) {
-      indices[2] = hash_index;
-      ptr = LLVMBuildGEP(builder, cache, indices, ARRAY_SIZE(indices), "");
+      ptr = get_cache_elem_ptr(gallivm, cache,
+                               LP_BUILD_FORMAT_CACHE_MEMBER_DATA, hash_index);
       ptr = LLVMBuildBitCast(builder, ptr, type_ptr4x32, "");
       LLVMBuildStore(builder, col[count], ptr);
       hash_index = LLVMBuildAdd(builder, hash_index,
@@ -112,14 +134,11 @@ lookup_cached_pixel(struct gallivm_state *gallivm,
                     LLVMValueRef ptr,
                     LLVMValueRef index)
 {
-   LLVMBuilderRef builder = gallivm->builder;
-   LLVMValueRef member_ptr, indices[3];
+   LLVMValueRef member_ptr;
 
-   indices[0] = lp_build_const_int32(gallivm, 0);
-   indices[1] = lp_build_const_int32(gallivm, LP_BUILD_FORMAT_CACHE_MEMBER_DATA);
-   indices[2] = index;
-   member_ptr = LLVMBuildGEP(builder, ptr, indices, ARRAY_SIZE(indices), "");
-   return LLVMBuildLoad(builder, member_ptr, "cache_data");
+   member_ptr = get_cache_elem_ptr(gallivm, ptr,
+                                   LP_BUILD_FORMAT_CACHE_MEMBER_DATA, index);
+   return LLVMBuildLoad(gallivm->builder, member_ptr, "cache_data");
 }
 
 
@@ -128,14 +147,11 @@ lookup_tag_data(struct gallivm_state *gallivm,
                 LLVMValueRef ptr,
                 LLVMValueRef index)
 {
-   LLVMBuilderRef builder = gallivm->builder;
-   LLVMValueRef member_ptr, indices[3];
+   LLVMValueRef member_ptr;
 
-   indices[0] = lp_build_const_int32(gallivm, 0);
-   indices[1] = lp_build_const_int32(gallivm, LP_BUILD_FORMAT_CACHE_MEMBER_TAGS);
-   indices[2] = index;
-   member_ptr = LLVMBuildGEP(builder, ptr, indices, ARRAY_SIZE(indices), "");
-   return LLVMBuildLoad(builder, member_ptr, "tag_data");
+   member_ptr = get_cache_elem_ptr(gallivm, ptr,
+                                   LP_BUILD_FORMAT_CACHE_MEMBER_TAGS, index);
+   return LLVMBuildLoad(gallivm->builder, member_ptr, "tag_data");
 }
 
 
@@ -266,6 +282,7 @@ lp_build_fetch_cached_texels(struct gallivm_state *gallivm,
 
    assert(format_desc->block.width == 4);
    assert(format_desc->block.height == 4);
+   assert(lp_build_format_cache_size);
 
    lp_build_context_init(&bld32, gallivm, type);
 
@@ -282,7 +299,7 @@ lp_build_fetch_cached_texels(struct gallivm_state *gallivm,
    /* TODO: not ideal with 32bit pointers... */
 
    low_bit = util_logbase2(format_desc->block.bits / 8);
-   log2size = util_logbase2(LP_BUILD_FORMAT_CACHE_SIZE);
+   log2size = util_logbase2(lp_build_format_cache_size);
    addr = LLVMBuildPtrToInt(builder, base_ptr, i64t, "");
    ptr_addrtrunc = LLVMBuildPtrToInt(builder, base_ptr, i32t, "");
    ptr_addrtrunc = lp_build_broadcast_scalar(&bld32, ptr_addrtrunc);
@@ -291,7 +308,7 @@ lp_build_fetch_cached_texels(struct gallivm_state *gallivm,
    ptr_addrtrunc = LLVMBuildAdd(builder, offset, ptr_addrtrunc, "");
    ptr_addrtrunc = LLVMBuildLShr(builder, ptr_addrtrunc,
                                  lp_build_const_int_vec(gallivm, type, low_bit), "");
-   /* This only really makes sense for size 64,128,256 */
+   /* This only really makes sense for sizes which aren't too small */
    hash_index = ptr_addrtrunc;
    ptr_addrtrunc = LLVMBuildLShr(builder, ptr_addrtrunc,
                                  lp_build_const_int_vec(gallivm, type, 2*log2size), "");
@@ -300,7 +317,7 @@ lp_build_fetch_cached_texels(struct gallivm_state *gallivm,
                        lp_build_const_int_vec(gallivm, type, log2size), "");
    hash_index = LLVMBuildXor(builder, hash_index, tmp, "");
 
-   hash_mask = lp_build_const_int_vec(gallivm, type, LP_BUILD_FORMAT_CACHE_SIZE - 1);
+   hash_mask = lp_build_const_int_vec(gallivm, type, lp_build_format_cache_size - 1);
    hash_index = LLVMBuildAnd(builder, hash_index, hash_mask, "");
    ij_index = LLVMBuildShl(builder, i, lp_build_const_int_vec(gallivm, type, 2), "");
    ij_index = LLVMBuildAdd(builder, ij_index, j, "");
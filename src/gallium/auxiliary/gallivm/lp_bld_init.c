@@ -35,6 +35,7 @@
 #include "os/os_time.h"
 #include "lp_bld.h"
 #include "lp_bld_debug.h"
+#include "lp_bld_format.h"
 #include "lp_bld_misc.h"
 #include "lp_bld_init.h"
 
@@ -500,6 +501,8 @@ lp_build_init(void)
    }
 #endif
 
+   lp_build_format_cache_init();
+
    gallivm_initialized = TRUE;
 
    return TRUE;
@@ -826,6 +826,108 @@ lp_build_sample_image_nearest_afloat(struct lp_build_sample_context *bld,
 }
 
 
+/**
+ * Fetch the 2x2 texel neighborhood for bilinear filtering of a 2D rgba8
+ * texture.
+ *
+ * Everywhere except at the wrapped/clamped texture edges the two texels of
+ * a row are adjacent in memory, so in the common case fetch each pair with
+ * a single 64-bit load per pixel and split it with shuffles afterwards,
+ * halving the number of scalar loads. If any pixel straddles an edge fall
+ * back to fetching every texel individually.
+ */
+static void
+lp_build_sample_fetch_rgba8_2x2(struct lp_build_sample_context *bld,
+                                LLVMValueRef data_ptr,
+                                LLVMValueRef offset[2][2][2],
+                                LLVMTypeRef u8n_vec_type,
+                                LLVMValueRef neighbors[2][2][2])
+{
+   struct gallivm_state *gallivm = bld->gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_build_context *int_coord_bld = &bld->int_coord_bld;
+   const unsigned length = bld->texel_type.length;
+   LLVMValueRef shuffles[LP_MAX_VECTOR_LENGTH];
+   LLVMValueRef neighbor_vars[2][2];
+   LLVMValueRef texel_size, x_delta, split;
+   struct lp_build_if_state if_ctx;
+   unsigned i, j, k;
+
+   for (j = 0; j < 2; j++) {
+      for (i = 0; i < 2; i++) {
+         neighbor_vars[j][i] = lp_build_alloca(gallivm, u8n_vec_type,
+                                               "neighbor_var");
+      }
+   }
+
+   /*
+    * The x offsets are the same for both rows, so a single compare tells
+    * whether all the pairs are contiguous.
+    */
+   texel_size = lp_build_const_int_vec(gallivm, int_coord_bld->type,
+                                       bld->format_desc->block.bits/8);
+   x_delta = LLVMBuildSub(builder, offset[0][0][1], offset[0][0][0], "");
+   split = lp_build_compare(gallivm, int_coord_bld->type, PIPE_FUNC_NOTEQUAL,
+                            x_delta, texel_size);
+   split = lp_build_any_true_range(int_coord_bld, int_coord_bld->type.length,
+                                   split);
+
+   lp_build_if(&if_ctx, gallivm, split);
+   {
+      struct lp_type fetch_type = lp_type_uint(bld->texel_type.width);
+
+      for (j = 0; j < 2; j++) {
+         for (i = 0; i < 2; i++) {
+            LLVMValueRef rgba8;
+            rgba8 = lp_build_gather(gallivm, length,
+                                    bld->format_desc->block.bits,
+                                    fetch_type, TRUE,
+                                    data_ptr, offset[0][j][i], TRUE);
+            rgba8 = LLVMBuildBitCast(builder, rgba8, u8n_vec_type, "");
+            LLVMBuildStore(builder, rgba8, neighbor_vars[j][i]);
+         }
+      }
+   }
+   lp_build_else(&if_ctx);
+   {
+      /*
+       * Fetch as 2 x 32bit per pixel:
+       *
+       *   rgba00 rgba01 rgba10 rgba11 rgba20 rgba21 rgba30 rgba31
+       *
+       * and deinterleave into the left and right texels.
+       * Pairs are only 32bit aligned.
+       */
+      struct lp_type pair_type = lp_type_uint_vec(32, 64);
+
+      for (j = 0; j < 2; j++) {
+         LLVMValueRef pairs;
+         pairs = lp_build_gather(gallivm, length, 64, pair_type, FALSE,
+                                 data_ptr, offset[0][j][0], TRUE);
+         for (i = 0; i < 2; i++) {
+            LLVMValueRef rgba8;
+            for (k = 0; k < length; k++) {
+               shuffles[k] = lp_build_const_int32(gallivm, 2 * k + i);
+            }
+            rgba8 = LLVMBuildShuffleVector(builder, pairs,
+                                           LLVMGetUndef(LLVMTypeOf(pairs)),
+                                           LLVMConstVector(shuffles, length),
+                                           "");
+            rgba8 = LLVMBuildBitCast(builder, rgba8, u8n_vec_type, "");
+            LLVMBuildStore(builder, rgba8, neighbor_vars[j][i]);
+         }
+      }
+   }
+   lp_build_endif(&if_ctx);
+
+   for (j = 0; j < 2; j++) {
+      for (i = 0; i < 2; i++) {
+         neighbors[0][j][i] = LLVMBuildLoad(builder, neighbor_vars[j][i], "");
+      }
+   }
+}
+
+
 /**
  * Fetch texels for image with linear sampling.
  * Return filtered color as two vectors of 16-bit fixed point values.
@@ -921,39 +1023,49 @@ lp_build_sample_fetch_image_linear(struct lp_build_sample_context *bld,
    numj = 1 + (dims >= 2);
    numk = 1 + (dims >= 3);
 
-   for (k = 0; k < numk; k++) {
-      for (j = 0; j < numj; j++) {
-         for (i = 0; i < 2; i++) {
-            LLVMValueRef rgba8;
-
-            if (util_format_is_rgba8_variant(bld->format_desc)) {
-               struct lp_type fetch_type;
-               /*
-                * Given the format is a rgba8, just read the pixels as is,
-                * without any swizzling. Swizzling will be done later.
-                */
-               fetch_type = lp_type_uint(bld->texel_type.width);
-               rgba8 = lp_build_gather(bld->gallivm,
-                                       bld->texel_type.length,
-                                       bld->format_desc->block.bits,
-                                       fetch_type,
-                                       TRUE,
-                                       data_ptr, offset[k][j][i], TRUE);
-
-               rgba8 = LLVMBuildBitCast(builder, rgba8, u8n_vec_type, "");
-            }
-            else {
-               rgba8 = lp_build_fetch_rgba_aos(bld->gallivm,
-                                               bld->format_desc,
-                                               u8n.type,
-                                               TRUE,
-                                               data_ptr, offset[k][j][i],
-                                               x_subcoord[i],
-                                               y_subcoord[j],
-                                               bld->cache);
+   if (dims == 2 &&
+       util_format_is_rgba8_variant(bld->format_desc) &&
+       !bld->static_sampler_state->force_nearest_s &&
+       !bld->static_sampler_state->force_nearest_t) {
+      /* fast path for the overwhelmingly common 2D bilinear case */
+      lp_build_sample_fetch_rgba8_2x2(bld, data_ptr, offset,
+                                      u8n_vec_type, neighbors);
+   }
+   else {
+      for (k = 0; k < numk; k++) {
+         for (j = 0; j < numj; j++) {
+            for (i = 0; i < 2; i++) {
+               LLVMValueRef rgba8;
+
+               if (util_format_is_rgba8_variant(bld->format_desc)) {
+                  struct lp_type fetch_type;
+                  /*
+                   * Given the format is a rgba8, just read the pixels as is,
+                   * without any swizzling. Swizzling will be done later.
+                   */
+                  fetch_type = lp_type_uint(bld->texel_type.width);
+                  rgba8 = lp_build_gather(bld->gallivm,
+                                          bld->texel_type.length,
+                                          bld->format_desc->block.bits,
+                                          fetch_type,
+                                          TRUE,
+                                          data_ptr, offset[k][j][i], TRUE);
+
+                  rgba8 = LLVMBuildBitCast(builder, rgba8, u8n_vec_type, "");
+               }
+               else {
+                  rgba8 = lp_build_fetch_rgba_aos(bld->gallivm,
+                                                  bld->format_desc,
+                                                  u8n.type,
+                                                  TRUE,
+                                                  data_ptr, offset[k][j][i],
+                                                  x_subcoord[i],
+                                                  y_subcoord[j],
+                                                  bld->cache);
+               }
+
+               neighbors[k][j][i] = rgba8;
             }
-
-            neighbors[k][j][i] = rgba8;
          }
       }
    }
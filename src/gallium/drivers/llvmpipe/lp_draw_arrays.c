@@ -48,24 +48,25 @@
  * Draw vertex arrays, with optional indexing, optional instancing.
  * All the other drawing functions are implemented in terms of this function.
  * Basically, map the vertex buffers (and drawing surfaces), then hand off
- * the drawing to the 'draw' module.
+ * the drawing of each range to the 'draw' module.  The mapping, the state
+ * validation and the final flush are shared by all the ranges, so the draw
+ * module can batch up the primitives of the whole multi-draw.
  */
 static void
-llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
+llvmpipe_multi_draw_vbo(struct pipe_context *pipe,
+                        const struct pipe_draw_info *info,
+                        const struct pipe_draw_start_count *draws,
+                        unsigned num_draws)
 {
    struct llvmpipe_context *lp = llvmpipe_context(pipe);
    struct draw_context *draw = lp->draw;
+   struct pipe_draw_info range;
    const void *mapped_indices = NULL;
    unsigned i;
 
    if (!llvmpipe_check_render_cond(lp))
       return;
 
-   if (info->indirect) {
-      util_draw_indirect(pipe, info);
-      return;
-   }
-
    if (lp->dirty)
       llvmpipe_update_derived( lp );
 
@@ -129,7 +130,14 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
                                     lp->active_statistics_queries > 0);
 
    /* draw! */
-   draw_vbo(draw, info);
+   range = *info;
+   for (i = 0; i < num_draws; i++) {
+      range.start = draws[i].start;
+      range.count = draws[i].count;
+      range.index_bias = draws[i].index_bias;
+      range.drawid = info->drawid + i;
+      draw_vbo(draw, &range);
+   }
 
    /*
     * unmap vertex/index buffers
@@ -159,8 +167,27 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
 }
 
 
+static void
+llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
+{
+   struct pipe_draw_start_count draw;
+
+   if (info->indirect) {
+      if (llvmpipe_check_render_cond(llvmpipe_context(pipe)))
+         util_draw_indirect(pipe, info);
+      return;
+   }
+
+   draw.start = info->start;
+   draw.count = info->count;
+   draw.index_bias = info->index_bias;
+   llvmpipe_multi_draw_vbo(pipe, info, &draw, 1);
+}
+
+
 void
 llvmpipe_init_draw_funcs(struct llvmpipe_context *llvmpipe)
 {
    llvmpipe->pipe.draw_vbo = llvmpipe_draw_vbo;
+   llvmpipe->pipe.multi_draw_vbo = llvmpipe_multi_draw_vbo;
 }
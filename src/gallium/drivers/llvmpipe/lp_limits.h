@@ -35,6 +35,9 @@
 
 /**
  * Tile size (width and height). This needs to be a power of two.
+ * It is fixed at compile time: the triangle rasterizer splits a tile into
+ * 4x4 blocks of 16x16 pixels (16-bit block masks in lp_rast_tri_tmp.h),
+ * and lp_setup_tri.c bins with the same hierarchy.
  */
 #define TILE_ORDER 6
 #define TILE_SIZE (1 << TILE_ORDER)
@@ -102,6 +102,16 @@ lp_print_counters(void)
       debug_printf("llvmpipe: nr_color_tile_load:           %9u\n", lp_count.nr_color_tile_load);
       debug_printf("llvmpipe: nr_color_tile_store:          %9u\n", lp_count.nr_color_tile_store);
 
+      if (lp_count.nr_tex_cache_access) {
+         p1 = 100.0 * (float) lp_count.nr_tex_cache_miss /
+              (float) lp_count.nr_tex_cache_access;
+         debug_printf("llvmpipe: nr_tex_cache_access:          %9llu\n",
+                      (unsigned long long) lp_count.nr_tex_cache_access);
+         debug_printf("llvmpipe:   nr_tex_cache_miss:          %9llu (%3.0f%% of %llu)\n",
+                      (unsigned long long) lp_count.nr_tex_cache_miss, p1,
+                      (unsigned long long) lp_count.nr_tex_cache_access);
+      }
+
       debug_printf("llvmpipe: nr_llvm_compiles:             %u\n", lp_count.nr_llvm_compiles);
       debug_printf("llvmpipe: total LLVM compile time:      %.2f sec\n", lp_count.llvm_compile_time / 1000000.0);
       debug_printf("llvmpipe: average LLVM compile time:    %.2f sec\n", lp_count.llvm_compile_time / 1000000.0 / lp_count.nr_llvm_compiles);
@@ -62,12 +62,27 @@ struct lp_counters
    unsigned nr_color_tile_clear;
    unsigned nr_color_tile_load;
    unsigned nr_color_tile_store;
+
+   uint64_t nr_tex_cache_access;
+   uint64_t nr_tex_cache_miss;
 };
 
 
 extern struct lp_counters lp_count;
 
 
+/**
+ * Per-context counters which are always enabled (unlike lp_count above),
+ * exposed through the driver specific queries.
+ */
+struct lp_driver_counters
+{
+   uint64_t nr_binned_prims;
+   uint64_t nr_culled_prims;
+   uint64_t jit_compile_time;  /**< in microseconds */
+};
+
+
 /** Increment the named counter (only for debug builds) */
 #ifdef DEBUG
 #define LP_COUNT(counter) lp_count.counter++
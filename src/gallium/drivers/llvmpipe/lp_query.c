@@ -55,7 +55,9 @@ llvmpipe_create_query(struct pipe_context *pipe,
 {
    struct llvmpipe_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES ||
+          (type >= PIPE_QUERY_DRIVER_SPECIFIC &&
+           type < PIPE_QUERY_DRIVER_SPECIFIC + LP_QUERY_COUNT));
 
    pq = CALLOC_STRUCT( llvmpipe_query );
 
@@ -89,6 +91,19 @@ llvmpipe_destroy_query(struct pipe_context *pipe, struct pipe_query *q)
 }
 
 
+/**
+ * Total busy or idle time of the rasterizer threads so far, in nanoseconds.
+ */
+static uint64_t
+get_rast_thread_time(struct llvmpipe_screen *screen, unsigned type)
+{
+   uint64_t busy_time, idle_time;
+
+   lp_rast_get_thread_times(screen->rast, &busy_time, &idle_time);
+   return type == LP_QUERY_RAST_BUSY_TIME ? busy_time : idle_time;
+}
+
+
 static boolean
 llvmpipe_get_query_result(struct pipe_context *pipe, 
                           struct pipe_query *q,
@@ -175,6 +190,27 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
       *stats = pq->stats;
    }
       break;
+   case LP_QUERY_BINNED_PRIMITIVES:
+   case LP_QUERY_CULLED_PRIMITIVES:
+   case LP_QUERY_JIT_COMPILE_TIME:
+      *result = pq->end[0] - pq->start[0];
+      break;
+   case LP_QUERY_BLOCKS_FULL:
+   case LP_QUERY_BLOCKS_PARTIAL:
+      for (i = 0; i < num_threads; i++) {
+         *result += pq->end[i];
+      }
+      break;
+   case LP_QUERY_FS_INVOCATIONS:
+      for (i = 0; i < num_threads; i++) {
+         *result += pq->end[i];
+      }
+      *result *= LP_RASTER_BLOCK_SIZE * LP_RASTER_BLOCK_SIZE;
+      break;
+   case LP_QUERY_RAST_BUSY_TIME:
+   case LP_QUERY_RAST_IDLE_TIME:
+      *result = (pq->end[0] - pq->start[0]) / 1000;
+      break;
    default:
       assert(0);
       break;
@@ -188,6 +224,7 @@ static boolean
 llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
 {
    struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
+   struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
    struct llvmpipe_query *pq = llvmpipe_query(q);
 
    /* Check if the query is already in the scene.  If so, we need to
@@ -232,6 +269,19 @@ llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
       llvmpipe->active_occlusion_queries++;
       llvmpipe->dirty |= LP_NEW_OCCLUSION_QUERY;
       break;
+   case LP_QUERY_BINNED_PRIMITIVES:
+      pq->start[0] = llvmpipe->counters.nr_binned_prims;
+      break;
+   case LP_QUERY_CULLED_PRIMITIVES:
+      pq->start[0] = llvmpipe->counters.nr_culled_prims;
+      break;
+   case LP_QUERY_JIT_COMPILE_TIME:
+      pq->start[0] = llvmpipe->counters.jit_compile_time;
+      break;
+   case LP_QUERY_RAST_BUSY_TIME:
+   case LP_QUERY_RAST_IDLE_TIME:
+      pq->start[0] = get_rast_thread_time(screen, pq->type);
+      break;
    default:
       break;
    }
@@ -295,6 +345,20 @@ llvmpipe_end_query(struct pipe_context *pipe, struct pipe_query *q)
       llvmpipe->active_occlusion_queries--;
       llvmpipe->dirty |= LP_NEW_OCCLUSION_QUERY;
       break;
+   case LP_QUERY_BINNED_PRIMITIVES:
+      pq->end[0] = llvmpipe->counters.nr_binned_prims;
+      break;
+   case LP_QUERY_CULLED_PRIMITIVES:
+      pq->end[0] = llvmpipe->counters.nr_culled_prims;
+      break;
+   case LP_QUERY_JIT_COMPILE_TIME:
+      pq->end[0] = llvmpipe->counters.jit_compile_time;
+      break;
+   case LP_QUERY_RAST_BUSY_TIME:
+   case LP_QUERY_RAST_IDLE_TIME:
+      pq->end[0] = get_rast_thread_time(llvmpipe_screen(pipe->screen),
+                                        pq->type);
+      break;
    default:
       break;
    }
@@ -327,6 +391,72 @@ llvmpipe_set_active_query_state(struct pipe_context *pipe, boolean enable)
 {
 }
 
+static int
+llvmpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   static const struct pipe_driver_query_info list[] = {
+      {"binned-primitives", LP_QUERY_BINNED_PRIMITIVES, {0},
+       PIPE_DRIVER_QUERY_TYPE_UINT64, PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE},
+      {"culled-primitives", LP_QUERY_CULLED_PRIMITIVES, {0},
+       PIPE_DRIVER_QUERY_TYPE_UINT64, PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE},
+      {"blocks-full", LP_QUERY_BLOCKS_FULL, {0},
+       PIPE_DRIVER_QUERY_TYPE_UINT64, PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE},
+      {"blocks-partial", LP_QUERY_BLOCKS_PARTIAL, {0},
+       PIPE_DRIVER_QUERY_TYPE_UINT64, PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE},
+      {"fs-invocations", LP_QUERY_FS_INVOCATIONS, {0},
+       PIPE_DRIVER_QUERY_TYPE_UINT64, PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE},
+      {"jit-compile-time", LP_QUERY_JIT_COMPILE_TIME, {0},
+       PIPE_DRIVER_QUERY_TYPE_MICROSECONDS,
+       PIPE_DRIVER_QUERY_RESULT_TYPE_CUMULATIVE},
+      {"rast-busy-time", LP_QUERY_RAST_BUSY_TIME, {0},
+       PIPE_DRIVER_QUERY_TYPE_MICROSECONDS,
+       PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE},
+      {"rast-idle-time", LP_QUERY_RAST_IDLE_TIME, {0},
+       PIPE_DRIVER_QUERY_TYPE_MICROSECONDS,
+       PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE},
+   };
+
+   STATIC_ASSERT(ARRAY_SIZE(list) == LP_QUERY_COUNT);
+
+   if (!info)
+      return ARRAY_SIZE(list);
+
+   if (index >= ARRAY_SIZE(list))
+      return 0;
+
+   *info = list[index];
+   return 1;
+}
+
+
+static int
+llvmpipe_get_driver_query_group_info(struct pipe_screen *screen,
+                                     unsigned index,
+                                     struct pipe_driver_query_group_info *info)
+{
+   if (!info)
+      return 1;
+
+   if (index != 0)
+      return 0;
+
+   info->name = "llvmpipe";
+   info->max_active_queries = LP_QUERY_COUNT;
+   info->num_queries = LP_QUERY_COUNT;
+   return 1;
+}
+
+
+void llvmpipe_init_screen_query_funcs(struct llvmpipe_screen *screen)
+{
+   screen->base.get_driver_query_info = llvmpipe_get_driver_query_info;
+   screen->base.get_driver_query_group_info =
+      llvmpipe_get_driver_query_group_info;
+}
+
+
 void llvmpipe_init_query_funcs(struct llvmpipe_context *llvmpipe )
 {
    llvmpipe->pipe.create_query = llvmpipe_create_query;
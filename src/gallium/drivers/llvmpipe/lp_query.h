@@ -35,10 +35,26 @@
 
 #include <limits.h>
 #include "os/os_thread.h"
+#include "pipe/p_defines.h"
 #include "lp_limits.h"
 
 
 struct llvmpipe_context;
+struct llvmpipe_screen;
+
+
+/**
+ * Driver specific queries, see llvmpipe_get_driver_query_info().
+ */
+#define LP_QUERY_BINNED_PRIMITIVES     (PIPE_QUERY_DRIVER_SPECIFIC + 0)
+#define LP_QUERY_CULLED_PRIMITIVES     (PIPE_QUERY_DRIVER_SPECIFIC + 1)
+#define LP_QUERY_BLOCKS_FULL           (PIPE_QUERY_DRIVER_SPECIFIC + 2)
+#define LP_QUERY_BLOCKS_PARTIAL        (PIPE_QUERY_DRIVER_SPECIFIC + 3)
+#define LP_QUERY_FS_INVOCATIONS        (PIPE_QUERY_DRIVER_SPECIFIC + 4)
+#define LP_QUERY_JIT_COMPILE_TIME      (PIPE_QUERY_DRIVER_SPECIFIC + 5)
+#define LP_QUERY_RAST_BUSY_TIME        (PIPE_QUERY_DRIVER_SPECIFIC + 6)
+#define LP_QUERY_RAST_IDLE_TIME        (PIPE_QUERY_DRIVER_SPECIFIC + 7)
+#define LP_QUERY_COUNT                 8
 
 
 struct llvmpipe_query {
@@ -53,8 +69,31 @@ struct llvmpipe_query {
 };
 
 
+/**
+ * Whether the query is evaluated by the rasterizer threads, which requires
+ * begin/end query commands in all bins.
+ */
+static inline boolean
+lp_query_is_binned(unsigned type)
+{
+   switch (type) {
+   case PIPE_QUERY_OCCLUSION_COUNTER:
+   case PIPE_QUERY_OCCLUSION_PREDICATE:
+   case PIPE_QUERY_PIPELINE_STATISTICS:
+   case LP_QUERY_BLOCKS_FULL:
+   case LP_QUERY_BLOCKS_PARTIAL:
+   case LP_QUERY_FS_INVOCATIONS:
+      return TRUE;
+   default:
+      return FALSE;
+   }
+}
+
+
 extern void llvmpipe_init_query_funcs(struct llvmpipe_context * );
 
+extern void llvmpipe_init_screen_query_funcs(struct llvmpipe_screen *);
+
 extern boolean llvmpipe_check_render_cond(struct llvmpipe_context *);
 
 #endif /* LP_QUERY_H */
@@ -82,6 +82,166 @@ lp_rast_end( struct lp_rasterizer *rast )
 }
 
 
+/**
+ * Size of a thread-local tile buffer, big enough for any format.
+ */
+#define LP_LOCAL_TILE_SIZE (TILE_SIZE * TILE_SIZE * 16)
+
+
+/**
+ * Get (allocating it on first use) a thread-local tile buffer.
+ */
+static uint8_t *
+get_local_tile(uint8_t **tile)
+{
+   if (!*tile) {
+      *tile = align_malloc(LP_LOCAL_TILE_SIZE, 64);
+   }
+   return *tile;
+}
+
+
+/**
+ * Whether the bin starts by clearing the whole color buffer / all of the
+ * depth/stencil buffer, so the tile contents don't need to be loaded.
+ */
+static void
+find_initial_clears(const struct lp_scene *scene,
+                    const struct cmd_bin *bin,
+                    unsigned *color_clear_mask,
+                    boolean *zs_clear)
+{
+   const struct cmd_block *block;
+   unsigned k;
+
+   *color_clear_mask = 0;
+   *zs_clear = FALSE;
+
+   for (block = bin->head; block; block = block->next) {
+      for (k = 0; k < block->count; k++) {
+         const union lp_rast_cmd_arg arg = block->arg[k];
+
+         if (block->cmd[k] == LP_RAST_OP_CLEAR_COLOR) {
+            *color_clear_mask |= 1 << arg.clear_rb->cbuf;
+         }
+         else if (block->cmd[k] == LP_RAST_OP_CLEAR_ZSTENCIL) {
+            unsigned bits = util_format_get_blocksizebits(scene->fb.zsbuf->format);
+            uint64_t full_mask = bits >= 64 ? ~0ULL : (1ULL << bits) - 1;
+            if ((arg.clear_zstencil.mask & full_mask) == full_mask) {
+               *zs_clear = TRUE;
+            }
+         }
+         else {
+            return;
+         }
+      }
+   }
+}
+
+
+/**
+ * Point the task's color/depth tiles at thread-local copies of the current
+ * tile, loading the framebuffer contents unless they're cleared anyway.
+ * Returns FALSE if the local buffers can't be used.
+ */
+static boolean
+lp_rast_tile_begin_local(struct lp_rasterizer_task *task,
+                         const struct cmd_bin *bin)
+{
+   const struct lp_scene *scene = task->scene;
+   unsigned color_clear_mask;
+   boolean zs_clear;
+   unsigned i;
+
+   /* Layered rendering would need a local copy of each layer */
+   if (scene->fb_max_layer != 0) {
+      return FALSE;
+   }
+
+   for (i = 0; i < scene->fb.nr_cbufs; i++) {
+      if (scene->fb.cbufs[i] &&
+          !get_local_tile(&task->local_color_tiles[i])) {
+         return FALSE;
+      }
+   }
+   if (scene->fb.zsbuf &&
+       !get_local_tile(&task->local_depth_tile)) {
+      return FALSE;
+   }
+
+   find_initial_clears(scene, bin, &color_clear_mask, &zs_clear);
+
+   for (i = 0; i < scene->fb.nr_cbufs; i++) {
+      if (scene->fb.cbufs[i]) {
+         task->color_tiles[i] = task->local_color_tiles[i];
+         task->color_tile_strides[i] = TILE_SIZE * scene->cbufs[i].format_bytes;
+         if (!(color_clear_mask & (1 << i))) {
+            util_copy_rect(task->color_tiles[i],
+                           scene->fb.cbufs[i]->format,
+                           task->color_tile_strides[i],
+                           0, 0,
+                           task->width, task->height,
+                           scene->cbufs[i].map,
+                           scene->cbufs[i].stride,
+                           task->x, task->y);
+            LP_COUNT(nr_color_tile_load);
+         }
+      }
+   }
+   if (scene->fb.zsbuf) {
+      task->depth_tile = task->local_depth_tile;
+      task->depth_tile_stride = TILE_SIZE * scene->zsbuf.format_bytes;
+      if (!zs_clear) {
+         util_copy_rect(task->depth_tile,
+                        scene->fb.zsbuf->format,
+                        task->depth_tile_stride,
+                        0, 0,
+                        task->width, task->height,
+                        scene->zsbuf.map,
+                        scene->zsbuf.stride,
+                        task->x, task->y);
+      }
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Write the thread-local tile copies back to the framebuffer.
+ */
+static void
+lp_rast_tile_end_local(struct lp_rasterizer_task *task)
+{
+   const struct lp_scene *scene = task->scene;
+   unsigned i;
+
+   for (i = 0; i < scene->fb.nr_cbufs; i++) {
+      if (scene->fb.cbufs[i]) {
+         util_copy_rect(scene->cbufs[i].map,
+                        scene->fb.cbufs[i]->format,
+                        scene->cbufs[i].stride,
+                        task->x, task->y,
+                        task->width, task->height,
+                        task->color_tiles[i],
+                        task->color_tile_strides[i],
+                        0, 0);
+         LP_COUNT(nr_color_tile_store);
+      }
+   }
+   if (scene->fb.zsbuf) {
+      util_copy_rect(scene->zsbuf.map,
+                     scene->fb.zsbuf->format,
+                     scene->zsbuf.stride,
+                     task->x, task->y,
+                     task->width, task->height,
+                     task->depth_tile,
+                     task->depth_tile_stride,
+                     0, 0);
+   }
+}
+
+
 /**
  * Beginning rasterization of a tile.
  * \param x  window X position of the tile, in pixels
@@ -107,18 +267,28 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
 
    task->thread_data.vis_counter = 0;
    task->ps_invocations = 0;
+   task->nr_blocks_full = 0;
+   task->nr_blocks_partial = 0;
+
+   task->local_tiles = task->rast->tile_local &&
+                       lp_rast_tile_begin_local(task, bin);
+   if (task->local_tiles) {
+      return;
+   }
 
    for (i = 0; i < task->scene->fb.nr_cbufs; i++) {
       if (task->scene->fb.cbufs[i]) {
          task->color_tiles[i] = scene->cbufs[i].map +
                                 scene->cbufs[i].stride * task->y +
                                 scene->cbufs[i].format_bytes * task->x;
+         task->color_tile_strides[i] = scene->cbufs[i].stride;
       }
    }
    if (task->scene->fb.zsbuf) {
       task->depth_tile = scene->zsbuf.map +
                          scene->zsbuf.stride * task->y +
                          scene->zsbuf.format_bytes * task->x;
+      task->depth_tile_stride = scene->zsbuf.stride;
    }
 }
 
@@ -152,12 +322,12 @@ lp_rast_clear_color(struct lp_rasterizer_task *task,
           __FUNCTION__, format, uc.ui[0], uc.ui[1], uc.ui[2], uc.ui[3]);
 
 
-   util_fill_box(scene->cbufs[cbuf].map,
+   util_fill_box(task->color_tiles[cbuf],
                  format,
-                 scene->cbufs[cbuf].stride,
+                 task->color_tile_strides[cbuf],
                  scene->cbufs[cbuf].layer_stride,
-                 task->x,
-                 task->y,
+                 0,
+                 0,
                  0,
                  task->width,
                  task->height,
@@ -185,7 +355,7 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
    uint32_t clear_mask = (uint32_t) clear_mask64;
    const unsigned height = task->height;
    const unsigned width = task->width;
-   const unsigned dst_stride = scene->zsbuf.stride;
+   const unsigned dst_stride = task->depth_tile_stride;
    uint8_t *dst;
    unsigned i, j;
    unsigned block_size;
@@ -327,7 +497,7 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
          /* color buffer */
          for (i = 0; i < scene->fb.nr_cbufs; i++){
             if (scene->fb.cbufs[i]) {
-               stride[i] = scene->cbufs[i].stride;
+               stride[i] = task->color_tile_strides[i];
                color[i] = lp_rast_get_color_block_pointer(task, i, tile_x + x,
                                                           tile_y + y, inputs->layer);
             }
@@ -341,9 +511,12 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
          if (scene->zsbuf.map) {
             depth = lp_rast_get_depth_block_pointer(task, tile_x + x,
                                                     tile_y + y, inputs->layer);
-            depth_stride = scene->zsbuf.stride;
+            depth_stride = task->depth_tile_stride;
          }
 
+         task->ps_invocations += 1 * variant->ps_inv_multiplier;
+         task->nr_blocks_full++;
+
          /* Propagate non-interpolated raster state. */
          task->thread_data.raster_state.viewport_index = inputs->viewport_index;
 
@@ -422,7 +595,7 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
    /* color buffer */
    for (i = 0; i < scene->fb.nr_cbufs; i++) {
       if (scene->fb.cbufs[i]) {
-         stride[i] = scene->cbufs[i].stride;
+         stride[i] = task->color_tile_strides[i];
          color[i] = lp_rast_get_color_block_pointer(task, i, x, y,
                                                     inputs->layer);
       }
@@ -434,7 +607,7 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
 
    /* depth buffer */
    if (scene->zsbuf.map) {
-      depth_stride = scene->zsbuf.stride;
+      depth_stride = task->depth_tile_stride;
       depth = lp_rast_get_depth_block_pointer(task, x, y, inputs->layer);
    }
 
@@ -448,6 +621,7 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
       /* not very accurate would need a popcount on the mask */
       /* always count this not worth bothering? */
       task->ps_invocations += 1 * variant->ps_inv_multiplier;
+      task->nr_blocks_partial++;
 
       /* Propagate non-interpolated raster state. */
       task->thread_data.raster_state.viewport_index = inputs->viewport_index;
@@ -489,8 +663,15 @@ lp_rast_begin_query(struct lp_rasterizer_task *task,
       pq->start[task->thread_index] = task->thread_data.vis_counter;
       break;
    case PIPE_QUERY_PIPELINE_STATISTICS:
+   case LP_QUERY_FS_INVOCATIONS:
       pq->start[task->thread_index] = task->ps_invocations;
       break;
+   case LP_QUERY_BLOCKS_FULL:
+      pq->start[task->thread_index] = task->nr_blocks_full;
+      break;
+   case LP_QUERY_BLOCKS_PARTIAL:
+      pq->start[task->thread_index] = task->nr_blocks_partial;
+      break;
    default:
       assert(0);
       break;
@@ -520,10 +701,21 @@ lp_rast_end_query(struct lp_rasterizer_task *task,
       pq->end[task->thread_index] = os_time_get_nano();
       break;
    case PIPE_QUERY_PIPELINE_STATISTICS:
+   case LP_QUERY_FS_INVOCATIONS:
       pq->end[task->thread_index] +=
          task->ps_invocations - pq->start[task->thread_index];
       pq->start[task->thread_index] = 0;
       break;
+   case LP_QUERY_BLOCKS_FULL:
+      pq->end[task->thread_index] +=
+         task->nr_blocks_full - pq->start[task->thread_index];
+      pq->start[task->thread_index] = 0;
+      break;
+   case LP_QUERY_BLOCKS_PARTIAL:
+      pq->end[task->thread_index] +=
+         task->nr_blocks_partial - pq->start[task->thread_index];
+      pq->start[task->thread_index] = 0;
+      break;
    default:
       assert(0);
       break;
@@ -552,6 +744,11 @@ lp_rast_tile_end(struct lp_rasterizer_task *task)
       lp_rast_end_query(task, lp_rast_arg_query(task->scene->active_queries[i]));
    }
 
+   if (task->local_tiles) {
+      lp_rast_tile_end_local(task);
+      task->local_tiles = FALSE;
+   }
+
    /* debug */
    memset(task->color_tiles, 0, sizeof(task->color_tiles));
    task->depth_tile = NULL;
@@ -668,12 +865,9 @@ rasterize_scene(struct lp_rasterizer_task *task,
    /* Clear the cache tags. This should not always be necessary but
       simpler for now. */
 #if LP_USE_TEXTURE_CACHE
-   memset(task->thread_data.cache->cache_tags, 0,
-          sizeof(task->thread_data.cache->cache_tags));
-#if LP_BUILD_FORMAT_CACHE_DEBUG
-   task->thread_data.cache->cache_access_total = 0;
-   task->thread_data.cache->cache_access_miss = 0;
-#endif
+   if (task->thread_data.cache) {
+      lp_build_format_cache_clear(task->thread_data.cache);
+   }
 #endif
 
    if (!task->rast->no_rast && !scene->discard) {
@@ -691,17 +885,12 @@ rasterize_scene(struct lp_rasterizer_task *task,
    }
 
 
-#if LP_BUILD_FORMAT_CACHE_DEBUG
-   {
-      uint64_t total, miss;
-      total = task->thread_data.cache->cache_access_total;
-      miss = task->thread_data.cache->cache_access_miss;
-      if (total) {
-         debug_printf("thread %d cache access %llu miss %llu hit rate %f\n",
-                 task->thread_index, (long long unsigned)total,
-                 (long long unsigned)miss,
-                 (float)(total - miss)/(float)total);
-      }
+#if LP_USE_TEXTURE_CACHE && LP_BUILD_FORMAT_CACHE_DEBUG
+   if (task->thread_data.cache) {
+      LP_COUNT_ADD(nr_tex_cache_access,
+                   task->thread_data.cache->cache_access_total);
+      LP_COUNT_ADD(nr_tex_cache_miss,
+                   task->thread_data.cache->cache_access_miss);
    }
 #endif
 
@@ -713,6 +902,29 @@ rasterize_scene(struct lp_rasterizer_task *task,
 }
 
 
+/**
+ * Account the time since the task's last state change to busy or idle time
+ * and switch to the new state.  Time spent outside of rasterize_scene()
+ * only counts as idle time for rasterizer threads.
+ */
+static void
+task_set_busy( struct lp_rasterizer_task *task, boolean busy )
+{
+   struct lp_rasterizer *rast = task->rast;
+   int64_t now;
+
+   mtx_lock(&rast->time_mutex);
+   now = os_time_get_nano();
+   if (task->busy)
+      task->busy_time += now - task->state_start;
+   else if (rast->num_threads > 0)
+      task->idle_time += now - task->state_start;
+   task->busy = busy;
+   task->state_start = now;
+   mtx_unlock(&rast->time_mutex);
+}
+
+
 /**
  * Called by setup module when it has something for us to render.
  */
@@ -733,7 +945,9 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 
       lp_rast_begin( rast, scene );
 
+      task_set_busy( &rast->tasks[0], TRUE );
       rasterize_scene( &rast->tasks[0], scene );
+      task_set_busy( &rast->tasks[0], FALSE );
 
       lp_rast_end( rast );
 
@@ -757,6 +971,39 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 }
 
 
+/**
+ * Get the total time all rasterizer threads spent rasterizing scenes and
+ * waiting for work up to now, in nanoseconds.
+ */
+void
+lp_rast_get_thread_times( struct lp_rasterizer *rast,
+                          uint64_t *busy_time,
+                          uint64_t *idle_time )
+{
+   unsigned i;
+   int64_t now;
+
+   *busy_time = 0;
+   *idle_time = 0;
+
+   mtx_lock(&rast->time_mutex);
+   now = os_time_get_nano();
+   for (i = 0; i < MAX2(1, rast->num_threads); i++) {
+      struct lp_rasterizer_task *task = &rast->tasks[i];
+
+      *busy_time += task->busy_time;
+      *idle_time += task->idle_time;
+
+      /* Include the interval the task is in right now. */
+      if (task->busy)
+         *busy_time += now - task->state_start;
+      else if (rast->num_threads > 0)
+         *idle_time += now - task->state_start;
+   }
+   mtx_unlock(&rast->time_mutex);
+}
+
+
 void
 lp_rast_finish( struct lp_rasterizer *rast )
 {
@@ -826,8 +1073,12 @@ thread_function(void *init_data)
       if (debug)
          debug_printf("thread %d doing work\n", task->thread_index);
 
+      task_set_busy(task, TRUE);
+
       rasterize_scene(task,
                       rast->curr_scene);
+
+      task_set_busy(task, FALSE);
       
       /* wait for all threads to finish with this scene */
       pipe_barrier_wait( &rast->barrier );
@@ -893,20 +1144,27 @@ lp_rast_create( unsigned num_threads )
       goto no_full_scenes;
    }
 
+   (void) mtx_init(&rast->time_mutex, mtx_plain);
+
    for (i = 0; i < MAX2(1, num_threads); i++) {
       struct lp_rasterizer_task *task = &rast->tasks[i];
       task->rast = rast;
       task->thread_index = i;
-      task->thread_data.cache = align_malloc(sizeof(struct lp_build_format_cache),
-                                             16);
-      if (!task->thread_data.cache) {
-         goto no_thread_data_cache;
+      task->state_start = os_time_get_nano();
+#if LP_USE_TEXTURE_CACHE
+      if (lp_build_format_cache_size) {
+         task->thread_data.cache = lp_build_format_cache_create();
+         if (!task->thread_data.cache) {
+            goto no_thread_data_cache;
+         }
       }
+#endif
    }
 
    rast->num_threads = num_threads;
 
    rast->no_rast = debug_get_bool_option("LP_NO_RAST", FALSE);
+   rast->tile_local = debug_get_bool_option("LP_TILE_LOCAL", FALSE);
 
    create_rast_threads(rast);
 
@@ -920,12 +1178,11 @@ lp_rast_create( unsigned num_threads )
    return rast;
 
 no_thread_data_cache:
-   for (i = 0; i < MAX2(1, rast->num_threads); i++) {
-      if (rast->tasks[i].thread_data.cache) {
-         align_free(rast->tasks[i].thread_data.cache);
-      }
+   for (i = 0; i < MAX2(1, num_threads); i++) {
+      lp_build_format_cache_destroy(rast->tasks[i].thread_data.cache);
    }
 
+   mtx_destroy(&rast->time_mutex);
    lp_scene_queue_destroy(rast->full_scenes);
 no_full_scenes:
    FREE(rast);
@@ -966,7 +1223,14 @@ void lp_rast_destroy( struct lp_rasterizer *rast )
       pipe_semaphore_destroy(&rast->tasks[i].work_done);
    }
    for (i = 0; i < MAX2(1, rast->num_threads); i++) {
-      align_free(rast->tasks[i].thread_data.cache);
+      struct lp_rasterizer_task *task = &rast->tasks[i];
+      unsigned j;
+
+      lp_build_format_cache_destroy(task->thread_data.cache);
+      for (j = 0; j < PIPE_MAX_COLOR_BUFS; j++) {
+         align_free(task->local_color_tiles[j]);
+      }
+      align_free(task->local_depth_tile);
    }
 
    /* for synchronizing rasterization threads */
@@ -974,6 +1238,7 @@ void lp_rast_destroy( struct lp_rasterizer *rast )
       pipe_barrier_destroy( &rast->barrier );
    }
 
+   mtx_destroy(&rast->time_mutex);
    lp_scene_queue_destroy(rast->full_scenes);
 
    FREE(rast);
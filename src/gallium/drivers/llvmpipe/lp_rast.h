@@ -169,6 +169,11 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 void
 lp_rast_finish( struct lp_rasterizer *rast );
 
+void
+lp_rast_get_thread_times( struct lp_rasterizer *rast,
+                          uint64_t *busy_time,
+                          uint64_t *idle_time );
+
 
 union lp_rast_cmd_arg {
    const struct lp_rast_shader_inputs *shade_tile;
@@ -91,6 +91,19 @@ struct lp_rasterizer_task
    uint8_t *color_tiles[PIPE_MAX_COLOR_BUFS];
    uint8_t *depth_tile;
 
+   /** Row strides of color_tiles/depth_tile, in bytes */
+   unsigned color_tile_strides[PIPE_MAX_COLOR_BUFS];
+   unsigned depth_tile_stride;
+
+   /**
+    * Thread-local tile storage (see LP_TILE_LOCAL). When local_tiles is set
+    * the color_tiles/depth_tile pointers point into these buffers instead
+    * of the framebuffer, and get written back at the end of the tile.
+    */
+   boolean local_tiles;
+   uint8_t *local_color_tiles[PIPE_MAX_COLOR_BUFS];
+   uint8_t *local_depth_tile;
+
    /** "back" pointer */
    struct lp_rasterizer *rast;
 
@@ -102,6 +115,20 @@ struct lp_rasterizer_task
    uint64_t ps_invocations;
    uint8_t ps_inv_multiplier;
 
+   /** Shaded 4x4 blocks in the current tile, for the driver queries */
+   uint64_t nr_blocks_full;
+   uint64_t nr_blocks_partial;
+
+   /**
+    * Total time spent rasterizing / waiting for work, in nanoseconds, not
+    * counting the current interval which started at state_start.
+    * Protected by lp_rasterizer::time_mutex.
+    */
+   uint64_t busy_time;
+   uint64_t idle_time;
+   int64_t state_start;
+   boolean busy;
+
    pipe_semaphore work_ready;
    pipe_semaphore work_done;
 };
@@ -116,6 +143,7 @@ struct lp_rasterizer
 {
    boolean exit_flag;
    boolean no_rast;  /**< For debugging/profiling */
+   boolean tile_local;  /**< Render into thread-local tile copies */
 
    /** The incoming queue of scenes ready to rasterize */
    struct lp_scene_queue *full_scenes;
@@ -131,6 +159,9 @@ struct lp_rasterizer
 
    /** For synchronizing the rasterization threads */
    pipe_barrier barrier;
+
+   /** Protects the busy/idle times of the tasks */
+   mtx_t time_mutex;
 };
 
 
@@ -170,10 +201,11 @@ lp_rast_get_color_block_pointer(struct lp_rasterizer_task *task,
    py = y % TILE_SIZE;
 
    pixel_offset = px * task->scene->cbufs[buf].format_bytes +
-                  py * task->scene->cbufs[buf].stride;
+                  py * task->color_tile_strides[buf];
    color = task->color_tiles[buf] + pixel_offset;
 
    if (layer) {
+      assert(!task->local_tiles);
       color += layer * task->scene->cbufs[buf].layer_stride;
    }
 
@@ -204,10 +236,11 @@ lp_rast_get_depth_block_pointer(struct lp_rasterizer_task *task,
    py = y % TILE_SIZE;
 
    pixel_offset = px * task->scene->zsbuf.format_bytes +
-                  py * task->scene->zsbuf.stride;
+                  py * task->depth_tile_stride;
    depth = task->depth_tile + pixel_offset;
 
    if (layer) {
+      assert(!task->local_tiles);
       depth += layer * task->scene->zsbuf.layer_stride;
    }
 
@@ -239,7 +272,7 @@ lp_rast_shade_quads_all( struct lp_rasterizer_task *task,
    /* color buffer */
    for (i = 0; i < scene->fb.nr_cbufs; i++) {
       if (scene->fb.cbufs[i]) {
-         stride[i] = scene->cbufs[i].stride;
+         stride[i] = task->color_tile_strides[i];
          color[i] = lp_rast_get_color_block_pointer(task, i, x, y,
                                                     inputs->layer);
       }
@@ -251,7 +284,7 @@ lp_rast_shade_quads_all( struct lp_rasterizer_task *task,
 
    if (scene->zsbuf.map) {
       depth = lp_rast_get_depth_block_pointer(task, x, y, inputs->layer);
-      depth_stride = scene->zsbuf.stride;
+      depth_stride = task->depth_tile_stride;
    }
 
    /*
@@ -262,6 +295,7 @@ lp_rast_shade_quads_all( struct lp_rasterizer_task *task,
       /* not very accurate would need a popcount on the mask */
       /* always count this not worth bothering? */
       task->ps_invocations += 1 * variant->ps_inv_multiplier;
+      task->nr_blocks_full++;
 
       /* Propagate non-interpolated raster state. */
       task->thread_data.raster_state.viewport_index = inputs->viewport_index;
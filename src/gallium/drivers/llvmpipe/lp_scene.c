@@ -93,6 +93,7 @@ lp_scene_destroy(struct lp_scene *scene)
    mtx_destroy(&scene->mutex);
    assert(scene->data.head->next == NULL);
    FREE(scene->data.head);
+   FREE(scene->tiles);
    FREE(scene);
 }
 
@@ -104,14 +105,11 @@ lp_scene_destroy(struct lp_scene *scene)
 boolean
 lp_scene_is_empty(struct lp_scene *scene )
 {
-   unsigned x, y;
+   unsigned i;
 
-   for (y = 0; y < TILES_Y; y++) {
-      for (x = 0; x < TILES_X; x++) {
-         const struct cmd_bin *bin = lp_scene_get_bin(scene, x, y);
-         if (bin->head) {
-            return FALSE;
-         }
+   for (i = 0; i < scene->max_tiles; i++) {
+      if (scene->tiles[i].head) {
+         return FALSE;
       }
    }
    return TRUE;
@@ -507,11 +505,17 @@ end:
 }
 
 
-void lp_scene_begin_binning( struct lp_scene *scene,
-                             struct pipe_framebuffer_state *fb, boolean discard )
+/**
+ * Start binning for the given framebuffer.
+ * Returns FALSE if the bins couldn't be allocated.
+ */
+boolean
+lp_scene_begin_binning( struct lp_scene *scene,
+                        struct pipe_framebuffer_state *fb, boolean discard )
 {
    int i;
    unsigned max_layer = ~0;
+   unsigned num_tiles;
 
    assert(lp_scene_is_empty(scene));
 
@@ -523,6 +527,23 @@ void lp_scene_begin_binning( struct lp_scene *scene,
    assert(scene->tiles_x <= TILES_X);
    assert(scene->tiles_y <= TILES_Y);
 
+   /*
+    * Only allocate as many bins as the framebuffer needs. The bins are
+    * all empty at this point so there's nothing to preserve.
+    */
+   num_tiles = scene->tiles_x * scene->tiles_y;
+   if (num_tiles > scene->max_tiles) {
+      FREE(scene->tiles);
+      scene->tiles = CALLOC(num_tiles, sizeof *scene->tiles);
+      if (!scene->tiles) {
+         scene->max_tiles = 0;
+         scene->tiles_x = 0;
+         scene->tiles_y = 0;
+         return FALSE;
+      }
+      scene->max_tiles = num_tiles;
+   }
+
    /*
     * Determine how many layers the fb has (used for clamping layer value).
     * OpenGL (but not d3d10) permits different amount of layers per rt, however
@@ -546,6 +567,8 @@ void lp_scene_begin_binning( struct lp_scene *scene,
       max_layer = MIN2(max_layer, zsbuf->u.tex.last_layer - zsbuf->u.tex.first_layer);
    }
    scene->fb_max_layer = max_layer;
+
+   return TRUE;
 }
 
 
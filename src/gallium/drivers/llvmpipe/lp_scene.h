@@ -42,8 +42,8 @@
 struct lp_scene_queue;
 struct lp_rast_state;
 
-/* We're limited to 2K by 2K for 32bit fixed point rasterization.
- * Will need a 64-bit version for larger framebuffers.
+/* Maximum number of tiles in each dimension. The bins themselves are
+ * allocated according to the actual framebuffer size.
  */
 #define TILES_X (LP_MAX_WIDTH / TILE_SIZE)
 #define TILES_Y (LP_MAX_HEIGHT / TILE_SIZE)
@@ -176,7 +176,12 @@ struct lp_scene {
    int curr_x, curr_y;  /**< for iterating over bins */
    mtx_t mutex;
 
-   struct cmd_bin tile[TILES_X][TILES_Y];
+   /**
+    * The bins, tiles_x * tiles_y of them, stored row by row.
+    * Grown as needed when binning for a bigger framebuffer starts.
+    */
+   struct cmd_bin *tiles;
+   unsigned max_tiles;  /**< number of allocated bins */
    struct data_block_list data;
 };
 
@@ -285,7 +290,9 @@ lp_scene_putback_data( struct lp_scene *scene, unsigned size)
 static inline struct cmd_bin *
 lp_scene_get_bin(struct lp_scene *scene, unsigned x, unsigned y)
 {
-   return &scene->tile[x][y];
+   assert(x < scene->tiles_x);
+   assert(y < scene->tiles_y);
+   return &scene->tiles[y * scene->tiles_x + x];
 }
 
 
@@ -388,7 +395,7 @@ lp_scene_bin_iter_next( struct lp_scene *scene, int *x, int *y );
 
 /* Begin/end binning of a scene
  */
-void
+boolean
 lp_scene_begin_binning( struct lp_scene *scene,
                         struct pipe_framebuffer_state *fb,
                         boolean discard );
@@ -64,7 +64,7 @@ static boolean set_scene_state( struct lp_setup_context *, enum setup_state,
 static boolean try_update_scene_state( struct lp_setup_context *setup );
 
 
-static void
+static boolean
 lp_setup_get_empty_scene(struct lp_setup_context *setup)
 {
    assert(setup->scene == NULL);
@@ -82,8 +82,8 @@ lp_setup_get_empty_scene(struct lp_setup_context *setup)
       lp_fence_wait(setup->scene->fence);
    }
 
-   lp_scene_begin_binning(setup->scene, &setup->fb, setup->rasterizer_discard);
-
+   return lp_scene_begin_binning(setup->scene, &setup->fb,
+                                 setup->rasterizer_discard);
 }
 
 
@@ -311,8 +311,10 @@ set_scene_state( struct lp_setup_context *setup,
 
    /* wait for a free/empty scene
     */
-   if (old_state == SETUP_FLUSHED) 
-      lp_setup_get_empty_scene(setup);
+   if (old_state == SETUP_FLUSHED) {
+      if (!lp_setup_get_empty_scene(setup))
+         goto fail;
+   }
 
    switch (new_state) {
    case SETUP_CLEARED:
@@ -1322,6 +1324,7 @@ lp_setup_create( struct pipe_context *pipe,
    /* Used only in update_state():
     */
    setup->pipe = pipe;
+   setup->counters = &llvmpipe_context(pipe)->counters;
 
 
    setup->num_threads = screen->num_threads;
@@ -1374,9 +1377,7 @@ lp_setup_begin_query(struct lp_setup_context *setup,
 
    set_scene_state(setup, SETUP_ACTIVE, "begin_query");
 
-   if (!(pq->type == PIPE_QUERY_OCCLUSION_COUNTER ||
-         pq->type == PIPE_QUERY_OCCLUSION_PREDICATE ||
-         pq->type == PIPE_QUERY_PIPELINE_STATISTICS))
+   if (!lp_query_is_binned(pq->type))
       return;
 
    /* init the query to its beginning state */
@@ -1424,9 +1425,7 @@ lp_setup_end_query(struct lp_setup_context *setup, struct llvmpipe_query *pq)
        */
       lp_fence_reference(&pq->fence, setup->scene->fence);
 
-      if (pq->type == PIPE_QUERY_OCCLUSION_COUNTER ||
-          pq->type == PIPE_QUERY_OCCLUSION_PREDICATE ||
-          pq->type == PIPE_QUERY_PIPELINE_STATISTICS ||
+      if (lp_query_is_binned(pq->type) ||
           pq->type == PIPE_QUERY_TIMESTAMP) {
          if (pq->type == PIPE_QUERY_TIMESTAMP &&
                !(setup->scene->tiles_x | setup->scene->tiles_y)) {
@@ -1460,9 +1459,7 @@ fail:
    /* Need to do this now not earlier since it still needs to be marked as
     * active when binning it would cause a flush.
     */
-   if (pq->type == PIPE_QUERY_OCCLUSION_COUNTER ||
-      pq->type == PIPE_QUERY_OCCLUSION_PREDICATE ||
-      pq->type == PIPE_QUERY_PIPELINE_STATISTICS) {
+   if (lp_query_is_binned(pq->type)) {
       unsigned i;
 
       /* remove from active binned query list */
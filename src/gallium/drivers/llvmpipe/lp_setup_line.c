@@ -341,6 +341,7 @@ try_setup_line( struct lp_setup_context *setup,
    area = (dx * dx  + dy * dy);
    if (area == 0) {
       LP_COUNT(nr_culled_tris);
+      setup->counters->nr_culled_prims++;
       return TRUE;
    }
 
@@ -570,12 +571,14 @@ try_setup_line( struct lp_setup_context *setup,
        bbox.y1 < bbox.y0) {
       if (0) debug_printf("empty bounding box\n");
       LP_COUNT(nr_culled_tris);
+      setup->counters->nr_culled_prims++;
       return TRUE;
    }
 
    if (!u_rect_test_intersection(&setup->draw_regions[viewport_index], &bbox)) {
       if (0) debug_printf("offscreen\n");
       LP_COUNT(nr_culled_tris);
+      setup->counters->nr_culled_prims++;
       return TRUE;
    }
 
@@ -611,6 +614,7 @@ try_setup_line( struct lp_setup_context *setup,
 #endif
 
    LP_COUNT(nr_tris);
+   setup->counters->nr_binned_prims++;
 
    if (lp_context->active_statistics_queries &&
        !llvmpipe_rasterization_disabled(lp_context)) {
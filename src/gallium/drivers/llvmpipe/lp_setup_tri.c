@@ -323,12 +323,14 @@ do_triangle_ccw(struct lp_setup_context *setup,
        bbox.y1 < bbox.y0) {
       if (0) debug_printf("empty bounding box\n");
       LP_COUNT(nr_culled_tris);
+      setup->counters->nr_culled_prims++;
       return TRUE;
    }
 
    if (!u_rect_test_intersection(&setup->draw_regions[viewport_index], &bbox)) {
       if (0) debug_printf("offscreen\n");
       LP_COUNT(nr_culled_tris);
+      setup->counters->nr_culled_prims++;
       return TRUE;
    }
 
@@ -368,6 +370,7 @@ do_triangle_ccw(struct lp_setup_context *setup,
 #endif
 
    LP_COUNT(nr_tris);
+   setup->counters->nr_binned_prims++;
 
    /* Setup parameter interpolants:
     */
@@ -1128,6 +1131,9 @@ static void triangle_cw(struct lp_setup_context *setup,
          retry_triangle_ccw(setup, &position, v1, v0, v2, !setup->ccw_is_frontface);
       }
    }
+   else {
+      setup->counters->nr_culled_prims++;
+   }
 }
 
 
@@ -1142,6 +1148,8 @@ static void triangle_ccw(struct lp_setup_context *setup,
 
    if (position.area > 0)
       retry_triangle_ccw(setup, &position, v0, v1, v2, setup->ccw_is_frontface);
+   else
+      setup->counters->nr_culled_prims++;
 }
 
 /**
@@ -1182,6 +1190,9 @@ static void triangle_both(struct lp_setup_context *setup,
          retry_triangle_ccw( setup, &position, v1, v0, v2, !setup->ccw_is_frontface );
       }
    }
+   else {
+      setup->counters->nr_culled_prims++;
+   }
 }
 
 
@@ -1190,6 +1201,7 @@ static void triangle_nop( struct lp_setup_context *setup,
 			  const float (*v1)[4],
 			  const float (*v2)[4] )
 {
+   setup->counters->nr_culled_prims++;
 }
 
 
@@ -3405,6 +3405,7 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
       variant = generate_variant(lp, shader, &key);
       t1 = os_time_get();
       dt = t1 - t0;
+      lp->counters.jit_compile_time += dt;
       LP_COUNT_ADD(llvm_compile_time, dt);
       LP_COUNT_ADD(nr_llvm_compiles, 2);  /* emit vs. omit in/out test */
 
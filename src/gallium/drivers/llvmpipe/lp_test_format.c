@@ -175,6 +175,11 @@ test_format_float(unsigned verbose, FILE *fp,
          /* To ensure it's 16-byte aligned */
          memcpy(packed, test->packed, sizeof packed);
 
+         /* The cache is keyed on the address, which doesn't change */
+         if (cache_ptr) {
+            lp_build_format_cache_clear(cache_ptr);
+         }
+
          for (i = 0; i < desc->block.height; ++i) {
             for (j = 0; j < desc->block.width; ++j) {
                boolean match = TRUE;
@@ -274,6 +279,11 @@ test_format_unorm8(unsigned verbose, FILE *fp,
          /* Could skip this and use unaligned lp_build_fetch_rgba_aos */
          memcpy(packed, test->packed, sizeof packed);
 
+         /* The cache is keyed on the address, which doesn't change */
+         if (cache_ptr) {
+            lp_build_format_cache_clear(cache_ptr);
+         }
+
          for (i = 0; i < desc->block.height; ++i) {
             for (j = 0; j < desc->block.width; ++j) {
                boolean match;
@@ -360,7 +370,9 @@ test_all(unsigned verbose, FILE *fp)
    util_format_s3tc_init();
 
 #if USE_TEXTURE_CACHE
-   cache_ptr = align_malloc(sizeof(struct lp_build_format_cache), 16);
+   if (lp_build_format_cache_size) {
+      cache_ptr = lp_build_format_cache_create();
+   }
 #endif
 
    for (format = 1; format < PIPE_FORMAT_COUNT; ++format) {
@@ -405,7 +417,7 @@ test_all(unsigned verbose, FILE *fp)
       }
    }
 #if USE_TEXTURE_CACHE
-   align_free(cache_ptr);
+   lp_build_format_cache_destroy(cache_ptr);
 #endif
 
    return success;
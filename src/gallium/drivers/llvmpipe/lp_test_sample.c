@@ -0,0 +1,755 @@
+/**************************************************************************
+ *
+ * Copyright © 2026 agent <agent@local>
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Unit tests and benchmark for texture sampling LLVM IR generation.
+ *
+ * Each sampler key (format, wrap mode, filters, texture size, vector
+ * length) is compiled once, checked against a C reference and then run
+ * over a screen-sized grid of coherent texture coordinates to measure the
+ * sampling throughput in texels per second.
+ */
+
+
+#include "util/u_memory.h"
+#include "util/u_format.h"
+#include "os/os_time.h"
+
+#include "gallivm/lp_bld_init.h"
+#include "gallivm/lp_bld_const.h"
+#include "gallivm/lp_bld_type.h"
+#include "gallivm/lp_bld_debug.h"
+#include "gallivm/lp_bld_sample.h"
+#include "gallivm/lp_bld_struct.h"
+#include "lp_jit.h"
+#include "lp_test.h"
+
+
+/** Size of the (virtual) screen being textured */
+#define SCREEN_WIDTH  256
+#define SCREEN_HEIGHT 256
+
+
+/**
+ * Runtime state passed to the generated code.
+ */
+struct sample_test_context
+{
+   struct lp_jit_texture texture;
+   struct lp_jit_sampler sampler;
+};
+
+
+enum {
+   SAMPLE_TEST_CTX_TEXTURE = 0,
+   SAMPLE_TEST_CTX_SAMPLER,
+   SAMPLE_TEST_CTX_NUM_FIELDS
+};
+
+
+struct sample_test_key
+{
+   enum pipe_format format;
+   unsigned wrap;
+   unsigned img_filter;
+   unsigned mip_filter;
+   unsigned width;
+   unsigned height;
+};
+
+
+typedef void (*sample_test_ptr_t)(const struct sample_test_context *ctx,
+                                  const float *s, const float *t,
+                                  float *texels);
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "cycles_per_texel\t"
+           "mtexels_per_second\t"
+           "type\t"
+           "format\t"
+           "wrap\t"
+           "img_filter\t"
+           "mip_filter\t"
+           "width\t"
+           "height\n");
+
+   fflush(fp);
+}
+
+
+static void
+write_tsv_row(FILE *fp,
+              const struct sample_test_key *key,
+              struct lp_type type,
+              double cycles,
+              double mtexels,
+              boolean success)
+{
+   fprintf(fp, "%s\t", success ? "pass" : "fail");
+
+   fprintf(fp, "%.1f\t", cycles);
+   fprintf(fp, "%.1f\t", mtexels);
+
+   dump_type(fp, type);
+   fprintf(fp, "\t");
+
+   fprintf(fp,
+           "%s\t%s\t%s\t%s\t%u\t%u\n",
+           util_format_short_name(key->format),
+           util_dump_tex_wrap(key->wrap, TRUE),
+           util_dump_tex_filter(key->img_filter, TRUE),
+           util_dump_tex_mipfilter(key->mip_filter, TRUE),
+           key->width, key->height);
+
+   fflush(fp);
+}
+
+
+static void
+dump_sample_key(FILE *fp,
+                const struct sample_test_key *key,
+                struct lp_type type)
+{
+   fprintf(fp, " type=");
+   dump_type(fp, type);
+
+   fprintf(fp, " format=%s wrap=%s img_filter=%s mip_filter=%s size=%ux%u ...\n",
+           util_format_short_name(key->format),
+           util_dump_tex_wrap(key->wrap, TRUE),
+           util_dump_tex_filter(key->img_filter, TRUE),
+           util_dump_tex_mipfilter(key->mip_filter, TRUE),
+           key->width, key->height);
+   fflush(fp);
+}
+
+
+static LLVMTypeRef
+create_context_type(struct gallivm_state *gallivm)
+{
+   LLVMContextRef lc = gallivm->context;
+   LLVMTypeRef texture_type, sampler_type, context_type;
+   LLVMTypeRef elem_types[LP_JIT_TEXTURE_NUM_FIELDS];
+   LLVMTypeRef ctx_types[SAMPLE_TEST_CTX_NUM_FIELDS];
+
+   elem_types[LP_JIT_TEXTURE_WIDTH]  =
+   elem_types[LP_JIT_TEXTURE_HEIGHT] =
+   elem_types[LP_JIT_TEXTURE_DEPTH] =
+   elem_types[LP_JIT_TEXTURE_FIRST_LEVEL] =
+   elem_types[LP_JIT_TEXTURE_LAST_LEVEL] = LLVMInt32TypeInContext(lc);
+   elem_types[LP_JIT_TEXTURE_BASE] = LLVMPointerType(LLVMInt8TypeInContext(lc), 0);
+   elem_types[LP_JIT_TEXTURE_ROW_STRIDE] =
+   elem_types[LP_JIT_TEXTURE_IMG_STRIDE] =
+   elem_types[LP_JIT_TEXTURE_MIP_OFFSETS] =
+      LLVMArrayType(LLVMInt32TypeInContext(lc), LP_MAX_TEXTURE_LEVELS);
+   texture_type = LLVMStructTypeInContext(lc, elem_types,
+                                          LP_JIT_TEXTURE_NUM_FIELDS, 0);
+
+   elem_types[LP_JIT_SAMPLER_MIN_LOD] =
+   elem_types[LP_JIT_SAMPLER_MAX_LOD] =
+   elem_types[LP_JIT_SAMPLER_LOD_BIAS] = LLVMFloatTypeInContext(lc);
+   elem_types[LP_JIT_SAMPLER_BORDER_COLOR] =
+      LLVMArrayType(LLVMFloatTypeInContext(lc), 4);
+   sampler_type = LLVMStructTypeInContext(lc, elem_types,
+                                          LP_JIT_SAMPLER_NUM_FIELDS, 0);
+
+   ctx_types[SAMPLE_TEST_CTX_TEXTURE] = texture_type;
+   ctx_types[SAMPLE_TEST_CTX_SAMPLER] = sampler_type;
+   context_type = LLVMStructTypeInContext(lc, ctx_types,
+                                          ARRAY_SIZE(ctx_types), 0);
+
+   LP_CHECK_MEMBER_OFFSET(struct sample_test_context, sampler,
+                          gallivm->target, context_type,
+                          SAMPLE_TEST_CTX_SAMPLER);
+   LP_CHECK_STRUCT_SIZE(struct sample_test_context,
+                        gallivm->target, context_type);
+
+   return context_type;
+}
+
+
+static LLVMValueRef
+sample_test_member(struct gallivm_state *gallivm,
+                   LLVMValueRef context_ptr,
+                   unsigned struct_index,
+                   unsigned member_index,
+                   boolean emit_load)
+{
+   LLVMValueRef indices[3];
+   LLVMValueRef ptr;
+
+   indices[0] = lp_build_const_int32(gallivm, 0);
+   indices[1] = lp_build_const_int32(gallivm, struct_index);
+   indices[2] = lp_build_const_int32(gallivm, member_index);
+
+   ptr = LLVMBuildGEP(gallivm->builder, context_ptr,
+                      indices, ARRAY_SIZE(indices), "");
+
+   return emit_load ? LLVMBuildLoad(gallivm->builder, ptr, "") : ptr;
+}
+
+
+#define SAMPLE_TEST_MEMBER(_name, _struct, _index, _emit_load)  \
+   static LLVMValueRef \
+   sample_test_##_name(const struct lp_sampler_dynamic_state *base, \
+                       struct gallivm_state *gallivm, \
+                       LLVMValueRef context_ptr, \
+                       unsigned unit) \
+   { \
+      return sample_test_member(gallivm, context_ptr, \
+                                _struct, _index, _emit_load); \
+   }
+
+
+SAMPLE_TEST_MEMBER(width,       SAMPLE_TEST_CTX_TEXTURE, LP_JIT_TEXTURE_WIDTH, TRUE)
+SAMPLE_TEST_MEMBER(height,      SAMPLE_TEST_CTX_TEXTURE, LP_JIT_TEXTURE_HEIGHT, TRUE)
+SAMPLE_TEST_MEMBER(depth,       SAMPLE_TEST_CTX_TEXTURE, LP_JIT_TEXTURE_DEPTH, TRUE)
+SAMPLE_TEST_MEMBER(first_level, SAMPLE_TEST_CTX_TEXTURE, LP_JIT_TEXTURE_FIRST_LEVEL, TRUE)
+SAMPLE_TEST_MEMBER(last_level,  SAMPLE_TEST_CTX_TEXTURE, LP_JIT_TEXTURE_LAST_LEVEL, TRUE)
+SAMPLE_TEST_MEMBER(base_ptr,    SAMPLE_TEST_CTX_TEXTURE, LP_JIT_TEXTURE_BASE, TRUE)
+SAMPLE_TEST_MEMBER(row_stride,  SAMPLE_TEST_CTX_TEXTURE, LP_JIT_TEXTURE_ROW_STRIDE, FALSE)
+SAMPLE_TEST_MEMBER(img_stride,  SAMPLE_TEST_CTX_TEXTURE, LP_JIT_TEXTURE_IMG_STRIDE, FALSE)
+SAMPLE_TEST_MEMBER(mip_offsets, SAMPLE_TEST_CTX_TEXTURE, LP_JIT_TEXTURE_MIP_OFFSETS, FALSE)
+SAMPLE_TEST_MEMBER(min_lod,     SAMPLE_TEST_CTX_SAMPLER, LP_JIT_SAMPLER_MIN_LOD, TRUE)
+SAMPLE_TEST_MEMBER(max_lod,     SAMPLE_TEST_CTX_SAMPLER, LP_JIT_SAMPLER_MAX_LOD, TRUE)
+SAMPLE_TEST_MEMBER(lod_bias,    SAMPLE_TEST_CTX_SAMPLER, LP_JIT_SAMPLER_LOD_BIAS, TRUE)
+SAMPLE_TEST_MEMBER(border_color, SAMPLE_TEST_CTX_SAMPLER, LP_JIT_SAMPLER_BORDER_COLOR, FALSE)
+
+
+static LLVMValueRef
+add_sample_test(struct gallivm_state *gallivm,
+                const struct sample_test_key *key,
+                struct lp_type type)
+{
+   LLVMModuleRef module = gallivm->module;
+   LLVMContextRef context = gallivm->context;
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef vec_type = lp_build_vec_type(gallivm, type);
+   struct lp_static_texture_state texture_state;
+   struct lp_static_sampler_state sampler_state;
+   struct lp_sampler_dynamic_state dynamic_state;
+   struct lp_sampler_params params;
+   LLVMTypeRef args[4];
+   LLVMValueRef func;
+   LLVMValueRef context_ptr, s_ptr, t_ptr, texels_ptr;
+   LLVMValueRef coords[5];
+   LLVMValueRef offsets[3] = { NULL, NULL, NULL };
+   LLVMValueRef texel[4];
+   LLVMBasicBlockRef block;
+   unsigned chan;
+
+   memset(&texture_state, 0, sizeof texture_state);
+   texture_state.format = key->format;
+   texture_state.swizzle_r = PIPE_SWIZZLE_X;
+   texture_state.swizzle_g = PIPE_SWIZZLE_Y;
+   texture_state.swizzle_b = PIPE_SWIZZLE_Z;
+   texture_state.swizzle_a = PIPE_SWIZZLE_W;
+   texture_state.target = PIPE_TEXTURE_2D;
+   texture_state.pot_width = util_is_power_of_two(key->width);
+   texture_state.pot_height = util_is_power_of_two(key->height);
+   texture_state.pot_depth = 1;
+
+   memset(&sampler_state, 0, sizeof sampler_state);
+   sampler_state.wrap_s = key->wrap;
+   sampler_state.wrap_t = key->wrap;
+   sampler_state.wrap_r = key->wrap;
+   sampler_state.min_img_filter = key->img_filter;
+   sampler_state.mag_img_filter = key->img_filter;
+   sampler_state.min_mip_filter = key->mip_filter;
+   sampler_state.normalized_coords = 1;
+
+   memset(&dynamic_state, 0, sizeof dynamic_state);
+   dynamic_state.width = sample_test_width;
+   dynamic_state.height = sample_test_height;
+   dynamic_state.depth = sample_test_depth;
+   dynamic_state.first_level = sample_test_first_level;
+   dynamic_state.last_level = sample_test_last_level;
+   dynamic_state.base_ptr = sample_test_base_ptr;
+   dynamic_state.row_stride = sample_test_row_stride;
+   dynamic_state.img_stride = sample_test_img_stride;
+   dynamic_state.mip_offsets = sample_test_mip_offsets;
+   dynamic_state.min_lod = sample_test_min_lod;
+   dynamic_state.max_lod = sample_test_max_lod;
+   dynamic_state.lod_bias = sample_test_lod_bias;
+   dynamic_state.border_color = sample_test_border_color;
+
+   args[0] = LLVMPointerType(create_context_type(gallivm), 0);
+   args[1] = LLVMPointerType(vec_type, 0);
+   args[2] = LLVMPointerType(vec_type, 0);
+   args[3] = LLVMPointerType(vec_type, 0);
+
+   func = LLVMAddFunction(module, "test",
+                          LLVMFunctionType(LLVMVoidTypeInContext(context),
+                                           args, ARRAY_SIZE(args), 0));
+   LLVMSetFunctionCallConv(func, LLVMCCallConv);
+   context_ptr = LLVMGetParam(func, 0);
+   s_ptr = LLVMGetParam(func, 1);
+   t_ptr = LLVMGetParam(func, 2);
+   texels_ptr = LLVMGetParam(func, 3);
+
+   block = LLVMAppendBasicBlockInContext(context, func, "entry");
+   LLVMPositionBuilderAtEnd(builder, block);
+
+   coords[0] = LLVMBuildLoad(builder, s_ptr, "s");
+   coords[1] = LLVMBuildLoad(builder, t_ptr, "t");
+   coords[2] = coords[3] = coords[4] = LLVMGetUndef(vec_type);
+
+   /* plain TEX with implicit lod, same as the fragment shader would do */
+   memset(&params, 0, sizeof params);
+   params.type = type;
+   params.texture_index = 0;
+   params.sampler_index = 0;
+   params.sample_key = (LP_SAMPLER_OP_TEXTURE << LP_SAMPLER_OP_TYPE_SHIFT) |
+                       (LP_SAMPLER_LOD_IMPLICIT << LP_SAMPLER_LOD_CONTROL_SHIFT) |
+                       (LP_SAMPLER_LOD_SCALAR << LP_SAMPLER_LOD_PROPERTY_SHIFT);
+   params.context_ptr = context_ptr;
+   params.thread_data_ptr = NULL;
+   params.coords = coords;
+   params.offsets = offsets;
+   params.texel = texel;
+
+   lp_build_sample_soa(&texture_state, &sampler_state, &dynamic_state,
+                       gallivm, &params);
+
+   for (chan = 0; chan < 4; ++chan) {
+      LLVMValueRef index = lp_build_const_int32(gallivm, chan);
+      LLVMValueRef ptr = LLVMBuildGEP(builder, texels_ptr, &index, 1, "");
+      LLVMBuildStore(builder, texel[chan], ptr);
+   }
+
+   LLVMBuildRetVoid(builder);
+
+   gallivm_verify_function(gallivm, func);
+
+   return func;
+}
+
+
+static int
+wrap_coord(int i, unsigned size, unsigned wrap)
+{
+   if (wrap == PIPE_TEX_WRAP_REPEAT) {
+      i %= (int)size;
+      return i < 0 ? i + size : i;
+   }
+   else {
+      assert(wrap == PIPE_TEX_WRAP_CLAMP_TO_EDGE);
+      return CLAMP(i, 0, (int)size - 1);
+   }
+}
+
+
+static void
+fetch_texel(const struct util_format_description *desc,
+            const struct sample_test_key *key,
+            const uint8_t *data, unsigned stride,
+            int x, int y, float texel[4])
+{
+   x = wrap_coord(x, key->width, key->wrap);
+   y = wrap_coord(y, key->height, key->wrap);
+   desc->fetch_rgba_float(texel, data + y * stride + x * desc->block.bits/8,
+                          0, 0);
+}
+
+
+/**
+ * Reference implementation. Linear filtering uses 8 bits of subtexel
+ * precision, as the generated code does.
+ */
+static void
+sample_ref(const struct util_format_description *desc,
+           const struct sample_test_key *key,
+           const uint8_t *data, unsigned stride,
+           float s, float t, float texel[4])
+{
+   float u = s * key->width;
+   float v = t * key->height;
+   unsigned chan;
+
+   if (key->img_filter == PIPE_TEX_FILTER_NEAREST) {
+      fetch_texel(desc, key, data, stride,
+                  (int)floorf(u), (int)floorf(v), texel);
+   }
+   else {
+      float t00[4], t01[4], t10[4], t11[4];
+      float fu, fv;
+      int iu, iv;
+
+      u = roundf(u * 256.0f - 128.0f) / 256.0f;
+      v = roundf(v * 256.0f - 128.0f) / 256.0f;
+      iu = (int)floorf(u);
+      iv = (int)floorf(v);
+      fu = u - iu;
+      fv = v - iv;
+
+      fetch_texel(desc, key, data, stride, iu,     iv,     t00);
+      fetch_texel(desc, key, data, stride, iu + 1, iv,     t01);
+      fetch_texel(desc, key, data, stride, iu,     iv + 1, t10);
+      fetch_texel(desc, key, data, stride, iu + 1, iv + 1, t11);
+
+      for (chan = 0; chan < 4; ++chan) {
+         float top = t00[chan] + fu * (t01[chan] - t00[chan]);
+         float bottom = t10[chan] + fu * (t11[chan] - t10[chan]);
+         texel[chan] = top + fv * (bottom - top);
+      }
+   }
+}
+
+
+/**
+ * Generate texture coordinates for a screen-aligned quad slightly larger
+ * than the texture, laid out in 2x2 pixel quads as the rasterizer would.
+ * For nearest filtering the coordinates are snapped to texel centers so
+ * that rounding differences can't pick a different texel.
+ */
+static void
+generate_coords(const struct sample_test_key *key,
+                struct lp_type type,
+                float *s, float *t)
+{
+   const unsigned num_quads = type.length / 4;
+   unsigned x, y, q, i = 0;
+
+   for (y = 0; y < SCREEN_HEIGHT; y += 2) {
+      for (x = 0; x < SCREEN_WIDTH; x += 2 * num_quads) {
+         for (q = 0; q < num_quads; ++q) {
+            unsigned j;
+            for (j = 0; j < 4; ++j) {
+               float px = x + 2 * q + (j & 1) + 0.5f;
+               float py = y + (j >> 1) + 0.5f;
+               float u = (px * 1.25f / SCREEN_WIDTH - 0.125f) * key->width;
+               float v = (py * 1.25f / SCREEN_HEIGHT - 0.125f) * key->height;
+
+               if (key->img_filter == PIPE_TEX_FILTER_NEAREST) {
+                  u = floorf(u) + 0.5f;
+                  v = floorf(v) + 0.5f;
+               }
+
+               s[i] = u / key->width;
+               t[i] = v / key->height;
+               ++i;
+            }
+         }
+      }
+   }
+}
+
+
+PIPE_ALIGN_STACK
+static boolean
+test_one(unsigned verbose,
+         FILE *fp,
+         const struct sample_test_key *key,
+         struct lp_type type)
+{
+   const struct util_format_description *desc =
+      util_format_description(key->format);
+   const unsigned num_texels = SCREEN_WIDTH * SCREEN_HEIGHT;
+   const unsigned num_vecs = num_texels / type.length;
+   const unsigned stride = align(key->width * desc->block.bits/8, 64);
+   const double eps = 3.0 / 255.0;
+   LLVMContextRef context;
+   struct gallivm_state *gallivm;
+   LLVMValueRef func;
+   sample_test_ptr_t sample_test_ptr;
+   struct sample_test_context *ctx;
+   uint8_t *data;
+   float *s, *t, *texels;
+   int64_t cycles[LP_TEST_NUM_SAMPLES];
+   int64_t nanoseconds[LP_TEST_NUM_SAMPLES];
+   double cycles_avg, mtexels;
+   boolean success = TRUE;
+   unsigned i, j, chan;
+
+   if (verbose >= 1)
+      dump_sample_key(stdout, key, type);
+
+   context = LLVMContextCreate();
+   gallivm = gallivm_create("test_module", context);
+
+   func = add_sample_test(gallivm, key, type);
+
+   gallivm_compile_module(gallivm);
+
+   sample_test_ptr = (sample_test_ptr_t)gallivm_jit_function(gallivm, func);
+
+   gallivm_free_ir(gallivm);
+
+   data = align_malloc(stride * key->height, 64);
+   ctx = align_malloc(sizeof *ctx, 16);
+   s = align_malloc(num_texels * sizeof *s, 32);
+   t = align_malloc(num_texels * sizeof *t, 32);
+   texels = align_malloc(4 * num_texels * sizeof *texels, 32);
+
+   for (i = 0; i < stride * key->height; ++i)
+      data[i] = rand();
+
+   memset(ctx, 0, sizeof *ctx);
+   ctx->texture.width = key->width;
+   ctx->texture.height = key->height;
+   ctx->texture.depth = 1;
+   ctx->texture.base = data;
+   ctx->texture.row_stride[0] = stride;
+   ctx->texture.img_stride[0] = stride * key->height;
+   ctx->sampler.max_lod = 1000.0f;
+
+   generate_coords(key, type, s, t);
+
+   /*
+    * Correctness: run once over the whole grid and compare every texel.
+    */
+   for (i = 0; i < num_vecs; ++i) {
+      sample_test_ptr(ctx, s + i * type.length, t + i * type.length,
+                      texels + 4 * i * type.length);
+   }
+
+   for (i = 0; i < num_vecs && success; ++i) {
+      for (j = 0; j < type.length; ++j) {
+         unsigned k = i * type.length + j;
+         float ref[4];
+
+         sample_ref(desc, key, data, stride, s[k], t[k], ref);
+
+         for (chan = 0; chan < 4; ++chan) {
+            float res = texels[(4 * i + chan) * type.length + j];
+            if (fabs(res - ref[chan]) > eps) {
+               success = FALSE;
+            }
+         }
+
+         if (!success) {
+            if (verbose < 1)
+               dump_sample_key(stderr, key, type);
+            fprintf(stderr, "MISMATCH at s=%f t=%f\n", s[k], t[k]);
+            fprintf(stderr, "  Res: %f %f %f %f\n",
+                    texels[(4 * i + 0) * type.length + j],
+                    texels[(4 * i + 1) * type.length + j],
+                    texels[(4 * i + 2) * type.length + j],
+                    texels[(4 * i + 3) * type.length + j]);
+            fprintf(stderr, "  Ref: %f %f %f %f\n",
+                    ref[0], ref[1], ref[2], ref[3]);
+            break;
+         }
+      }
+   }
+
+   /*
+    * Performance: time whole passes over the grid.
+    */
+   for (i = 0; i < LP_TEST_NUM_SAMPLES; ++i) {
+      int64_t start_time = os_time_get_nano();
+      int64_t start_counter = rdtsc();
+
+      for (j = 0; j < num_vecs; ++j) {
+         sample_test_ptr(ctx, s + j * type.length, t + j * type.length,
+                         texels + 4 * j * type.length);
+      }
+
+      cycles[i] = rdtsc() - start_counter;
+      nanoseconds[i] = os_time_get_nano() - start_time;
+   }
+
+   /*
+    * Drop outliers (IRQs, page faults on the first pass, ...) as the
+    * other tests do, then use the fastest remaining time for throughput.
+    */
+   {
+      double sum = 0.0, sum2 = 0.0;
+      double avg, std;
+      int64_t best_ns = INT64_MAX;
+      unsigned m, n = LP_TEST_NUM_SAMPLES;
+
+      for (i = 0; i < n; ++i) {
+         sum += cycles[i];
+         sum2 += cycles[i]*cycles[i];
+      }
+
+      avg = sum/n;
+      std = sqrtf((sum2 - n*avg*avg)/n);
+
+      m = 0;
+      sum = 0.0;
+      for (i = 0; i < n; ++i) {
+         if (fabs(cycles[i] - avg) <= 4.0*std) {
+            sum += cycles[i];
+            ++m;
+         }
+         best_ns = MIN2(best_ns, nanoseconds[i]);
+      }
+
+      cycles_avg = sum/m/num_texels;
+      mtexels = best_ns > 0 ? num_texels * 1000.0 / best_ns : 0.0;
+   }
+
+   if (verbose >= 1) {
+      fprintf(stdout, "  %.1f cycles/texel, %.1f Mtexels/s\n",
+              cycles_avg, mtexels);
+   }
+
+   if (fp)
+      write_tsv_row(fp, key, type, cycles_avg, mtexels, success);
+
+   align_free(texels);
+   align_free(t);
+   align_free(s);
+   align_free(ctx);
+   align_free(data);
+
+   gallivm_destroy(gallivm);
+   LLVMContextDispose(context);
+
+   return success;
+}
+
+
+const enum pipe_format sample_formats[] = {
+   PIPE_FORMAT_R8G8B8A8_UNORM,
+   PIPE_FORMAT_B8G8R8A8_UNORM,
+};
+
+
+const unsigned sample_wraps[] = {
+   PIPE_TEX_WRAP_REPEAT,
+   PIPE_TEX_WRAP_CLAMP_TO_EDGE,
+};
+
+
+const unsigned sample_img_filters[] = {
+   PIPE_TEX_FILTER_NEAREST,
+   PIPE_TEX_FILTER_LINEAR,
+};
+
+
+const unsigned sample_mip_filters[] = {
+   PIPE_TEX_MIPFILTER_NONE,
+   PIPE_TEX_MIPFILTER_NEAREST,
+};
+
+
+/* power of two and non power of two sizes take different wrap paths */
+const unsigned sample_sizes[][2] = {
+   { 256, 256 },
+   { 200, 120 },
+};
+
+
+const struct lp_type sample_types[] = {
+   /* float, fixed,  sign,  norm, width, len */
+   {   TRUE, FALSE,  TRUE, FALSE,    32,   4 },
+   {   TRUE, FALSE,  TRUE, FALSE,    32,   8 },
+};
+
+
+const unsigned num_formats = ARRAY_SIZE(sample_formats);
+const unsigned num_wraps = ARRAY_SIZE(sample_wraps);
+const unsigned num_img_filters = ARRAY_SIZE(sample_img_filters);
+const unsigned num_mip_filters = ARRAY_SIZE(sample_mip_filters);
+const unsigned num_sizes = ARRAY_SIZE(sample_sizes);
+const unsigned num_types = ARRAY_SIZE(sample_types);
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   unsigned format, wrap, img_filter, mip_filter, size, type;
+   boolean success = TRUE;
+
+   for (format = 0; format < num_formats; ++format) {
+      for (wrap = 0; wrap < num_wraps; ++wrap) {
+         for (img_filter = 0; img_filter < num_img_filters; ++img_filter) {
+            for (mip_filter = 0; mip_filter < num_mip_filters; ++mip_filter) {
+               for (size = 0; size < num_sizes; ++size) {
+                  for (type = 0; type < num_types; ++type) {
+                     struct sample_test_key key;
+
+                     key.format = sample_formats[format];
+                     key.wrap = sample_wraps[wrap];
+                     key.img_filter = sample_img_filters[img_filter];
+                     key.mip_filter = sample_mip_filters[mip_filter];
+                     key.width = sample_sizes[size][0];
+                     key.height = sample_sizes[size][1];
+
+                     if (!test_one(verbose, fp, &key, sample_types[type]))
+                        success = FALSE;
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   unsigned long i;
+   boolean success = TRUE;
+
+   for (i = 0; i < n; ++i) {
+      struct sample_test_key key;
+      unsigned size = rand() % num_sizes;
+
+      key.format = sample_formats[rand() % num_formats];
+      key.wrap = sample_wraps[rand() % num_wraps];
+      key.img_filter = sample_img_filters[rand() % num_img_filters];
+      key.mip_filter = sample_mip_filters[rand() % num_mip_filters];
+      key.width = sample_sizes[size][0];
+      key.height = sample_sizes[size][1];
+
+      if (!test_one(verbose, fp, &key, sample_types[rand() % num_types]))
+         success = FALSE;
+   }
+
+   return success;
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   struct sample_test_key key;
+
+   /* the most common case: rgba8 bilinear, repeat, no mipmapping */
+   key.format = PIPE_FORMAT_R8G8B8A8_UNORM;
+   key.wrap = PIPE_TEX_WRAP_REPEAT;
+   key.img_filter = PIPE_TEX_FILTER_LINEAR;
+   key.mip_filter = PIPE_TEX_MIPFILTER_NONE;
+   key.width = 256;
+   key.height = 256;
+
+   return test_one(verbose, fp, &key, sample_types[0]);
+}
@@ -43,6 +43,7 @@
 #include "pipe/p_defines.h"
 #include "pipe/p_shader_tokens.h"
 #include "gallivm/lp_bld_debug.h"
+#include "gallivm/lp_bld_format.h"
 #include "gallivm/lp_bld_const.h"
 #include "gallivm/lp_bld_type.h"
 #include "gallivm/lp_bld_sample.h"
@@ -316,7 +317,9 @@ lp_llvm_sampler_soa_create(const struct lp_sampler_static_state *static_state)
    sampler->dynamic_state.base.border_color = lp_llvm_sampler_border_color;
 
 #if LP_USE_TEXTURE_CACHE
-   sampler->dynamic_state.base.cache_ptr = lp_llvm_texture_cache_ptr;
+   if (lp_build_format_cache_size) {
+      sampler->dynamic_state.base.cache_ptr = lp_llvm_texture_cache_ptr;
+   }
 #endif
 
    sampler->dynamic_state.static_state = static_state;
@@ -35,9 +35,11 @@
 struct lp_sampler_static_state;
 
 /**
- * Whether texture cache is used for s3tc textures.
+ * Whether texture cache is used for formats needing expensive block decoding
+ * (s3tc, rgtc, etc.). Can still be disabled at runtime with
+ * LP_TEXTURE_CACHE_SIZE=0.
  */
-#define LP_USE_TEXTURE_CACHE 0
+#define LP_USE_TEXTURE_CACHE 1
 
 /**
  * Pure-LLVM texture sampling code generator.
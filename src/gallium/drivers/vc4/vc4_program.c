@@ -2184,6 +2184,7 @@ static const nir_shader_compiler_options nir_options = {
         .lower_fsqrt = true,
         .lower_negate = true,
         .native_integers = true,
+        .opt_pre = true,
         .max_unroll_iterations = 32,
 };
 
@@ -721,6 +721,17 @@ struct pipe_draw_info
 };
 
 
+/**
+ * One of the ranges drawn by a multi_draw_vbo call.
+ */
+struct pipe_draw_start_count
+{
+   unsigned start;  /**< the index of the first vertex */
+   unsigned count;  /**< number of vertices */
+   int index_bias;  /**< a bias to be added to each index */
+};
+
+
 /**
  * Information to describe a blit call.
  */
@@ -43,6 +43,7 @@
    .lower_flrp64 = true,                                                      \
    .native_integers = true,                                                   \
    .use_interpolated_input_intrinsics = true,                                 \
+   .opt_pre = true,                                                           \
    .vertex_id_zero_based = true
 
 static const struct nir_shader_compiler_options scalar_nir_options = {
@@ -170,6 +170,7 @@ _mesa_delete_vao(struct gl_context *ctx, struct gl_vertex_array_object *obj)
    unbind_array_object_vbos(ctx, obj);
    _mesa_reference_buffer_object(ctx, &obj->IndexBufferObj, NULL);
    mtx_destroy(&obj->Mutex);
+   free(obj->DriverLayout);
    free(obj->Label);
    free(obj);
 }
@@ -349,6 +350,9 @@ _mesa_update_vao_client_arrays(struct gl_context *ctx,
 {
    GLbitfield64 arrays = vao->NewArrays;
 
+   if (arrays)
+      vao->LayoutStamp++;
+
    while (arrays) {
       const int attrib = u_bit_scan64(&arrays);
       struct gl_vertex_array *client_array = &vao->_VertexAttrib[attrib];
@@ -1493,6 +1493,7 @@ copy_array_object(struct gl_context *ctx,
    /* The bitmask of bound VBOs needs to match the VertexBinding array */
    dest->VertexAttribBufferMask = src->VertexAttribBufferMask;
    dest->NewArrays = src->NewArrays;
+   dest->LayoutStamp++;
 }
 
 /**
@@ -23,10 +23,36 @@
  */
 
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
 #include "main/imports.h"
 #include "main/cpuinfo.h"
 
 
+/**
+ * Return the number of online CPUs, at least 1.
+ */
+unsigned
+_mesa_get_cpu_count(void)
+{
+#if defined(_WIN32)
+   SYSTEM_INFO system_info;
+   GetSystemInfo(&system_info);
+   return system_info.dwNumberOfProcessors > 1 ?
+          system_info.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+   long n = sysconf(_SC_NPROCESSORS_ONLN);
+   return n > 1 ? n : 1;
+#else
+   return 1;
+#endif
+}
+
+
 /**
  * This function should be called before the various "cpu_has_foo" macros
  * are used.
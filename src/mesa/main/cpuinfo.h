@@ -32,12 +32,24 @@
 #endif
 
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 extern void
 _mesa_get_cpu_features(void);
 
 
+extern unsigned
+_mesa_get_cpu_count(void);
+
+
 extern char *
 _mesa_get_cpu_string(void);
 
+#ifdef __cplusplus
+}
+#endif
+
 
 #endif /* CPUINFO_H */
@@ -1843,6 +1843,48 @@ invalidate_saved_current_state(struct gl_context *ctx)
 }
 
 
+/**
+ * Enable caps whose state we track while building a display list, like
+ * the shade model, to drop redundant glEnable/Disable calls.  Caps that
+ * depend on other state, such as the active texture unit, can't be
+ * tracked.
+ */
+static GLbitfield
+saved_enable_bit(GLenum cap)
+{
+   switch (cap) {
+   case GL_ALPHA_TEST:           return 1 << 0;
+   case GL_BLEND:                return 1 << 1;
+   case GL_COLOR_MATERIAL:       return 1 << 2;
+   case GL_CULL_FACE:            return 1 << 3;
+   case GL_DEPTH_TEST:           return 1 << 4;
+   case GL_FOG:                  return 1 << 5;
+   case GL_LIGHTING:             return 1 << 6;
+   case GL_LINE_SMOOTH:          return 1 << 7;
+   case GL_LINE_STIPPLE:         return 1 << 8;
+   case GL_NORMALIZE:            return 1 << 9;
+   case GL_POLYGON_OFFSET_FILL:  return 1 << 10;
+   case GL_POLYGON_STIPPLE:      return 1 << 11;
+   case GL_STENCIL_TEST:         return 1 << 12;
+   default:                      return 0;
+   }
+}
+
+
+/**
+ * Called when cap is changed in a way we don't track, e.g. for a single
+ * draw buffer with glEnablei.
+ */
+static void
+forget_saved_enable(struct gl_context *ctx, GLenum cap)
+{
+   const GLbitfield bit = saved_enable_bit(cap);
+
+   ctx->ListState.Current.Enabled &= ~bit;
+   ctx->ListState.Current.Disabled &= ~bit;
+}
+
+
 static void GLAPIENTRY
 save_CallList(GLuint list)
 {
@@ -2365,11 +2407,20 @@ save_CullFace(GLenum mode)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
-   n = alloc_instruction(ctx, OPCODE_CULL_FACE, 1);
-   if (n) {
-      n[1].e = mode;
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   /* Don't compile this call if it's a no-op. */
+   if (ctx->ListState.Current.CullFace != mode) {
+      SAVE_FLUSH_VERTICES(ctx);
+
+      ctx->ListState.Current.CullFace = mode;
+
+      n = alloc_instruction(ctx, OPCODE_CULL_FACE, 1);
+      if (n) {
+         n[1].e = mode;
+      }
    }
+
    if (ctx->ExecuteFlag) {
       CALL_CullFace(ctx->Exec, (mode));
    }
@@ -2381,11 +2432,20 @@ save_DepthFunc(GLenum func)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
-   n = alloc_instruction(ctx, OPCODE_DEPTH_FUNC, 1);
-   if (n) {
-      n[1].e = func;
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   /* Don't compile this call if it's a no-op. */
+   if (ctx->ListState.Current.DepthFunc != func) {
+      SAVE_FLUSH_VERTICES(ctx);
+
+      ctx->ListState.Current.DepthFunc = func;
+
+      n = alloc_instruction(ctx, OPCODE_DEPTH_FUNC, 1);
+      if (n) {
+         n[1].e = func;
+      }
    }
+
    if (ctx->ExecuteFlag) {
       CALL_DepthFunc(ctx->Exec, (func));
    }
@@ -2397,11 +2457,20 @@ save_DepthMask(GLboolean mask)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
-   n = alloc_instruction(ctx, OPCODE_DEPTH_MASK, 1);
-   if (n) {
-      n[1].b = mask;
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   /* Don't compile this call if it's a no-op. */
+   if (ctx->ListState.Current.DepthMask != !!mask + 1) {
+      SAVE_FLUSH_VERTICES(ctx);
+
+      ctx->ListState.Current.DepthMask = !!mask + 1;
+
+      n = alloc_instruction(ctx, OPCODE_DEPTH_MASK, 1);
+      if (n) {
+         n[1].b = mask;
+      }
    }
+
    if (ctx->ExecuteFlag) {
       CALL_DepthMask(ctx->Exec, (mask));
    }
@@ -2429,12 +2498,23 @@ static void GLAPIENTRY
 save_Disable(GLenum cap)
 {
    GET_CURRENT_CONTEXT(ctx);
+   const GLbitfield bit = saved_enable_bit(cap);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
-   n = alloc_instruction(ctx, OPCODE_DISABLE, 1);
-   if (n) {
-      n[1].e = cap;
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   /* Don't compile this call if it's a no-op. */
+   if (!(ctx->ListState.Current.Disabled & bit)) {
+      SAVE_FLUSH_VERTICES(ctx);
+
+      ctx->ListState.Current.Disabled |= bit;
+      ctx->ListState.Current.Enabled &= ~bit;
+
+      n = alloc_instruction(ctx, OPCODE_DISABLE, 1);
+      if (n) {
+         n[1].e = cap;
+      }
    }
+
    if (ctx->ExecuteFlag) {
       CALL_Disable(ctx->Exec, (cap));
    }
@@ -2447,6 +2527,7 @@ save_DisableIndexed(GLuint index, GLenum cap)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   forget_saved_enable(ctx, cap);
    n = alloc_instruction(ctx, OPCODE_DISABLE_INDEXED, 2);
    if (n) {
       n[1].ui = index;
@@ -2504,12 +2585,23 @@ static void GLAPIENTRY
 save_Enable(GLenum cap)
 {
    GET_CURRENT_CONTEXT(ctx);
+   const GLbitfield bit = saved_enable_bit(cap);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
-   n = alloc_instruction(ctx, OPCODE_ENABLE, 1);
-   if (n) {
-      n[1].e = cap;
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   /* Don't compile this call if it's a no-op. */
+   if (!(ctx->ListState.Current.Enabled & bit)) {
+      SAVE_FLUSH_VERTICES(ctx);
+
+      ctx->ListState.Current.Enabled |= bit;
+      ctx->ListState.Current.Disabled &= ~bit;
+
+      n = alloc_instruction(ctx, OPCODE_ENABLE, 1);
+      if (n) {
+         n[1].e = cap;
+      }
    }
+
    if (ctx->ExecuteFlag) {
       CALL_Enable(ctx->Exec, (cap));
    }
@@ -2523,6 +2615,7 @@ save_EnableIndexed(GLuint index, GLenum cap)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   forget_saved_enable(ctx, cap);
    n = alloc_instruction(ctx, OPCODE_ENABLE_INDEXED, 2);
    if (n) {
       n[1].ui = index;
@@ -2649,11 +2742,20 @@ save_FrontFace(GLenum mode)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
-   n = alloc_instruction(ctx, OPCODE_FRONT_FACE, 1);
-   if (n) {
-      n[1].e = mode;
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   /* Don't compile this call if it's a no-op. */
+   if (ctx->ListState.Current.FrontFace != mode) {
+      SAVE_FLUSH_VERTICES(ctx);
+
+      ctx->ListState.Current.FrontFace = mode;
+
+      n = alloc_instruction(ctx, OPCODE_FRONT_FACE, 1);
+      if (n) {
+         n[1].e = mode;
+      }
    }
+
    if (ctx->ExecuteFlag) {
       CALL_FrontFace(ctx->Exec, (mode));
    }
@@ -2930,11 +3032,22 @@ save_LineWidth(GLfloat width)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
-   n = alloc_instruction(ctx, OPCODE_LINE_WIDTH, 1);
-   if (n) {
-      n[1].f = width;
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   /* Don't compile this call if it's a no-op.  Invalid widths are always
+    * compiled so that the error is raised when the list is executed.
+    */
+   if (ctx->ListState.Current.LineWidth != width || width <= 0.0F) {
+      SAVE_FLUSH_VERTICES(ctx);
+
+      ctx->ListState.Current.LineWidth = width;
+
+      n = alloc_instruction(ctx, OPCODE_LINE_WIDTH, 1);
+      if (n) {
+         n[1].f = width;
+      }
    }
+
    if (ctx->ExecuteFlag) {
       CALL_LineWidth(ctx->Exec, (width));
    }
@@ -3429,11 +3542,22 @@ save_PointSize(GLfloat size)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
-   n = alloc_instruction(ctx, OPCODE_POINT_SIZE, 1);
-   if (n) {
-      n[1].f = size;
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   /* Don't compile this call if it's a no-op.  Invalid sizes are always
+    * compiled so that the error is raised when the list is executed.
+    */
+   if (ctx->ListState.Current.PointSize != size || size <= 0.0F) {
+      SAVE_FLUSH_VERTICES(ctx);
+
+      ctx->ListState.Current.PointSize = size;
+
+      n = alloc_instruction(ctx, OPCODE_POINT_SIZE, 1);
+      if (n) {
+         n[1].f = size;
+      }
    }
+
    if (ctx->ExecuteFlag) {
       CALL_PointSize(ctx->Exec, (size));
    }
@@ -3525,6 +3649,10 @@ save_PopAttrib(void)
    GET_CURRENT_CONTEXT(ctx);
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
    (void) alloc_instruction(ctx, OPCODE_POP_ATTRIB, 0);
+
+   /* The restored state isn't known at compile time. */
+   memset(&ctx->ListState.Current, 0, sizeof ctx->ListState.Current);
+
    if (ctx->ExecuteFlag) {
       CALL_PopAttrib(ctx->Exec, ());
    }
@@ -3889,24 +4017,27 @@ save_ShadeModel(GLenum mode)
    Node *n;
    ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
 
-   if (ctx->ExecuteFlag) {
-      CALL_ShadeModel(ctx->Exec, (mode));
-   }
-
    /* Don't compile this call if it's a no-op.
     * By avoiding this state change we have a better chance of
     * coalescing subsequent drawing commands into one batch.
+    *
+    * Otherwise the pending vertices must be flushed first, as with
+    * GL_COMPILE_AND_EXECUTE they are executed at that point and must
+    * not see the new state.
     */
-   if (ctx->ListState.Current.ShadeModel == mode)
-      return;
+   if (ctx->ListState.Current.ShadeModel != mode) {
+      SAVE_FLUSH_VERTICES(ctx);
 
-   SAVE_FLUSH_VERTICES(ctx);
+      ctx->ListState.Current.ShadeModel = mode;
 
-   ctx->ListState.Current.ShadeModel = mode;
+      n = alloc_instruction(ctx, OPCODE_SHADE_MODEL, 1);
+      if (n) {
+         n[1].e = mode;
+      }
+   }
 
-   n = alloc_instruction(ctx, OPCODE_SHADE_MODEL, 1);
-   if (n) {
-      n[1].e = mode;
+   if (ctx->ExecuteFlag) {
+      CALL_ShadeModel(ctx->Exec, (mode));
    }
 }
 
@@ -1108,8 +1108,9 @@ create_new_program(struct gl_context *ctx, struct state_key *key)
 
    /* Conservative approach: Don't optimize here, the linker does it too. */
    if (!ctx->Const.GLSLOptimizeConservatively) {
+      opt_pass_tracker tracker;
       while (do_common_optimization(p.shader->ir, false, false, options,
-                                    ctx->Const.NativeIntegers))
+                                    ctx->Const.NativeIntegers, &tracker))
          ;
    }
 
@@ -26,6 +26,9 @@
 #include "glformats.h"
 #include "format_pack.h"
 #include "format_unpack.h"
+#include "parallel_rows.h"
+#include "sse_format_convert.h"
+#include "x86/common_x86_asm.h"
 
 const mesa_array_format RGBA32_FLOAT =
    MESA_ARRAY_FORMAT(4, 1, 1, 1, 4, 0, 1, 2, 3);
@@ -236,37 +239,10 @@ convert_ubyte_rgba_to_bgra(size_t width, size_t height,
 }
 
 
-/**
- * This can be used to convert between most color formats.
- *
- * Limitations:
- * - This function doesn't handle GL_COLOR_INDEX or YCBCR formats.
- * - This function doesn't handle byte-swapping or transferOps, these should
- *   be handled by the caller.
- *
- * \param void_dst  The address where converted color data will be stored.
- *                  The caller must ensure that the buffer is large enough
- *                  to hold the converted pixel data.
- * \param dst_format  The destination color format. It can be a mesa_format
- *                    or a mesa_array_format represented as an uint32_t.
- * \param dst_stride  The stride of the destination format in bytes.
- * \param void_src  The address of the source color data to convert.
- * \param src_format  The source color format. It can be a mesa_format
- *                    or a mesa_array_format represented as an uint32_t.
- * \param src_stride  The stride of the source format in bytes.
- * \param width  The width, in pixels, of the source image to convert.
- * \param height  The height, in pixels, of the source image to convert.
- * \param rebase_swizzle  A swizzle transform to apply during the conversion,
- *                        typically used to match a different internal base
- *                        format involved. NULL if no rebase transform is needed
- *                        (i.e. the internal base format and the base format of
- *                        the dst or the src -depending on whether we are doing
- *                        an upload or a download respectively- are the same).
- */
-void
-_mesa_format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
-                     void *void_src, uint32_t src_format, size_t src_stride,
-                     size_t width, size_t height, uint8_t *rebase_swizzle)
+static void
+format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
+               void *void_src, uint32_t src_format, size_t src_stride,
+               size_t width, size_t height, uint8_t *rebase_swizzle)
 {
    uint8_t *dst = (uint8_t *)void_dst;
    uint8_t *src = (uint8_t *)void_src;
@@ -632,6 +608,70 @@ _mesa_format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
    }
 }
 
+struct format_convert_job {
+   uint8_t *dst;
+   uint32_t dst_format;
+   size_t dst_stride;
+   uint8_t *src;
+   uint32_t src_format;
+   size_t src_stride;
+   size_t width;
+   uint8_t *rebase_swizzle;
+};
+
+static void
+format_convert_rows(void *data, size_t y, size_t height)
+{
+   struct format_convert_job *job = (struct format_convert_job *) data;
+
+   format_convert(job->dst + y * job->dst_stride, job->dst_format,
+                  job->dst_stride, job->src + y * job->src_stride,
+                  job->src_format, job->src_stride, job->width, height,
+                  job->rebase_swizzle);
+}
+
+/**
+ * This can be used to convert between most color formats.
+ *
+ * Limitations:
+ * - This function doesn't handle GL_COLOR_INDEX or YCBCR formats.
+ * - This function doesn't handle byte-swapping or transferOps, these should
+ *   be handled by the caller.
+ *
+ * \param void_dst  The address where converted color data will be stored.
+ *                  The caller must ensure that the buffer is large enough
+ *                  to hold the converted pixel data.
+ * \param dst_format  The destination color format. It can be a mesa_format
+ *                    or a mesa_array_format represented as an uint32_t.
+ * \param dst_stride  The stride of the destination format in bytes.
+ * \param void_src  The address of the source color data to convert.
+ * \param src_format  The source color format. It can be a mesa_format
+ *                    or a mesa_array_format represented as an uint32_t.
+ * \param src_stride  The stride of the source format in bytes.
+ * \param width  The width, in pixels, of the source image to convert.
+ * \param height  The height, in pixels, of the source image to convert.
+ * \param rebase_swizzle  A swizzle transform to apply during the conversion,
+ *                        typically used to match a different internal base
+ *                        format involved. NULL if no rebase transform is needed
+ *                        (i.e. the internal base format and the base format of
+ *                        the dst or the src -depending on whether we are doing
+ *                        an upload or a download respectively- are the same).
+ */
+void
+_mesa_format_convert(void *void_dst, uint32_t dst_format, size_t dst_stride,
+                     void *void_src, uint32_t src_format, size_t src_stride,
+                     size_t width, size_t height, uint8_t *rebase_swizzle)
+{
+   struct format_convert_job job = {
+      (uint8_t *) void_dst, dst_format, dst_stride,
+      (uint8_t *) void_src, src_format, src_stride,
+      width, rebase_swizzle
+   };
+
+   /* Large images are converted in bands of rows on several threads. */
+   _mesa_parallel_rows(width, height, format_convert_rows, &job);
+}
+
 static const uint8_t map_identity[7] = { 0, 1, 2, 3, 4, 5, 6 };
 static const uint8_t map_3210[7] = { 3, 2, 1, 0, 4, 5, 6 };
 static const uint8_t map_1032[7] = { 1, 0, 3, 2, 4, 5, 6 };
@@ -1496,6 +1536,14 @@ _mesa_swizzle_and_convert(void *void_dst, enum mesa_array_format_datatype dst_ty
                                   swizzle, normalized, count))
       return;
 
+#if defined(USE_SSE41)
+   if (cpu_has_sse4_1 &&
+       _mesa_swizzle_and_convert_sse41(void_dst, dst_type, num_dst_channels,
+                                       void_src, src_type, num_src_channels,
+                                       swizzle, normalized, count))
+      return;
+#endif
+
    switch (dst_type) {
    case MESA_ARRAY_FORMAT_TYPE_FLOAT:
       convert_float(void_dst, num_dst_channels, void_src, src_type,
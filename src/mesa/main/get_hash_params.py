@@ -952,6 +952,9 @@ descriptor=[
 
 # GL_ARB_sparse_buffer
   [ "SPARSE_BUFFER_PAGE_SIZE_ARB", "CONTEXT_INT(Const.SparseBufferPageSize), extra_ARB_sparse_buffer" ],
+
+# GL_ARB_parallel_shader_compile
+  [ "MAX_SHADER_COMPILER_THREADS_ARB", "CONTEXT_UINT(ShaderCompiler.MaxThreads), extra_ARB_parallel_shader_compile" ],
 ]},
 
 # Enums restricted to OpenGL Core profile
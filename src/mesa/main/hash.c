@@ -38,6 +38,7 @@
 #include "imports.h"
 #include "hash.h"
 #include "util/hash_table.h"
+#include "util/u_atomic.h"
 
 /**
  * Magic GLuint object name that gets stored outside of the struct hash_table.
@@ -52,11 +53,35 @@
  */
 #define DELETED_KEY_VALUE 1
 
+/**
+ * Direct-mapped storage for small keys.
+ *
+ * Object names come from glGen*() and are small, dense integers, so the
+ * data for all keys below the size of the map is kept in a plain array
+ * that _mesa_HashLookup() reads without taking the mutex.  Bigger keys go
+ * into the hash table.  A key is never in both places.
+ *
+ * The map only grows, and while it is replaced under the mutex a lookup
+ * may still be reading the old one.  Old maps are therefore chained to
+ * the new one and only freed with the table.  As the size doubles each
+ * time, they never take more memory than the current map.
+ */
+struct direct_map {
+   GLuint size;
+   struct direct_map *prev;   /**< the map this one replaced */
+   void *data[];              /**< NULL for keys not in the table */
+};
+
+#define DIRECT_MAP_MIN_SIZE 256
+#define DIRECT_MAP_MAX_SIZE (1 << 16)
+
 /**
  * The hash table data structure.  
  */
 struct _mesa_HashTable {
    struct hash_table *ht;
+   struct direct_map *Direct;  /**< keys below Direct->size, may be NULL */
+   GLuint NumDirect;           /**< number of entries in Direct */
    GLuint MaxKey;                        /**< highest key inserted so far */
    mtx_t Mutex;                /**< mutual exclusion lock */
    GLboolean InDeleteAll;                /**< Debug check */
@@ -154,20 +179,80 @@ _mesa_NewHashTable(void)
 void
 _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 {
+   struct direct_map *map, *prev;
+
    assert(table);
 
-   if (_mesa_hash_table_next_entry(table->ht, NULL) != NULL) {
+   if (_mesa_hash_table_next_entry(table->ht, NULL) != NULL ||
+       table->NumDirect) {
       _mesa_problem(NULL, "In _mesa_DeleteHashTable, found non-freed data");
    }
 
    _mesa_hash_table_destroy(table->ht, NULL);
 
+   for (map = table->Direct; map; map = prev) {
+      prev = map->prev;
+      free(map);
+   }
+
    mtx_destroy(&table->Mutex);
    free(table);
 }
 
 
 
+/**
+ * Make the direct map cover key, moving the entries it now covers out of
+ * the hash table.  Must be called with the mutex held.
+ *
+ * \return false if key is too big for the direct map or out of memory.
+ */
+static bool
+direct_map_reserve(struct _mesa_HashTable *table, GLuint key)
+{
+   struct direct_map *old = table->Direct;
+   struct direct_map *map;
+   struct hash_entry *entry;
+   GLuint size;
+
+   if (old && key < old->size)
+      return true;
+
+   if (key >= DIRECT_MAP_MAX_SIZE)
+      return false;
+
+   size = MAX2(_mesa_next_pow_two_32(key + 1), DIRECT_MAP_MIN_SIZE);
+   map = calloc(1, sizeof(*map) + size * sizeof(map->data[0]));
+   if (!map)
+      return false;
+
+   map->size = size;
+   map->prev = old;
+   if (old)
+      memcpy(map->data, old->data, old->size * sizeof(old->data[0]));
+
+   hash_table_foreach(table->ht, entry) {
+      GLuint k = (uintptr_t)entry->key;
+
+      if (k < size) {
+         map->data[k] = entry->data;
+         table->NumDirect++;
+         _mesa_hash_table_remove(table->ht, entry);
+      }
+   }
+
+   if (table->deleted_key_data && DELETED_KEY_VALUE < size) {
+      map->data[DELETED_KEY_VALUE] = table->deleted_key_data;
+      table->NumDirect++;
+      table->deleted_key_data = NULL;
+   }
+
+   /* Publish the map only once it is complete. */
+   p_atomic_set(&table->Direct, map);
+   return true;
+}
+
+
 /**
  * Lookup an entry in the hash table, without locking.
  * \sa _mesa_HashLookup
@@ -175,11 +260,15 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 static inline void *
 _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 {
+   const struct direct_map *direct = p_atomic_read(&table->Direct);
    const struct hash_entry *entry;
 
    assert(table);
    assert(key);
 
+   if (direct && key < direct->size)
+      return p_atomic_read(&direct->data[key]);
+
    if (key == DELETED_KEY_VALUE)
       return table->deleted_key_data;
 
@@ -200,12 +289,21 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
  * \param key the key.
  * 
  * \return pointer to user's data or NULL if key not in table
+ *
+ * Keys covered by the direct map are looked up without taking the mutex,
+ * so contexts sharing objects don't serialize on it when binding them.
  */
 void *
 _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 {
+   const struct direct_map *direct;
    void *res;
    assert(table);
+
+   direct = p_atomic_read(&table->Direct);
+   if (direct && key < direct->size)
+      return p_atomic_read(&direct->data[key]);
+
    mtx_lock(&table->Mutex);
    res = _mesa_HashLookup_unlocked(table, key);
    mtx_unlock(&table->Mutex);
@@ -273,7 +371,13 @@ _mesa_HashInsert_unlocked(struct _mesa_HashTable *table, GLuint key, void *data)
    if (key > table->MaxKey)
       table->MaxKey = key;
 
-   if (key == DELETED_KEY_VALUE) {
+   if (direct_map_reserve(table, key)) {
+      struct direct_map *direct = table->Direct;
+
+      if (!direct->data[key])
+         table->NumDirect++;
+      p_atomic_set(&direct->data[key], data);
+   } else if (key == DELETED_KEY_VALUE) {
       table->deleted_key_data = data;
    } else {
       entry = _mesa_hash_table_search_pre_hashed(table->ht, hash, uint_key(key));
@@ -334,6 +438,7 @@ _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data)
 static inline void
 _mesa_HashRemove_unlocked(struct _mesa_HashTable *table, GLuint key)
 {
+   struct direct_map *direct = table->Direct;
    struct hash_entry *entry;
 
    assert(table);
@@ -346,7 +451,12 @@ _mesa_HashRemove_unlocked(struct _mesa_HashTable *table, GLuint key)
       return;
    }
 
-   if (key == DELETED_KEY_VALUE) {
+   if (direct && key < direct->size) {
+      if (direct->data[key]) {
+         p_atomic_set(&direct->data[key], NULL);
+         table->NumDirect--;
+      }
+   } else if (key == DELETED_KEY_VALUE) {
       table->deleted_key_data = NULL;
    } else {
       entry = _mesa_hash_table_search_pre_hashed(table->ht,
@@ -385,12 +495,24 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
                     void (*callback)(GLuint key, void *data, void *userData),
                     void *userData)
 {
+   struct direct_map *direct;
    struct hash_entry *entry;
+   GLuint key;
 
    assert(table);
    assert(callback);
    mtx_lock(&table->Mutex);
    table->InDeleteAll = GL_TRUE;
+   direct = table->Direct;
+   for (key = 0; direct && key < direct->size; key++) {
+      void *data = direct->data[key];
+
+      if (data) {
+         callback(key, data, userData);
+         p_atomic_set(&direct->data[key], NULL);
+      }
+   }
+   table->NumDirect = 0;
    hash_table_foreach(table->ht, entry) {
       callback((uintptr_t)entry->key, entry->data, userData);
       _mesa_hash_table_remove(table->ht, entry);
@@ -419,10 +541,18 @@ _mesa_HashWalk(const struct _mesa_HashTable *table,
    /* cast-away const */
    struct _mesa_HashTable *table2 = (struct _mesa_HashTable *) table;
    struct hash_entry *entry;
+   GLuint key;
 
    assert(table);
    assert(callback);
    mtx_lock(&table2->Mutex);
+   /* Reread the map every time, the callback may change the table. */
+   for (key = 0; table->Direct && key < table->Direct->size; key++) {
+      void *data = table->Direct->data[key];
+
+      if (data)
+         callback(key, data, userData);
+   }
    hash_table_foreach(table->ht, entry) {
       callback((uintptr_t)entry->key, entry->data, userData);
    }
@@ -508,6 +638,7 @@ _mesa_HashNumEntries(const struct _mesa_HashTable *table)
    if (table->deleted_key_data)
       count++;
 
+   count += table->NumDirect;
    count += _mesa_hash_table_num_entries(table->ht);
 
    return count;
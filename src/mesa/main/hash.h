@@ -34,6 +34,9 @@
 
 #include "glheader.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 extern struct _mesa_HashTable *_mesa_NewHashTable(void);
 
@@ -75,5 +78,8 @@ _mesa_HashNumEntries(const struct _mesa_HashTable *table);
 
 extern void _mesa_test_hash_functions(void);
 
+#ifdef __cplusplus
+}
+#endif
 
 #endif
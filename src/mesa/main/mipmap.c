@@ -40,6 +40,12 @@
 #include "util/half_float.h"
 #include "util/format_rgb9e5.h"
 #include "util/format_r11g11b10f.h"
+#include "util/format_srgb.h"
+#include "parallel_rows.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 
 
@@ -138,6 +144,153 @@ bytes_per_pixel(GLenum datatype, GLuint comps)
 /*@}*/
 
 
+/**
+ * Average together two rows of 8-bit pixels where the components set in
+ * srgbMask are sRGB-encoded.  Those are filtered in linear space so that
+ * the smaller levels don't get darker than the base image.
+ */
+static void
+do_row_srgb(GLuint comps, GLbitfield srgbMask, GLint srcWidth,
+            const GLubyte *rowA, const GLubyte *rowB,
+            GLint dstWidth, GLubyte *dst)
+{
+   const float *linear = util_format_srgb_8unorm_to_linear_float_table;
+   const GLuint k0 = (srcWidth == dstWidth) ? 0 : 1;
+   const GLuint colStride = (srcWidth == dstWidth) ? 1 : 2;
+   GLuint i, j, k, c;
+
+   for (i = j = 0, k = k0; i < (GLuint) dstWidth;
+        i++, j += colStride, k += colStride) {
+      for (c = 0; c < comps; c++) {
+         const GLubyte aj = rowA[j * comps + c], ak = rowA[k * comps + c];
+         const GLubyte bj = rowB[j * comps + c], bk = rowB[k * comps + c];
+
+         if (srgbMask & (1 << c)) {
+            dst[i * comps + c] = util_format_linear_float_to_srgb_8unorm(
+               (linear[aj] + linear[ak] + linear[bj] + linear[bk]) * 0.25F);
+         }
+         else {
+            dst[i * comps + c] = (aj + ak + bj + bk) / 4;
+         }
+      }
+   }
+}
+
+
+#if defined(__SSE2__)
+/**
+ * SSE2 versions of the most common do_row() cases, halving the width of
+ * 8-bit RGBA or R and float RGBA or R images.  The results are the same
+ * as for the C code.
+ *
+ * \return the number of destination pixels done, the caller does the rest
+ */
+static GLint
+do_row_sse2(GLenum datatype, GLuint comps,
+            const GLvoid *srcRowA, const GLvoid *srcRowB,
+            GLint dstWidth, GLvoid *dstRow)
+{
+   GLint i = 0;
+
+   if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
+      const GLubyte *rowA = (const GLubyte *) srcRowA;
+      const GLubyte *rowB = (const GLubyte *) srcRowB;
+      GLubyte *dst = (GLubyte *) dstRow;
+      const __m128i zero = _mm_setzero_si128();
+
+      /* 8 source pixels -> 4 dest pixels, summed as 16-bit values */
+      for (; i + 4 <= dstWidth; i += 4) {
+         __m128i sum[4];
+         int h;
+
+         for (h = 0; h < 2; h++) {
+            const __m128i a =
+               _mm_loadu_si128((const __m128i *) (rowA + i * 8 + h * 16));
+            const __m128i b =
+               _mm_loadu_si128((const __m128i *) (rowB + i * 8 + h * 16));
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                       _mm_unpacklo_epi8(b, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                       _mm_unpackhi_epi8(b, zero));
+
+            /* add the two pixels in each 64-bit half */
+            lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+            sum[h] = _mm_srli_epi16(_mm_unpacklo_epi64(lo, hi), 2);
+         }
+
+         _mm_storeu_si128((__m128i *) (dst + i * 4),
+                          _mm_packus_epi16(sum[0], sum[1]));
+      }
+   }
+   else if (datatype == GL_UNSIGNED_BYTE && comps == 1) {
+      const GLubyte *rowA = (const GLubyte *) srcRowA;
+      const GLubyte *rowB = (const GLubyte *) srcRowB;
+      GLubyte *dst = (GLubyte *) dstRow;
+      const __m128i even = _mm_set1_epi16(0xff);
+
+      /* 32 source pixels -> 16 dest pixels */
+      for (; i + 16 <= dstWidth; i += 16) {
+         __m128i sum[2];
+         int h;
+
+         for (h = 0; h < 2; h++) {
+            const __m128i a =
+               _mm_loadu_si128((const __m128i *) (rowA + i * 2 + h * 16));
+            const __m128i b =
+               _mm_loadu_si128((const __m128i *) (rowB + i * 2 + h * 16));
+            __m128i s = _mm_add_epi16(_mm_and_si128(a, even),
+                                      _mm_srli_epi16(a, 8));
+            s = _mm_add_epi16(s, _mm_and_si128(b, even));
+            s = _mm_add_epi16(s, _mm_srli_epi16(b, 8));
+            sum[h] = _mm_srli_epi16(s, 2);
+         }
+
+         _mm_storeu_si128((__m128i *) (dst + i),
+                          _mm_packus_epi16(sum[0], sum[1]));
+      }
+   }
+   else if (datatype == GL_FLOAT && comps == 4) {
+      const GLfloat *rowA = (const GLfloat *) srcRowA;
+      const GLfloat *rowB = (const GLfloat *) srcRowB;
+      GLfloat *dst = (GLfloat *) dstRow;
+      const __m128 quarter = _mm_set1_ps(0.25F);
+
+      /* same order of additions as the C code */
+      for (; i < dstWidth; i++) {
+         __m128 s = _mm_add_ps(_mm_loadu_ps(rowA + i * 8),
+                               _mm_loadu_ps(rowA + i * 8 + 4));
+         s = _mm_add_ps(s, _mm_loadu_ps(rowB + i * 8));
+         s = _mm_add_ps(s, _mm_loadu_ps(rowB + i * 8 + 4));
+         _mm_storeu_ps(dst + i * 4, _mm_mul_ps(s, quarter));
+      }
+   }
+   else if (datatype == GL_FLOAT && comps == 1) {
+      const GLfloat *rowA = (const GLfloat *) srcRowA;
+      const GLfloat *rowB = (const GLfloat *) srcRowB;
+      GLfloat *dst = (GLfloat *) dstRow;
+      const __m128 quarter = _mm_set1_ps(0.25F);
+
+      for (; i + 4 <= dstWidth; i += 4) {
+         const __m128 a0 = _mm_loadu_ps(rowA + i * 2);
+         const __m128 a1 = _mm_loadu_ps(rowA + i * 2 + 4);
+         const __m128 b0 = _mm_loadu_ps(rowB + i * 2);
+         const __m128 b1 = _mm_loadu_ps(rowB + i * 2 + 4);
+         __m128 s;
+
+         s = _mm_add_ps(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0)),
+                        _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1)));
+         s = _mm_add_ps(s, _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0)));
+         s = _mm_add_ps(s, _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+         _mm_storeu_ps(dst + i, _mm_mul_ps(s, quarter));
+      }
+   }
+
+   return i;
+}
+#endif
+
+
 /**
  * Average together two rows of a source image to produce a single new
  * row in the dest image.  It's legal for the two source rows to point
@@ -145,14 +298,14 @@ bytes_per_pixel(GLenum datatype, GLuint comps)
  * dest width or two times the dest width.
  * \param datatype  GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_FLOAT, etc.
  * \param comps  number of components per pixel (1..4)
+ * \param srgbMask  components that are sRGB-encoded (8-bit formats only)
  */
 static void
-do_row(GLenum datatype, GLuint comps, GLint srcWidth,
+do_row(GLenum datatype, GLuint comps, GLbitfield srgbMask, GLint srcWidth,
        const GLvoid *srcRowA, const GLvoid *srcRowB,
        GLint dstWidth, GLvoid *dstRow)
 {
-   const GLuint k0 = (srcWidth == dstWidth) ? 0 : 1;
-   const GLuint colStride = (srcWidth == dstWidth) ? 1 : 2;
+   GLuint k0, colStride;
 
    assert(comps >= 1);
    assert(comps <= 4);
@@ -161,6 +314,34 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
    assert(srcWidth == dstWidth || srcWidth == 2 * dstWidth);
    */
 
+   if (srgbMask) {
+      assert(datatype == GL_UNSIGNED_BYTE);
+      do_row_srgb(comps, srgbMask, srcWidth,
+                  (const GLubyte *) srcRowA, (const GLubyte *) srcRowB,
+                  dstWidth, (GLubyte *) dstRow);
+      return;
+   }
+
+#if defined(__SSE2__)
+   if (srcWidth != dstWidth) {
+      const GLint done = do_row_sse2(datatype, comps, srcRowA, srcRowB,
+                                     dstWidth, dstRow);
+      if (done) {
+         const GLint bpp = bytes_per_pixel(datatype, comps);
+
+         /* let the code below do the remaining pixels */
+         srcRowA = (const GLubyte *) srcRowA + 2 * done * bpp;
+         srcRowB = (const GLubyte *) srcRowB + 2 * done * bpp;
+         dstRow = (GLubyte *) dstRow + done * bpp;
+         srcWidth -= 2 * done;
+         dstWidth -= done;
+      }
+   }
+#endif
+
+   k0 = (srcWidth == dstWidth) ? 0 : 1;
+   colStride = (srcWidth == dstWidth) ? 1 : 2;
+
    if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
       GLuint i, j, k;
       const GLubyte(*rowA)[4] = (const GLubyte(*)[4]) srcRowA;
@@ -762,6 +943,43 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
 }
 
 
+/**
+ * 3D version of do_row_srgb().
+ */
+static void
+do_row_3D_srgb(GLuint comps, GLbitfield srgbMask, GLint srcWidth,
+               const GLubyte *rowA, const GLubyte *rowB,
+               const GLubyte *rowC, const GLubyte *rowD,
+               GLint dstWidth, GLubyte *dst)
+{
+   const float *linear = util_format_srgb_8unorm_to_linear_float_table;
+   const GLuint k0 = (srcWidth == dstWidth) ? 0 : 1;
+   const GLuint colStride = (srcWidth == dstWidth) ? 1 : 2;
+   GLuint i, j, k, c;
+
+   for (i = j = 0, k = k0; i < (GLuint) dstWidth;
+        i++, j += colStride, k += colStride) {
+      for (c = 0; c < comps; c++) {
+         const GLuint jc = j * comps + c, kc = k * comps + c;
+
+         if (srgbMask & (1 << c)) {
+            dst[i * comps + c] = util_format_linear_float_to_srgb_8unorm(
+               (linear[rowA[jc]] + linear[rowA[kc]] +
+                linear[rowB[jc]] + linear[rowB[kc]] +
+                linear[rowC[jc]] + linear[rowC[kc]] +
+                linear[rowD[jc]] + linear[rowD[kc]]) * 0.125F);
+         }
+         else {
+            dst[i * comps + c] = FILTER_SUM_3D(rowA[jc], rowA[kc],
+                                               rowB[jc], rowB[kc],
+                                               rowC[jc], rowC[kc],
+                                               rowD[jc], rowD[kc]);
+         }
+      }
+   }
+}
+
+
 /**
  * Average together four rows of a source image to produce a single new
  * row in the dest image.  It's legal for the two source rows to point
@@ -771,6 +989,7 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
  * \param datatype  GL pixel type \c GL_UNSIGNED_BYTE, \c GL_UNSIGNED_SHORT,
  *                  \c GL_FLOAT, etc.
  * \param comps     number of components per pixel (1..4)
+ * \param srgbMask  components that are sRGB-encoded (8-bit formats only)
  * \param srcWidth  Width of a row in the source data
  * \param srcRowA   Pointer to one of the rows of source data
  * \param srcRowB   Pointer to one of the rows of source data
@@ -780,7 +999,8 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
  * \param srcRowA   Pointer to the row of destination data
  */
 static void
-do_row_3D(GLenum datatype, GLuint comps, GLint srcWidth,
+do_row_3D(GLenum datatype, GLuint comps, GLbitfield srgbMask,
+          GLint srcWidth,
           const GLvoid *srcRowA, const GLvoid *srcRowB,
           const GLvoid *srcRowC, const GLvoid *srcRowD,
           GLint dstWidth, GLvoid *dstRow)
@@ -792,6 +1012,15 @@ do_row_3D(GLenum datatype, GLuint comps, GLint srcWidth,
    assert(comps >= 1);
    assert(comps <= 4);
 
+   if (srgbMask) {
+      assert(datatype == GL_UNSIGNED_BYTE);
+      do_row_3D_srgb(comps, srgbMask, srcWidth,
+                     (const GLubyte *) srcRowA, (const GLubyte *) srcRowB,
+                     (const GLubyte *) srcRowC, (const GLubyte *) srcRowD,
+                     dstWidth, (GLubyte *) dstRow);
+      return;
+   }
+
    if ((datatype == GL_UNSIGNED_BYTE) && (comps == 4)) {
       DECLARE_ROW_POINTERS(GLubyte, 4);
 
@@ -1413,7 +1642,8 @@ do_row_3D(GLenum datatype, GLuint comps, GLint srcWidth,
  */
 
 static void
-make_1d_mipmap(GLenum datatype, GLuint comps, GLint border,
+make_1d_mipmap(GLenum datatype, GLuint comps, GLbitfield srgbMask,
+               GLint border,
                GLint srcWidth, const GLubyte *srcPtr,
                GLint dstWidth, GLubyte *dstPtr)
 {
@@ -1426,7 +1656,7 @@ make_1d_mipmap(GLenum datatype, GLuint comps, GLint border,
    dst = dstPtr + border * bpt;
 
    /* we just duplicate the input row, kind of hack, saves code */
-   do_row(datatype, comps, srcWidth - 2 * border, src, src,
+   do_row(datatype, comps, srgbMask, srcWidth - 2 * border, src, src,
           dstWidth - 2 * border, dst);
 
    if (border) {
@@ -1442,8 +1672,77 @@ make_1d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+/**
+ * A band of rows of a mipmap level, see _mesa_parallel_rows().
+ */
+struct mipmap_rows_job {
+   GLenum datatype;
+   GLuint comps;
+   GLbitfield srgbMask;
+   GLint srcWidth, dstWidth;          /* without border */
+   GLint dstHeight;                   /* 3D only */
+   const GLubyte *srcA, *srcB;        /* 2D: first pair of source rows */
+   GLint srcRowStride;                /* 2D: between pairs of source rows */
+   GLubyte *dst;                      /* 2D: first dest row */
+   GLint dstRowStride;
+   const GLubyte **srcPtr;            /* 3D: source slices */
+   GLubyte **dstPtr;                  /* 3D: dest slices */
+   GLint border, bpt, srcImageOffset, srcRowOffset;  /* 3D only */
+};
+
+static void
+make_2d_mipmap_rows(void *data, size_t y, size_t height)
+{
+   const struct mipmap_rows_job *job = (const struct mipmap_rows_job *) data;
+   size_t row;
+
+   for (row = y; row < y + height; row++) {
+      do_row(job->datatype, job->comps, job->srgbMask, job->srcWidth,
+             job->srcA + row * job->srcRowStride,
+             job->srcB + row * job->srcRowStride,
+             job->dstWidth, job->dst + row * job->dstRowStride);
+   }
+}
+
+
+/**
+ * Does rows [y, y + height) of the 3D image, counting the rows of all
+ * the dest slices.
+ */
 static void
-make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
+make_3d_mipmap_rows(void *data, size_t y, size_t height)
+{
+   const struct mipmap_rows_job *job = (const struct mipmap_rows_job *) data;
+   const GLint border = job->border, bpt = job->bpt;
+   const GLint srcRowStride = job->srcRowStride;
+   size_t r;
+
+   for (r = y; r < y + height; r++) {
+      const GLint img = r / job->dstHeight;
+      const GLint row = r % job->dstHeight;
+      /* first source image pointer, skipping border */
+      const GLubyte *imgSrcA = job->srcPtr[img * 2 + border]
+         + srcRowStride * border + bpt * border;
+      /* second source image pointer, skipping border */
+      const GLubyte *imgSrcB =
+         job->srcPtr[img * 2 + job->srcImageOffset + border]
+         + srcRowStride * border + bpt * border;
+      /* address of the dest image, skipping border */
+      GLubyte *imgDst = job->dstPtr[img + border]
+         + job->dstRowStride * border + bpt * border;
+      const GLint srcOffset = row * (srcRowStride + job->srcRowOffset);
+
+      do_row_3D(job->datatype, job->comps, job->srgbMask, job->srcWidth,
+                imgSrcA + srcOffset, imgSrcA + srcOffset + job->srcRowOffset,
+                imgSrcB + srcOffset, imgSrcB + srcOffset + job->srcRowOffset,
+                job->dstWidth, imgDst + row * job->dstRowStride);
+   }
+}
+
+
+static void
+make_2d_mipmap(GLenum datatype, GLuint comps, GLbitfield srgbMask,
+               GLint border,
                GLint srcWidth, GLint srcHeight,
 	       const GLubyte *srcPtr, GLint srcRowStride,
                GLint dstWidth, GLint dstHeight,
@@ -1472,12 +1771,16 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
 
    dst = dstPtr + border * ((dstWidth + 1) * bpt);
 
-   for (row = 0; row < dstHeightNB; row++) {
-      do_row(datatype, comps, srcWidthNB, srcA, srcB,
-             dstWidthNB, dst);
-      srcA += srcRowStep * srcRowStride;
-      srcB += srcRowStep * srcRowStride;
-      dst += dstRowStride;
+   {
+      struct mipmap_rows_job job = {
+         .datatype = datatype, .comps = comps, .srgbMask = srgbMask,
+         .srcWidth = srcWidthNB, .dstWidth = dstWidthNB,
+         .srcA = srcA, .srcB = srcB,
+         .srcRowStride = srcRowStep * srcRowStride,
+         .dst = dst, .dstRowStride = dstRowStride,
+      };
+
+      _mesa_parallel_rows(dstWidthNB, dstHeightNB, make_2d_mipmap_rows, &job);
    }
 
    /* This is ugly but probably won't be used much */
@@ -1497,12 +1800,12 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
       memcpy(dstPtr + (dstWidth * dstHeight - 1) * bpt,
              srcPtr + (srcWidth * srcHeight - 1) * bpt, bpt);
       /* lower border */
-      do_row(datatype, comps, srcWidthNB,
+      do_row(datatype, comps, srgbMask, srcWidthNB,
              srcPtr + bpt,
              srcPtr + bpt,
              dstWidthNB, dstPtr + bpt);
       /* upper border */
-      do_row(datatype, comps, srcWidthNB,
+      do_row(datatype, comps, srgbMask, srcWidthNB,
              srcPtr + (srcWidth * (srcHeight - 1) + 1) * bpt,
              srcPtr + (srcWidth * (srcHeight - 1) + 1) * bpt,
              dstWidthNB,
@@ -1520,11 +1823,11 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
       else {
          /* average two src pixels each dest pixel */
          for (row = 0; row < dstHeightNB; row += 2) {
-            do_row(datatype, comps, 1,
+            do_row(datatype, comps, srgbMask, 1,
                    srcPtr + (srcWidth * (row * 2 + 1)) * bpt,
                    srcPtr + (srcWidth * (row * 2 + 2)) * bpt,
                    1, dstPtr + (dstWidth * row + 1) * bpt);
-            do_row(datatype, comps, 1,
+            do_row(datatype, comps, srgbMask, 1,
                    srcPtr + (srcWidth * (row * 2 + 1) + srcWidth - 1) * bpt,
                    srcPtr + (srcWidth * (row * 2 + 2) + srcWidth - 1) * bpt,
                    1, dstPtr + (dstWidth * row + 1 + dstWidth - 1) * bpt);
@@ -1535,7 +1838,8 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
 
 
 static void
-make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
+make_3d_mipmap(GLenum datatype, GLuint comps, GLbitfield srgbMask,
+               GLint border,
                GLint srcWidth, GLint srcHeight, GLint srcDepth,
                const GLubyte **srcPtr, GLint srcRowStride,
                GLint dstWidth, GLint dstHeight, GLint dstDepth,
@@ -1547,7 +1851,7 @@ make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
    const GLint dstWidthNB = dstWidth - 2 * border;
    const GLint dstHeightNB = dstHeight - 2 * border;
    const GLint dstDepthNB = dstDepth - 2 * border;
-   GLint img, row;
+   GLint img;
    GLint bytesPerSrcImage, bytesPerDstImage;
    GLint srcImageOffset, srcRowOffset;
 
@@ -1575,49 +1879,30 @@ make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
           srcWidth, srcHeight, srcDepth, dstWidth, dstHeight, dstDepth);
    */
 
-   for (img = 0; img < dstDepthNB; img++) {
-      /* first source image pointer, skipping border */
-      const GLubyte *imgSrcA = srcPtr[img * 2 + border]
-         + srcRowStride * border + bpt * border;
-      /* second source image pointer, skipping border */
-      const GLubyte *imgSrcB = srcPtr[img * 2 + srcImageOffset + border]
-         + srcRowStride * border + bpt * border;
-
-      /* address of the dest image, skipping border */
-      GLubyte *imgDst = dstPtr[img + border]
-         + dstRowStride * border + bpt * border;
-
-      /* setup the four source row pointers and the dest row pointer */
-      const GLubyte *srcImgARowA = imgSrcA;
-      const GLubyte *srcImgARowB = imgSrcA + srcRowOffset;
-      const GLubyte *srcImgBRowA = imgSrcB;
-      const GLubyte *srcImgBRowB = imgSrcB + srcRowOffset;
-      GLubyte *dstImgRow = imgDst;
-
-      for (row = 0; row < dstHeightNB; row++) {
-         do_row_3D(datatype, comps, srcWidthNB, 
-                   srcImgARowA, srcImgARowB,
-                   srcImgBRowA, srcImgBRowB,
-                   dstWidthNB, dstImgRow);
+   {
+      struct mipmap_rows_job job = {
+         .datatype = datatype, .comps = comps, .srgbMask = srgbMask,
+         .srcWidth = srcWidthNB, .dstWidth = dstWidthNB,
+         .dstHeight = dstHeightNB,
+         .srcRowStride = srcRowStride, .dstRowStride = dstRowStride,
+         .srcPtr = srcPtr, .dstPtr = dstPtr,
+         .border = border, .bpt = bpt,
+         .srcImageOffset = srcImageOffset, .srcRowOffset = srcRowOffset,
+      };
 
-         /* advance to next rows */
-         srcImgARowA += srcRowStride + srcRowOffset;
-         srcImgARowB += srcRowStride + srcRowOffset;
-         srcImgBRowA += srcRowStride + srcRowOffset;
-         srcImgBRowB += srcRowStride + srcRowOffset;
-         dstImgRow += dstRowStride;
-      }
+      _mesa_parallel_rows(dstWidthNB, dstDepthNB * dstHeightNB,
+                          make_3d_mipmap_rows, &job);
    }
 
 
    /* Luckily we can leverage the make_2d_mipmap() function here! */
    if (border > 0) {
       /* do front border image */
-      make_2d_mipmap(datatype, comps, 1,
+      make_2d_mipmap(datatype, comps, srgbMask, 1,
                      srcWidth, srcHeight, srcPtr[0], srcRowStride,
                      dstWidth, dstHeight, dstPtr[0], dstRowStride);
       /* do back border image */
-      make_2d_mipmap(datatype, comps, 1,
+      make_2d_mipmap(datatype, comps, srgbMask, 1,
                      srcWidth, srcHeight, srcPtr[srcDepth - 1], srcRowStride,
                      dstWidth, dstHeight, dstPtr[dstDepth - 1], dstRowStride);
 
@@ -1660,7 +1945,7 @@ make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
             srcA = srcPtr[img * 2 + 0];
             srcB = srcPtr[img * 2 + srcImageOffset];
             dst = dstPtr[img];
-            do_row(datatype, comps, 1, srcA, srcB, 1, dst);
+            do_row(datatype, comps, srgbMask, 1, srcA, srcB, 1, dst);
 
             /* do border along [img][row=dstHeight-1][col=0] */
             srcA = srcPtr[img * 2 + 0]
@@ -1668,19 +1953,19 @@ make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
             srcB = srcPtr[img * 2 + srcImageOffset]
                + (srcHeight - 1) * srcRowStride;
             dst = dstPtr[img] + (dstHeight - 1) * dstRowStride;
-            do_row(datatype, comps, 1, srcA, srcB, 1, dst);
+            do_row(datatype, comps, srgbMask, 1, srcA, srcB, 1, dst);
 
             /* do border along [img][row=0][col=dstWidth-1] */
             srcA = srcPtr[img * 2 + 0] + (srcWidth - 1) * bpt;
             srcB = srcPtr[img * 2 + srcImageOffset] + (srcWidth - 1) * bpt;
             dst = dstPtr[img] + (dstWidth - 1) * bpt;
-            do_row(datatype, comps, 1, srcA, srcB, 1, dst);
+            do_row(datatype, comps, srgbMask, 1, srcA, srcB, 1, dst);
 
             /* do border along [img][row=dstHeight-1][col=dstWidth-1] */
             srcA = srcPtr[img * 2 + 0] + (bytesPerSrcImage - bpt);
             srcB = srcPtr[img * 2 + srcImageOffset] + (bytesPerSrcImage - bpt);
             dst = dstPtr[img] + (bytesPerDstImage - bpt);
-            do_row(datatype, comps, 1, srcA, srcB, 1, dst);
+            do_row(datatype, comps, srgbMask, 1, srcA, srcB, 1, dst);
          }
       }
    }
@@ -1690,6 +1975,7 @@ make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
 /**
  * Down-sample a texture image to produce the next lower mipmap level.
  * \param comps  components per texel (1, 2, 3 or 4)
+ * \param srgbMask  components that are sRGB-encoded, see do_row()
  * \param srcData  array[slice] of pointers to source image slices
  * \param dstData  array[slice] of pointers to dest image slices
  * \param srcRowStride  stride between source rows, in bytes
@@ -1698,7 +1984,7 @@ make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
 void
 _mesa_generate_mipmap_level(GLenum target,
                             GLenum datatype, GLuint comps,
-                            GLint border,
+                            GLbitfield srgbMask, GLint border,
                             GLint srcWidth, GLint srcHeight, GLint srcDepth,
                             const GLubyte **srcData,
                             GLint srcRowStride,
@@ -1710,7 +1996,7 @@ _mesa_generate_mipmap_level(GLenum target,
 
    switch (target) {
    case GL_TEXTURE_1D:
-      make_1d_mipmap(datatype, comps, border,
+      make_1d_mipmap(datatype, comps, srgbMask, border,
                      srcWidth, srcData[0],
                      dstWidth, dstData[0]);
       break;
@@ -1721,12 +2007,12 @@ _mesa_generate_mipmap_level(GLenum target,
    case GL_TEXTURE_CUBE_MAP_NEGATIVE_Y:
    case GL_TEXTURE_CUBE_MAP_POSITIVE_Z:
    case GL_TEXTURE_CUBE_MAP_NEGATIVE_Z:
-      make_2d_mipmap(datatype, comps, border,
+      make_2d_mipmap(datatype, comps, srgbMask, border,
                      srcWidth, srcHeight, srcData[0], srcRowStride,
                      dstWidth, dstHeight, dstData[0], dstRowStride);
       break;
    case GL_TEXTURE_3D:
-      make_3d_mipmap(datatype, comps, border,
+      make_3d_mipmap(datatype, comps, srgbMask, border,
                      srcWidth, srcHeight, srcDepth,
                      srcData, srcRowStride,
                      dstWidth, dstHeight, dstDepth,
@@ -1736,7 +2022,7 @@ _mesa_generate_mipmap_level(GLenum target,
       assert(srcHeight == 1);
       assert(dstHeight == 1);
       for (i = 0; i < dstDepth; i++) {
-	 make_1d_mipmap(datatype, comps, border,
+	 make_1d_mipmap(datatype, comps, srgbMask, border,
 			srcWidth, srcData[i],
 			dstWidth, dstData[i]);
       }
@@ -1744,7 +2030,7 @@ _mesa_generate_mipmap_level(GLenum target,
    case GL_TEXTURE_2D_ARRAY_EXT:
    case GL_TEXTURE_CUBE_MAP_ARRAY:
       for (i = 0; i < dstDepth; i++) {
-	 make_2d_mipmap(datatype, comps, border,
+	 make_2d_mipmap(datatype, comps, srgbMask, border,
 			srcWidth, srcHeight, srcData[i], srcRowStride,
 			dstWidth, dstHeight, dstData[i], dstRowStride);
       }
@@ -1918,6 +2204,35 @@ _mesa_prepare_mipmap_levels(struct gl_context *ctx,
 }
 
 
+/**
+ * Returns the mask of components to filter in linear space for an
+ * uncompressed 8-bit sRGB format, i.e. all but alpha.
+ */
+static GLbitfield
+srgb_component_mask(mesa_format format, GLenum datatype, GLuint comps)
+{
+   const mesa_array_format array_format = _mesa_format_to_array_format(format);
+   GLbitfield mask = (1 << comps) - 1;
+
+   if (_mesa_get_format_color_encoding(format) != GL_SRGB ||
+       datatype != GL_UNSIGNED_BYTE)
+      return 0;
+
+   /* Leave out the alpha channel.  For the RGBX formats, X is filtered like
+    * the color channels, which doesn't matter.
+    */
+   if (array_format) {
+      uint8_t swizzle[4];
+
+      _mesa_array_format_get_swizzle(array_format, swizzle);
+      if (swizzle[3] < comps)
+         mask &= ~(1 << swizzle[3]);
+   }
+
+   return mask;
+}
+
+
 static void
 generate_mipmap_uncompressed(struct gl_context *ctx, GLenum target,
 			     struct gl_texture_object *texObj,
@@ -1927,8 +2242,10 @@ generate_mipmap_uncompressed(struct gl_context *ctx, GLenum target,
    GLuint level;
    GLenum datatype;
    GLuint comps;
+   GLbitfield srgbMask;
 
    _mesa_uncompressed_format_to_type_and_comps(srcImage->TexFormat, &datatype, &comps);
+   srgbMask = srgb_component_mask(srcImage->TexFormat, datatype, comps);
 
    for (level = texObj->BaseLevel; level < maxLevel; level++) {
       /* generate image[level+1] from image[level] */
@@ -2003,7 +2320,8 @@ generate_mipmap_uncompressed(struct gl_context *ctx, GLenum target,
 
       if (success) {
          /* generate one mipmap level (for 1D/2D/3D/array/etc texture) */
-         _mesa_generate_mipmap_level(target, datatype, comps, border,
+         _mesa_generate_mipmap_level(target, datatype, comps, srgbMask,
+                                     border,
                                      srcWidth, srcHeight, srcDepth,
                                      (const GLubyte **) srcMaps, srcRowStride,
                                      dstWidth, dstHeight, dstDepth,
@@ -2051,6 +2369,7 @@ generate_mipmap_compressed(struct gl_context *ctx, GLenum target,
    GLubyte *temp_src = NULL, *temp_dst = NULL;
    GLenum temp_datatype;
    GLenum temp_base_format;
+   GLbitfield srgbMask;
    GLubyte **temp_src_slices = NULL, **temp_dst_slices = NULL;
 
    /* only two types of compressed textures at this time */
@@ -2082,6 +2401,12 @@ generate_mipmap_compressed(struct gl_context *ctx, GLenum target,
 
    temp_base_format = _mesa_get_format_base_format(temp_format);
 
+   /* The sRGB formats are decompressed to RGB(A) without decoding them. */
+   if (_mesa_get_format_color_encoding(srcImage->TexFormat) == GL_SRGB &&
+       temp_datatype == GL_UNSIGNED_BYTE)
+      srgbMask = 0x7;
+   else
+      srgbMask = 0;
 
    /* allocate storage for the temporary, uncompressed image */
    temp_src_row_stride = _mesa_format_row_stride(temp_format, srcImage->Width);
@@ -2167,7 +2492,8 @@ generate_mipmap_compressed(struct gl_context *ctx, GLenum target,
       /* Rescale src image to dest image.
        * This will loop over the slices of a 2D array.
        */
-      _mesa_generate_mipmap_level(target, temp_datatype, components, border,
+      _mesa_generate_mipmap_level(target, temp_datatype, components,
+                                  srgbMask, border,
                                   srcWidth, srcHeight, srcDepth,
                                   (const GLubyte **) temp_src_slices,
                                   temp_src_row_stride,
@@ -28,11 +28,14 @@
 
 #include "mtypes.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 extern void
 _mesa_generate_mipmap_level(GLenum target,
                             GLenum datatype, GLuint comps,
-                            GLint border,
+                            GLbitfield srgbMask, GLint border,
                             GLint srcWidth, GLint srcHeight, GLint srcDepth,
                             const GLubyte **srcData,
                             GLint srcRowStride,
@@ -54,4 +57,8 @@ _mesa_next_mipmap_level_size(GLenum target, GLint border,
                        GLint srcWidth, GLint srcHeight, GLint srcDepth,
                        GLint *dstWidth, GLint *dstHeight, GLint *dstDepth);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* MIPMAP_H */
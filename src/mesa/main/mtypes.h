@@ -47,6 +47,7 @@
 #include "main/formats.h"       /* MESA_FORMAT_COUNT */
 #include "compiler/glsl/list.h"
 #include "util/bitscan.h"
+#include "util/u_queue.h"
 
 
 #ifdef __cplusplus
@@ -1555,6 +1556,18 @@ struct gl_vertex_array_object
    /** Mask of VERT_BIT_* values indicating changed/dirty arrays */
    GLbitfield64 NewArrays;
 
+   /**
+    * Incremented whenever the derived _VertexAttrib[] arrays change, so
+    * that drivers can tell whether state derived from them is stale.
+    */
+   GLuint LayoutStamp;
+
+   /**
+    * Driver-private vertex layout derived from _VertexAttrib[], or NULL.
+    * This must be a single malloc'ed block, it is freed with the VAO.
+    */
+   void *DriverLayout;
+
    /** The index buffer (also known as the element array buffer in OpenGL). */
    struct gl_buffer_object *IndexBufferObj;
 };
@@ -2536,6 +2549,19 @@ struct gl_shader
 
    GLchar *InfoLog;
 
+   /**
+    * Signalled when a background compile started by glCompileShader has
+    * finished.  Anything that reads the compile results has to wait on it.
+    */
+   struct util_queue_fence CompileFence;
+
+   /**
+    * Set while a background compile is queued and cleared once it has run.
+    * Still set after \c CompileFence is signalled if the compile was dropped
+    * because the compiler threads were shut down.
+    */
+   bool CompileQueued;
+
    unsigned Version;       /**< GLSL version used for linking */
 
    struct exec_list *ir;
@@ -2986,6 +3012,7 @@ struct gl_shader_program
 #define GLSL_REPORT_ERRORS 0x40  /**< Print compilation errors */
 #define GLSL_DUMP_ON_ERROR 0x80 /**< Dump shaders to stderr on compile error */
 #define GLSL_CACHE_INFO 0x100 /**< Print debug information about shader cache */
+#define GLSL_MEM_INFO 0x200 /**< Print compile memory high-water marks */
 
 
 /**
@@ -3047,6 +3074,25 @@ struct gl_pipeline_shader_state
    struct _mesa_HashTable *Objects;
 };
 
+/**
+ * Context state for background shader compiles (GL_ARB_parallel_shader_compile).
+ */
+struct gl_shader_compiler_queue
+{
+   struct util_queue Queue;
+   unsigned NumThreads;   /**< Number of threads \c Queue was created with */
+
+   /** Value set by glMaxShaderCompilerThreadsARB, ~0 means no limit */
+   GLuint MaxThreads;
+
+   /** Protects \c NumPending */
+   mtx_t Mutex;
+   /** Signalled when \c NumPending drops to zero */
+   cnd_t Idle;
+   /** Number of compile jobs queued or running */
+   unsigned NumPending;
+};
+
 /**
  * Compiler options for a single GLSL shaders type
  */
@@ -3981,6 +4027,7 @@ struct gl_extensions
    GLboolean ARB_map_buffer_range;
    GLboolean ARB_occlusion_query;
    GLboolean ARB_occlusion_query2;
+   GLboolean ARB_parallel_shader_compile;
    GLboolean ARB_pipeline_statistics_query;
    GLboolean ARB_point_sprite;
    GLboolean ARB_post_depth_coverage;
@@ -4299,6 +4346,14 @@ struct gl_dlist_state
        * list.  Used to eliminate some redundant state changes.
        */
       GLenum ShadeModel;
+      GLfloat LineWidth;
+      GLfloat PointSize;
+      GLenum DepthFunc;
+      GLubyte DepthMask;        /**< 0 = unknown, else mask + 1 */
+      GLenum CullFace;
+      GLenum FrontFace;
+      GLbitfield Enabled;       /**< tracked caps known to be on */
+      GLbitfield Disabled;      /**< tracked caps known to be off */
    } Current;
 };
 
@@ -4685,6 +4740,8 @@ struct gl_context
     */
    struct gl_pipeline_object *_Shader;
 
+   struct gl_shader_compiler_queue ShaderCompiler;
+
    struct gl_query_state Query;  /**< occlusion, timer queries */
 
    struct gl_transform_feedback_state TransformFeedback;
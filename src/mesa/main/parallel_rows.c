@@ -0,0 +1,141 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file parallel_rows.c
+ * Splits the rows of large images over a process-wide pool of threads, for
+ * CPU-side pixel conversions such as texture uploads and glReadPixels.
+ */
+
+#include <stdlib.h>
+
+#include "main/cpuinfo.h"
+#include "main/macros.h"
+#include "main/parallel_rows.h"
+#include "util/u_queue.h"
+
+/** Images smaller than this are processed on the calling thread. */
+#define PARALLEL_ROWS_MIN_PIXELS (512 * 512)
+
+/** Don't split the work into bands smaller than this. */
+#define PARALLEL_ROWS_BAND_PIXELS (128 * 1024)
+
+#define PARALLEL_ROWS_MAX_THREADS 8
+
+struct row_band_job {
+   struct util_queue_fence fence;
+   mesa_row_band_func func;
+   void *data;
+   size_t y, height;
+   bool done;
+};
+
+static struct util_queue row_queue;
+static unsigned row_queue_threads;
+static once_flag row_queue_once = ONCE_FLAG_INIT;
+
+static void
+init_row_queue(void)
+{
+   const char *env = getenv("MESA_PIXEL_THREADS");
+   unsigned num_threads = 0;
+
+   if (env) {
+      num_threads = MIN2(MAX2(atoi(env), 0), PARALLEL_ROWS_MAX_THREADS);
+   } else {
+      /* The calling thread does its share of the work as well. */
+      num_threads = MIN2(_mesa_get_cpu_count() - 1,
+                         PARALLEL_ROWS_MAX_THREADS);
+   }
+
+   if (num_threads &&
+       util_queue_init(&row_queue, "pixels", PARALLEL_ROWS_MAX_THREADS,
+                       num_threads))
+      row_queue_threads = num_threads;
+}
+
+static void
+row_band_job_execute(void *data, int thread_index)
+{
+   struct row_band_job *job = (struct row_band_job *) data;
+
+   job->func(job->data, job->y, job->height);
+   job->done = true;
+}
+
+/**
+ * Calls func for bands of rows covering a width x height image, using the
+ * pixel threads for large images.  Returns when all rows are done.
+ */
+void
+_mesa_parallel_rows(size_t width, size_t height,
+                    mesa_row_band_func func, void *data)
+{
+   struct row_band_job jobs[PARALLEL_ROWS_MAX_THREADS];
+   size_t pixels = width * height;
+   size_t num_bands, band_height, y;
+   unsigned num_jobs = 0, i;
+
+   if (pixels < PARALLEL_ROWS_MIN_PIXELS) {
+      func(data, 0, height);
+      return;
+   }
+
+   call_once(&row_queue_once, init_row_queue);
+
+   num_bands = MIN3(row_queue_threads + 1, height,
+                    pixels / PARALLEL_ROWS_BAND_PIXELS);
+   if (num_bands <= 1) {
+      func(data, 0, height);
+      return;
+   }
+
+   band_height = DIV_ROUND_UP(height, num_bands);
+
+   /* Queue all but the first band, then do that one here. */
+   for (y = band_height; y < height; y += band_height) {
+      struct row_band_job *job = &jobs[num_jobs++];
+
+      job->func = func;
+      job->data = data;
+      job->y = y;
+      job->height = MIN2(band_height, height - y);
+      job->done = false;
+      util_queue_fence_init(&job->fence);
+      util_queue_add_job(&row_queue, job, &job->fence,
+                         row_band_job_execute, NULL);
+   }
+
+   func(data, 0, band_height);
+
+   for (i = 0; i < num_jobs; i++) {
+      util_queue_fence_wait(&jobs[i].fence);
+      util_queue_fence_destroy(&jobs[i].fence);
+
+      /* Once the threads are killed at exit, the queue refuses new jobs
+       * and drops queued ones without running them.
+       */
+      if (!jobs[i].done)
+         row_band_job_execute(&jobs[i], 0);
+   }
+}
@@ -40,6 +40,8 @@
 #include <stdbool.h>
 #include "main/glheader.h"
 #include "main/context.h"
+#include "main/cpuinfo.h"
+#include "main/debug_output.h"
 #include "main/dispatch.h"
 #include "main/enums.h"
 #include "main/hash.h"
@@ -79,6 +81,8 @@ _mesa_get_shader_flags(void)
          flags |= GLSL_LOG;
       if (strstr(env, "cache_info"))
          flags |= GLSL_CACHE_INFO;
+      if (strstr(env, "mem_info"))
+         flags |= GLSL_MEM_INFO;
       if (strstr(env, "nopvert"))
          flags |= GLSL_NOP_VERT;
       if (strstr(env, "nopfrag"))
@@ -140,6 +144,13 @@ _mesa_init_shader_state(struct gl_context *ctx)
    ctx->Shader.RefCount = 1;
    mtx_init(&ctx->Shader.Mutex, mtx_plain);
 
+   /* GL_ARB_parallel_shader_compile: the compiler thread pool is created on
+    * the first glCompileShader call.
+    */
+   ctx->ShaderCompiler.MaxThreads = 0xffffffff;
+   mtx_init(&ctx->ShaderCompiler.Mutex, mtx_plain);
+   cnd_init(&ctx->ShaderCompiler.Idle);
+
    ctx->TessCtrlProgram.patch_vertices = 3;
    for (i = 0; i < 4; ++i)
       ctx->TessCtrlProgram.patch_default_outer_level[i] = 1.0;
@@ -154,6 +165,15 @@ _mesa_init_shader_state(struct gl_context *ctx)
 void
 _mesa_free_shader_state(struct gl_context *ctx)
 {
+   /* Background compiles use the context, so they have to be done before
+    * it goes away.
+    */
+   _mesa_finish_shader_compiles(ctx);
+   if (util_queue_is_initialized(&ctx->ShaderCompiler.Queue))
+      util_queue_destroy(&ctx->ShaderCompiler.Queue);
+   mtx_destroy(&ctx->ShaderCompiler.Mutex);
+   cnd_destroy(&ctx->ShaderCompiler.Idle);
+
    for (int i = 0; i < MESA_SHADER_STAGES; i++) {
       _mesa_reference_program(ctx, &ctx->Shader.CurrentProgram[i], NULL);
    }
@@ -813,6 +833,12 @@ get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
       /* If the program has not been linked, return initial value 0. */
       *params = (shProg->data->LinkStatus == linking_failure) ? 0 : shProg->SeparateShader;
       return;
+   case GL_COMPLETION_STATUS_ARB:
+      if (!ctx->Extensions.ARB_parallel_shader_compile)
+         break;
+      /* glLinkProgram doesn't return before the link is done. */
+      *params = GL_TRUE;
+      return;
 
    /* ARB_tessellation_shader */
    case GL_TESS_CONTROL_OUTPUT_VERTICES:
@@ -878,6 +904,23 @@ get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
 }
 
 
+/**
+ * Wait for a background compile of \p sh and make sure it really ran.
+ * Compiles dropped because the compiler threads were shut down, e.g. by
+ * exit(), are done right here.
+ */
+static void
+wait_for_shader_compile(struct gl_context *ctx, struct gl_shader *sh)
+{
+   _mesa_wait_for_shader_compile(sh);
+
+   if (sh->CompileQueued) {
+      sh->CompileQueued = false;
+      _mesa_compile_shader(ctx, sh);
+   }
+}
+
+
 /**
  * glGetShaderiv() - get GLSL shader state
  */
@@ -894,10 +937,23 @@ get_shaderiv(struct gl_context *ctx, GLuint name, GLenum pname, GLint *params)
    switch (pname) {
    case GL_SHADER_TYPE:
       *params = shader->Type;
-      break;
+      return;
    case GL_DELETE_STATUS:
       *params = shader->DeletePending;
+      return;
+   case GL_COMPLETION_STATUS_ARB:
+      if (!ctx->Extensions.ARB_parallel_shader_compile)
+         break;
+      *params = util_queue_fence_is_signalled(&shader->CompileFence);
+      return;
+   default:
       break;
+   }
+
+   /* Everything else may be written by a background compile. */
+   wait_for_shader_compile(ctx, shader);
+
+   switch (pname) {
    case GL_COMPILE_STATUS:
       *params = shader->CompileStatus ? GL_TRUE : GL_FALSE;
       break;
@@ -964,6 +1020,8 @@ get_shader_info_log(struct gl_context *ctx, GLuint shader, GLsizei bufSize,
       return;
    }
 
+   wait_for_shader_compile(ctx, sh);
+
    _mesa_copy_string(infoLog, bufSize, length, sh->InfoLog);
 }
 
@@ -986,6 +1044,8 @@ get_shader_source(struct gl_context *ctx, GLuint shader, GLsizei maxLength,
    if (!sh) {
       return;
    }
+
+   _mesa_wait_for_shader_compile(sh);
    _mesa_copy_string(sourceOut, maxLength, length, sh->Source);
 }
 
@@ -995,10 +1055,14 @@ get_shader_source(struct gl_context *ctx, GLuint shader, GLsizei maxLength,
  * glShaderSource[ARB].
  */
 static void
-shader_source(struct gl_shader *sh, const GLchar *source)
+shader_source(struct gl_context *ctx, struct gl_shader *sh,
+              const GLchar *source)
 {
    assert(sh);
 
+   /* A background compile may still be reading the old source. */
+   wait_for_shader_compile(ctx, sh);
+
    if (sh->CompileStatus == compile_skipped && !sh->FallbackSource) {
       /* If shader was previously compiled back-up the source in case of cache
        * fallback.
@@ -1018,10 +1082,12 @@ shader_source(struct gl_shader *sh, const GLchar *source)
 
 
 /**
- * Compile a shader.
+ * Compile a shader.  \p flags are the GLSL_x debug flags of the pipeline
+ * that was bound when the compile was requested.
  */
-void
-_mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
+static void
+compile_shader(struct gl_context *ctx, struct gl_shader *sh,
+               GLbitfield flags)
 {
    if (!sh)
       return;
@@ -1032,7 +1098,7 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
        */
       sh->CompileStatus = compile_failure;
    } else {
-      if (ctx->_Shader->Flags & GLSL_DUMP) {
+      if (flags & GLSL_DUMP) {
          _mesa_log("GLSL source for %s shader %d:\n",
                  _mesa_shader_stage_to_string(sh->Stage), sh->Name);
          _mesa_log("%s\n", sh->Source);
@@ -1043,11 +1109,11 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
        */
       _mesa_glsl_compile_shader(ctx, sh, false, false, false);
 
-      if (ctx->_Shader->Flags & GLSL_LOG) {
+      if (flags & GLSL_LOG) {
          _mesa_write_shader_to_file(sh);
       }
 
-      if (ctx->_Shader->Flags & GLSL_DUMP) {
+      if (flags & GLSL_DUMP) {
          if (sh->CompileStatus) {
             if (sh->ir) {
                _mesa_log("GLSL IR for shader %d:\n", sh->Name);
@@ -1068,14 +1134,14 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
    }
 
    if (!sh->CompileStatus) {
-      if (ctx->_Shader->Flags & GLSL_DUMP_ON_ERROR) {
+      if (flags & GLSL_DUMP_ON_ERROR) {
          _mesa_log("GLSL source for %s shader %d:\n",
                  _mesa_shader_stage_to_string(sh->Stage), sh->Name);
          _mesa_log("%s\n", sh->Source);
          _mesa_log("Info Log:\n%s\n", sh->InfoLog);
       }
 
-      if (ctx->_Shader->Flags & GLSL_REPORT_ERRORS) {
+      if (flags & GLSL_REPORT_ERRORS) {
          _mesa_debug(ctx, "Error compiling shader %u:\n%s\n",
                      sh->Name, sh->InfoLog);
       }
@@ -1083,6 +1149,196 @@ _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
 }
 
 
+/**
+ * Compile a shader.
+ */
+void
+_mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
+{
+   compile_shader(ctx, sh, ctx->_Shader->Flags);
+}
+
+
+
+/**
+ * Number of compiler threads used when the application doesn't limit it
+ * with glMaxShaderCompilerThreadsARB.
+ */
+static unsigned
+get_max_shader_compiler_threads(void)
+{
+   static int max_threads = -1;
+
+   if (max_threads < 0) {
+      const char *env = getenv("MESA_SHADER_COMPILER_THREADS");
+
+      if (env) {
+         max_threads = MAX2(atoi(env), 0);
+      } else {
+         max_threads = MIN2(_mesa_get_cpu_count(), 16);
+      }
+   }
+
+   return max_threads;
+}
+
+
+/**
+ * Make sure the compiler thread pool matches the thread count currently
+ * asked for.  Returns false if shaders should be compiled synchronously.
+ */
+static bool
+init_shader_compiler_queue(struct gl_context *ctx)
+{
+   struct gl_shader_compiler_queue *q = &ctx->ShaderCompiler;
+   const unsigned num_threads =
+      MIN2(q->MaxThreads, get_max_shader_compiler_threads());
+
+   if (util_queue_is_initialized(&q->Queue)) {
+      if (q->NumThreads == num_threads)
+         return true;
+
+      _mesa_finish_shader_compiles(ctx);
+      util_queue_destroy(&q->Queue);
+      memset(&q->Queue, 0, sizeof(q->Queue));
+   }
+
+   if (num_threads == 0)
+      return false;
+
+   /* Once the queue is full glCompileShader blocks until a slot frees up,
+    * which bounds the memory held by pending compiles.
+    */
+   if (!util_queue_init(&q->Queue, "glsl", 64, num_threads)) {
+      memset(&q->Queue, 0, sizeof(q->Queue));
+      return false;
+   }
+
+   q->NumThreads = num_threads;
+   return true;
+}
+
+
+struct compile_shader_job {
+   struct gl_context *ctx;
+   struct gl_shader *sh;
+
+   /* Snapshot of ctx->_Shader->Flags.  The application may rebind or delete
+    * the pipeline while the compile is running.
+    */
+   GLbitfield flags;
+};
+
+
+/**
+ * Runs on a compiler thread.  Besides the shader itself this only looks at
+ * context state that is fixed at context creation (constants, extensions,
+ * API, the disk cache) and at ctx->Debug, which has its own lock.
+ */
+static void
+compile_shader_job_execute(void *data, int thread_index)
+{
+   struct compile_shader_job *job = (struct compile_shader_job *) data;
+
+   compile_shader(job->ctx, job->sh, job->flags);
+   job->sh->CompileQueued = false;
+}
+
+
+static void
+compile_shader_job_cleanup(void *data, int thread_index)
+{
+   struct compile_shader_job *job = (struct compile_shader_job *) data;
+   struct gl_shader_compiler_queue *q = &job->ctx->ShaderCompiler;
+
+   free(job);
+
+   mtx_lock(&q->Mutex);
+   if (--q->NumPending == 0)
+      cnd_broadcast(&q->Idle);
+   mtx_unlock(&q->Mutex);
+}
+
+
+/**
+ * Whether GL_DEBUG_OUTPUT_SYNCHRONOUS is in effect.  Compiler messages
+ * then have to be delivered on the application's thread, from within
+ * glCompileShader.
+ */
+static bool
+debug_output_is_synchronous(struct gl_context *ctx)
+{
+   return _mesa_get_debug_state_int(ctx, GL_DEBUG_OUTPUT) &&
+          _mesa_get_debug_state_int(ctx, GL_DEBUG_OUTPUT_SYNCHRONOUS);
+}
+
+
+/**
+ * Compile a shader on the context's compiler threads.  Falls back to
+ * compiling it right away if background compiles are disabled or can't
+ * be done.
+ */
+static void
+compile_shader_async(struct gl_context *ctx, struct gl_shader *sh)
+{
+   struct gl_shader_compiler_queue *q = &ctx->ShaderCompiler;
+   struct compile_shader_job *job;
+
+   if (!sh)
+      return;
+
+   /* Only one compile of a shader may be in flight at a time.  A compile
+    * that was dropped at shutdown is superseded by this one.
+    */
+   _mesa_wait_for_shader_compile(sh);
+   sh->CompileQueued = false;
+
+   if (!sh->Source || debug_output_is_synchronous(ctx) ||
+       !init_shader_compiler_queue(ctx)) {
+      _mesa_compile_shader(ctx, sh);
+      return;
+   }
+
+   job = malloc(sizeof(*job));
+   if (!job) {
+      _mesa_compile_shader(ctx, sh);
+      return;
+   }
+
+   job->ctx = ctx;
+   job->sh = sh;
+   job->flags = ctx->_Shader->Flags;
+
+   mtx_lock(&q->Mutex);
+   q->NumPending++;
+   mtx_unlock(&q->Mutex);
+
+   sh->CompileQueued = true;
+   if (!util_queue_add_job(&q->Queue, job, &sh->CompileFence,
+                           compile_shader_job_execute,
+                           compile_shader_job_cleanup)) {
+      /* The compiler threads have been shut down by exit(). */
+      compile_shader_job_execute(job, 0);
+      compile_shader_job_cleanup(job, 0);
+   }
+}
+
+
+/**
+ * Wait for all background compiles queued by this context to finish.
+ */
+void
+_mesa_finish_shader_compiles(struct gl_context *ctx)
+{
+   struct gl_shader_compiler_queue *q = &ctx->ShaderCompiler;
+
+   mtx_lock(&q->Mutex);
+   while (q->NumPending)
+      cnd_wait(&q->Idle, &q->Mutex);
+   mtx_unlock(&q->Mutex);
+}
+
+
 /**
  * Link a program's shaders.
  */
@@ -1092,6 +1348,12 @@ _mesa_link_program(struct gl_context *ctx, struct gl_shader_program *shProg)
    if (!shProg)
       return;
 
+   /* Linking itself stays synchronous, but it has to see the results of
+    * any background compiles of the attached shaders.
+    */
+   for (unsigned i = 0; i < shProg->NumShaders; i++)
+      wait_for_shader_compile(ctx, shProg->Shaders[i]);
+
    /* From the ARB_transform_feedback2 specification:
     * "The error INVALID_OPERATION is generated by LinkProgram if <program> is
     *  the name of a program being used by one or more transform feedback
@@ -1398,11 +1660,23 @@ _mesa_CompileShader(GLuint shaderObj)
    GET_CURRENT_CONTEXT(ctx);
    if (MESA_VERBOSE & VERBOSE_API)
       _mesa_debug(ctx, "glCompileShader %u\n", shaderObj);
-   _mesa_compile_shader(ctx, _mesa_lookup_shader_err(ctx, shaderObj,
+   compile_shader_async(ctx, _mesa_lookup_shader_err(ctx, shaderObj,
                                                      "glCompileShader"));
 }
 
 
+void GLAPIENTRY
+_mesa_MaxShaderCompilerThreadsARB(GLuint count)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   if (MESA_VERBOSE & VERBOSE_API)
+      _mesa_debug(ctx, "glMaxShaderCompilerThreadsARB %u\n", count);
+
+   /* The thread pool is resized on the next glCompileShader. */
+   ctx->ShaderCompiler.MaxThreads = count;
+}
+
+
 GLuint GLAPIENTRY
 _mesa_CreateShader(GLenum type)
 {
@@ -1849,7 +2123,7 @@ _mesa_ShaderSource(GLuint shaderObj, GLsizei count,
    }
 #endif /* ENABLE_SHADER_CACHE */
 
-   shader_source(sh, source);
+   shader_source(ctx, sh, source);
 
    free(offsets);
 }
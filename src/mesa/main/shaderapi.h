@@ -61,6 +61,9 @@ _mesa_active_program(struct gl_context *ctx, struct gl_shader_program *shProg,
 extern void
 _mesa_compile_shader(struct gl_context *ctx, struct gl_shader *sh);
 
+extern void
+_mesa_finish_shader_compiles(struct gl_context *ctx);
+
 extern void
 _mesa_link_program(struct gl_context *ctx, struct gl_shader_program *sh_prog);
 
@@ -79,6 +82,9 @@ _mesa_AttachObjectARB(GLhandleARB, GLhandleARB);
 extern void  GLAPIENTRY
 _mesa_CompileShader(GLuint);
 
+extern void GLAPIENTRY
+_mesa_MaxShaderCompilerThreadsARB(GLuint count);
+
 extern GLhandleARB GLAPIENTRY
 _mesa_CreateProgramObjectARB(void);
 
@@ -93,6 +93,7 @@ _mesa_init_shader(struct gl_shader *shader)
    shader->info.Geom.VerticesOut = -1;
    shader->info.Geom.InputType = GL_TRIANGLES;
    shader->info.Geom.OutputType = GL_TRIANGLE_STRIP;
+   util_queue_fence_init(&shader->CompileFence);
 }
 
 /**
@@ -121,6 +122,12 @@ _mesa_new_shader(GLuint name, gl_shader_stage stage)
 void
 _mesa_delete_shader(struct gl_context *ctx, struct gl_shader *sh)
 {
+   /* The shader may be deleted from a context sharing it while a compile
+    * is still running in the background.
+    */
+   _mesa_wait_for_shader_compile(sh);
+   util_queue_fence_destroy(&sh->CompileFence);
+
    free((void *)sh->Source);
    free((void *)sh->FallbackSource);
    free(sh->Label);
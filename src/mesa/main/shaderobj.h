@@ -83,6 +83,16 @@ _mesa_reference_shader_program(struct gl_context *ctx,
 extern struct gl_shader *
 _mesa_new_shader(GLuint name, gl_shader_stage type);
 
+/**
+ * Wait for a background compile started by glCompileShader to finish.
+ * Must be called before looking at anything the compile produces.
+ */
+static inline void
+_mesa_wait_for_shader_compile(struct gl_shader *sh)
+{
+   util_queue_fence_wait(&sh->CompileFence);
+}
+
 extern void
 _mesa_delete_shader(struct gl_context *ctx, struct gl_shader *sh);
 
@@ -0,0 +1,218 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * SSE4.1 versions of the most common _mesa_swizzle_and_convert() cases:
+ * swizzling 8-bit RGB(A) data, e.g. RGBA <-> BGRA and RGB -> RGBA, and
+ * converting between normalized 8-bit and float RGBA.
+ *
+ * Four pixels are handled at a time.  The swizzle, including the zero and
+ * one channels, is done with a single pshufb on the 8-bit values.  The
+ * results are bit-identical to the generic code.
+ */
+
+#include <smmintrin.h>
+#include <string.h>
+
+#include "main/sse_format_convert.h"
+
+enum sse_convert_op {
+   UBYTE_TO_UBYTE,
+   UBYTE_TO_FLOAT,
+   FLOAT_TO_UBYTE,
+};
+
+/**
+ * Builds the pshufb control mask that applies swizzle to four pixels of
+ * num_src_channels 8-bit channels, and the value to OR in for the one
+ * channels.
+ */
+static bool
+build_swizzle(const uint8_t swizzle[4], int num_src_channels, uint8_t one,
+              __m128i *shuffle, __m128i *ones)
+{
+   uint8_t shuffle_bytes[16], one_bytes[16];
+
+   for (int p = 0; p < 4; p++) {
+      for (int c = 0; c < 4; c++) {
+         const int i = p * 4 + c;
+
+         if (swizzle[c] < num_src_channels) {
+            shuffle_bytes[i] = p * num_src_channels + swizzle[c];
+            one_bytes[i] = 0;
+         } else if (swizzle[c] == MESA_FORMAT_SWIZZLE_ZERO) {
+            shuffle_bytes[i] = 0x80;
+            one_bytes[i] = 0;
+         } else if (swizzle[c] == MESA_FORMAT_SWIZZLE_ONE) {
+            shuffle_bytes[i] = 0x80;
+            one_bytes[i] = one;
+         } else {
+            return false;
+         }
+      }
+   }
+
+   *shuffle = _mm_loadu_si128((const __m128i *) shuffle_bytes);
+   *ones = _mm_loadu_si128((const __m128i *) one_bytes);
+   return true;
+}
+
+static inline void
+store_ubyte4_as_float(float *dst, __m128i v, __m128 scale)
+{
+   _mm_storeu_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(v)),
+                                 scale));
+}
+
+/* Matches _mesa_float_to_unorm(x, 8): maxps returns its second operand
+ * for NaN, so NaN ends up as 0 like in the C version.
+ */
+static inline __m128i
+float_to_unorm8(const float *src)
+{
+   __m128 v = _mm_loadu_ps(src);
+
+   v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+   return _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(255.0f)));
+}
+
+static inline void
+convert4(enum sse_convert_op op, void *dst, const void *src,
+         __m128i shuffle, __m128i ones, bool normalized)
+{
+   __m128i v;
+
+   switch (op) {
+   case UBYTE_TO_UBYTE:
+      v = _mm_loadu_si128((const __m128i *) src);
+      v = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), ones);
+      _mm_storeu_si128((__m128i *) dst, v);
+      break;
+
+   case UBYTE_TO_FLOAT: {
+      const __m128 scale = _mm_set1_ps(normalized ? 1.0f / 255.0f : 1.0f);
+      float *d = dst;
+
+      v = _mm_loadu_si128((const __m128i *) src);
+      v = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), ones);
+      store_ubyte4_as_float(d + 0, v, scale);
+      store_ubyte4_as_float(d + 4, _mm_srli_si128(v, 4), scale);
+      store_ubyte4_as_float(d + 8, _mm_srli_si128(v, 8), scale);
+      store_ubyte4_as_float(d + 12, _mm_srli_si128(v, 12), scale);
+      break;
+   }
+
+   case FLOAT_TO_UBYTE: {
+      const float *s = src;
+      const __m128i lo = _mm_packus_epi32(float_to_unorm8(s + 0),
+                                          float_to_unorm8(s + 4));
+      const __m128i hi = _mm_packus_epi32(float_to_unorm8(s + 8),
+                                          float_to_unorm8(s + 12));
+
+      v = _mm_packus_epi16(lo, hi);
+      v = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), ones);
+      _mm_storeu_si128((__m128i *) dst, v);
+      break;
+   }
+   }
+}
+
+/**
+ * Handles the subset of _mesa_swizzle_and_convert() described above.
+ *
+ * \return false if the conversion isn't supported, in which case nothing
+ *         has been written.
+ */
+bool
+_mesa_swizzle_and_convert_sse41(void *void_dst,
+                                enum mesa_array_format_datatype dst_type,
+                                int num_dst_channels,
+                                const void *void_src,
+                                enum mesa_array_format_datatype src_type,
+                                int num_src_channels,
+                                const uint8_t swizzle[4], bool normalized,
+                                int count)
+{
+   enum sse_convert_op op;
+   __m128i shuffle, ones;
+   uint8_t *dst = void_dst;
+   const uint8_t *src = void_src;
+   int src_size, dst_size, extra, i;
+
+   if (num_dst_channels != 4)
+      return false;
+
+   if (src_type == MESA_ARRAY_FORMAT_TYPE_UBYTE &&
+       dst_type == MESA_ARRAY_FORMAT_TYPE_UBYTE) {
+      op = UBYTE_TO_UBYTE;
+   } else if (src_type == MESA_ARRAY_FORMAT_TYPE_UBYTE &&
+              dst_type == MESA_ARRAY_FORMAT_TYPE_FLOAT) {
+      op = UBYTE_TO_FLOAT;
+   } else if (src_type == MESA_ARRAY_FORMAT_TYPE_FLOAT &&
+              dst_type == MESA_ARRAY_FORMAT_TYPE_UBYTE && normalized &&
+              num_src_channels == 4) {
+      op = FLOAT_TO_UBYTE;
+   } else {
+      return false;
+   }
+
+   if (num_src_channels != 3 && num_src_channels != 4)
+      return false;
+
+   /* For the float conversions, "one" is converted along with the rest. */
+   if (!build_swizzle(swizzle, num_src_channels, normalized ? 0xff : 1,
+                      &shuffle, &ones))
+      return false;
+
+   src_size = _mesa_array_format_datatype_get_size(src_type) *
+              num_src_channels;
+   dst_size = _mesa_array_format_datatype_get_size(dst_type) * 4;
+
+   /* Four 3-byte pixels are read with a 16-byte load, which needs two more
+    * pixels after them to stay within the source.
+    */
+   extra = num_src_channels == 3 ? 2 : 0;
+
+   for (i = 0; i + 4 + extra <= count; i += 4) {
+      convert4(op, dst + i * dst_size, src + i * src_size,
+               shuffle, ones, normalized);
+   }
+
+   /* Do the remaining pixels through a temporary. */
+   if (i < count) {
+      uint8_t tmp_src[64], tmp_dst[64];
+
+      memset(tmp_src, 0, sizeof(tmp_src));
+
+      while (i < count) {
+         const int n = count - i < 4 ? count - i : 4;
+
+         memcpy(tmp_src, src + i * src_size, n * src_size);
+         convert4(op, tmp_dst, tmp_src, shuffle, ones, normalized);
+         memcpy(dst + i * dst_size, tmp_dst, n * dst_size);
+         i += n;
+      }
+   }
+
+   return true;
+}
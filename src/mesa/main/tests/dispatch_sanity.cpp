@@ -965,6 +965,9 @@ const struct function common_desktop_functions_possible[] = {
    { "glBufferPageCommitmentARB", 43, -1 },
    { "glNamedBufferPageCommitmentARB", 43, -1 },
 
+   /* GL_ARB_parallel_shader_compile */
+   { "glMaxShaderCompilerThreadsARB", 20, -1 },
+
    { NULL, 0, -1 }
 };
 
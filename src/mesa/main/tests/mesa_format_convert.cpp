@@ -0,0 +1,222 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "main/cpuinfo.h"
+#include "main/format_utils.h"
+#include "main/formats.h"
+#include "util/macros.h"
+
+/* The conversions below have SIMD versions when the CPU supports them.
+ * Check them against the per-channel helpers for all the pixel counts
+ * needed to cover the vector loop and the tail handling.
+ */
+
+#define MAX_PIXELS 37
+
+static const uint8_t swizzles[][4] = {
+   { 0, 1, 2, 3 },
+   { 2, 1, 0, 3 },
+   { 3, 2, 1, 0 },
+   { 0, 1, 2, MESA_FORMAT_SWIZZLE_ONE },
+   { 2, 1, 0, MESA_FORMAT_SWIZZLE_ONE },
+   { 0, 0, 0, MESA_FORMAT_SWIZZLE_ONE },
+   { MESA_FORMAT_SWIZZLE_ZERO, MESA_FORMAT_SWIZZLE_ZERO,
+     MESA_FORMAT_SWIZZLE_ZERO, 1 },
+};
+
+class MesaFormatConvertTest : public ::testing::Test {
+public:
+   virtual void SetUp();
+};
+
+void
+MesaFormatConvertTest::SetUp()
+{
+   _mesa_get_cpu_features();
+}
+
+static bool
+swizzle_is_valid(const uint8_t swizzle[4], int num_src_channels)
+{
+   for (int c = 0; c < 4; c++) {
+      if (swizzle[c] < 4 && swizzle[c] >= num_src_channels)
+         return false;
+   }
+   return true;
+}
+
+TEST_F(MesaFormatConvertTest, UbyteToUbyte)
+{
+   uint8_t src[MAX_PIXELS * 4], dst[MAX_PIXELS * 4 + 4];
+
+   for (unsigned i = 0; i < ARRAY_SIZE(src); i++)
+      src[i] = i * 37 + 11;
+
+   for (int num_src = 3; num_src <= 4; num_src++) {
+      for (unsigned s = 0; s < ARRAY_SIZE(swizzles); s++) {
+         if (!swizzle_is_valid(swizzles[s], num_src))
+            continue;
+
+         for (int normalized = 0; normalized <= 1; normalized++) {
+            for (int count = 0; count <= MAX_PIXELS; count++) {
+               memset(dst, 0xcd, sizeof(dst));
+               _mesa_swizzle_and_convert(dst, MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                                         src, MESA_ARRAY_FORMAT_TYPE_UBYTE,
+                                         num_src, swizzles[s], normalized,
+                                         count);
+
+               for (int i = 0; i < count * 4; i++) {
+                  const uint8_t sw = swizzles[s][i % 4];
+                  const uint8_t expected =
+                     sw < 4 ? src[i / 4 * num_src + sw] :
+                     sw == MESA_FORMAT_SWIZZLE_ZERO ? 0 :
+                     normalized ? 0xff : 1;
+                  ASSERT_EQ(expected, dst[i]);
+               }
+               ASSERT_EQ(0xcd, dst[count * 4]);
+            }
+         }
+      }
+   }
+}
+
+TEST_F(MesaFormatConvertTest, UbyteToFloat)
+{
+   uint8_t src[MAX_PIXELS * 4];
+   float dst[MAX_PIXELS * 4];
+
+   for (unsigned i = 0; i < ARRAY_SIZE(src); i++)
+      src[i] = i * 37 + 11;
+
+   for (int num_src = 3; num_src <= 4; num_src++) {
+      for (unsigned s = 0; s < ARRAY_SIZE(swizzles); s++) {
+         if (!swizzle_is_valid(swizzles[s], num_src))
+            continue;
+
+         for (int normalized = 0; normalized <= 1; normalized++) {
+            for (int count = 0; count <= MAX_PIXELS; count++) {
+               _mesa_swizzle_and_convert(dst, MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
+                                         src, MESA_ARRAY_FORMAT_TYPE_UBYTE,
+                                         num_src, swizzles[s], normalized,
+                                         count);
+
+               for (int i = 0; i < count * 4; i++) {
+                  const uint8_t sw = swizzles[s][i % 4];
+                  float expected;
+
+                  if (sw == MESA_FORMAT_SWIZZLE_ZERO)
+                     expected = 0.0f;
+                  else if (sw == MESA_FORMAT_SWIZZLE_ONE)
+                     expected = 1.0f;
+                  else if (normalized)
+                     expected = _mesa_unorm_to_float(src[i / 4 * num_src + sw],
+                                                     8);
+                  else
+                     expected = src[i / 4 * num_src + sw];
+
+                  ASSERT_EQ(expected, dst[i]);
+               }
+            }
+         }
+      }
+   }
+}
+
+TEST_F(MesaFormatConvertTest, FloatToUbyte)
+{
+   float src[MAX_PIXELS * 4];
+   uint8_t dst[MAX_PIXELS * 4 + 4];
+
+   for (unsigned i = 0; i < ARRAY_SIZE(src); i++)
+      src[i] = (float) ((i * 389) % 1500) / 1000.0f - 0.25f;
+
+   /* Values needing the clamping and round-to-even behavior. */
+   src[1] = NAN;
+   src[2] = -0.0f;
+   src[5] = 0.5f / 255.0f;
+   src[6] = 1.5f / 255.0f;
+   src[9] = INFINITY;
+   src[10] = -INFINITY;
+
+   for (unsigned s = 0; s < ARRAY_SIZE(swizzles); s++) {
+      for (int count = 0; count <= MAX_PIXELS; count++) {
+         memset(dst, 0xcd, sizeof(dst));
+         _mesa_swizzle_and_convert(dst, MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                                   src, MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
+                                   swizzles[s], true, count);
+
+         for (int i = 0; i < count * 4; i++) {
+            const uint8_t sw = swizzles[s][i % 4];
+            const uint8_t expected =
+               sw < 4 ? _mesa_float_to_unorm(src[i / 4 * 4 + sw], 8) :
+               sw == MESA_FORMAT_SWIZZLE_ZERO ? 0 : 0xff;
+            ASSERT_EQ(expected, dst[i]);
+         }
+         ASSERT_EQ(0xcd, dst[count * 4]);
+      }
+   }
+}
+
+/* Images above 512x512 pixels are split into bands of rows that are
+ * converted on the pixel threads.  Check that the result matches converting
+ * the image one row at a time, which is always done on the calling thread.
+ */
+TEST_F(MesaFormatConvertTest, ParallelRows)
+{
+   const size_t width = 1024, height = 1021;
+   const size_t src_stride = width * 4 + 12;
+   const size_t dst_stride = width * 4 * sizeof(float);
+   const uint32_t src_format = MESA_ARRAY_FORMAT(1, 0, 0, 1, 4, 2, 1, 0, 3);
+   const uint32_t dst_format = MESA_ARRAY_FORMAT(4, 1, 1, 1, 4, 0, 1, 2, 3);
+   std::vector<uint8_t> src(src_stride * height);
+   /* Different fill values, so rows that are skipped don't compare equal. */
+   std::vector<float> dst(width * 4 * height, -1.0f);
+   std::vector<float> ref(width * 4 * height, -2.0f);
+
+#ifndef _WIN32
+   /* Make sure the image really is split, even on a single CPU. */
+   setenv("MESA_PIXEL_THREADS", "3", 0);
+#endif
+
+   for (size_t i = 0; i < src.size(); i++)
+      src[i] = (i * 31) ^ (i >> 9);
+
+   _mesa_format_convert(dst.data(), dst_format, dst_stride,
+                        src.data(), src_format, src_stride,
+                        width, height, NULL);
+
+   for (size_t y = 0; y < height; y++) {
+      _mesa_format_convert(&ref[y * width * 4], dst_format, dst_stride,
+                           &src[y * src_stride], src_format, src_stride,
+                           width, 1, NULL);
+   }
+
+   ASSERT_EQ(0, memcmp(ref.data(), dst.data(), dst.size() * sizeof(float)));
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+#include "main/hash.h"
+#include "util/macros.h"
+
+static void *
+value(GLuint key)
+{
+   return (void *)(uintptr_t)(key * 2 + 1);
+}
+
+static void
+count_entry(GLuint key, void *data, void *userData)
+{
+   EXPECT_EQ(value(key), data);
+   (*(unsigned *)userData)++;
+}
+
+class MesaHashTest : public ::testing::Test {
+public:
+   virtual void SetUp();
+   virtual void TearDown();
+
+   struct _mesa_HashTable *table;
+};
+
+void
+MesaHashTest::SetUp()
+{
+   table = _mesa_NewHashTable();
+   ASSERT_NE((void *)NULL, table);
+}
+
+void
+MesaHashTest::TearDown()
+{
+   unsigned count = 0;
+
+   _mesa_HashDeleteAll(table, count_entry, &count);
+   EXPECT_EQ(0u, _mesa_HashNumEntries(table));
+   _mesa_DeleteHashTable(table);
+}
+
+/* Genned names end up in the direct map, big ones in the hash table. */
+static const GLuint keys[] = {
+   1, 2, 3, 255, 256, 257, 1000, 4095, 65535, 65536, 65537, 100000,
+   0x7fffffff, 0xfffffffe,
+};
+
+TEST_F(MesaHashTest, InsertLookupRemove)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(keys); i++) {
+      EXPECT_EQ(NULL, _mesa_HashLookup(table, keys[i]));
+      _mesa_HashInsert(table, keys[i], value(keys[i]));
+   }
+
+   EXPECT_EQ(ARRAY_SIZE(keys), _mesa_HashNumEntries(table));
+
+   for (unsigned i = 0; i < ARRAY_SIZE(keys); i++)
+      EXPECT_EQ(value(keys[i]), _mesa_HashLookup(table, keys[i]));
+
+   EXPECT_EQ(NULL, _mesa_HashLookup(table, 4));
+   EXPECT_EQ(NULL, _mesa_HashLookup(table, 70000));
+
+   for (unsigned i = 0; i < ARRAY_SIZE(keys); i += 2)
+      _mesa_HashRemove(table, keys[i]);
+
+   EXPECT_EQ(ARRAY_SIZE(keys) / 2, _mesa_HashNumEntries(table));
+
+   for (unsigned i = 0; i < ARRAY_SIZE(keys); i++) {
+      EXPECT_EQ(i % 2 ? value(keys[i]) : NULL,
+                _mesa_HashLookup(table, keys[i]));
+   }
+}
+
+TEST_F(MesaHashTest, Replace)
+{
+   _mesa_HashInsert(table, 5, value(6));
+   _mesa_HashInsert(table, 5, value(5));
+   _mesa_HashInsert(table, 80000, value(6));
+   _mesa_HashInsert(table, 80000, value(80000));
+
+   EXPECT_EQ(2u, _mesa_HashNumEntries(table));
+   EXPECT_EQ(value(5), _mesa_HashLookup(table, 5));
+   EXPECT_EQ(value(80000), _mesa_HashLookup(table, 80000));
+}
+
+TEST_F(MesaHashTest, Walk)
+{
+   unsigned count = 0;
+
+   for (unsigned i = 0; i < ARRAY_SIZE(keys); i++)
+      _mesa_HashInsert(table, keys[i], value(keys[i]));
+
+   _mesa_HashWalk(table, count_entry, &count);
+   EXPECT_EQ(ARRAY_SIZE(keys), count);
+}
+
+TEST_F(MesaHashTest, FindFreeKeyBlock)
+{
+   GLuint key;
+
+   for (key = 1; key <= 300; key++)
+      _mesa_HashInsert(table, key, value(key));
+
+   key = _mesa_HashFindFreeKeyBlock(table, 10);
+   EXPECT_EQ(301u, key);
+   EXPECT_EQ(NULL, _mesa_HashLookup(table, key));
+}
+
+/* Lookups of existing names from other threads, as done when binding
+ * objects in contexts sharing the table, must see the right data while
+ * new names are added and the direct map grows.
+ */
+TEST_F(MesaHashTest, ConcurrentLookups)
+{
+   const GLuint num_existing = 200;
+   const GLuint num_added = 20000;
+   std::vector<std::thread> threads;
+   bool failed[4] = { false };
+
+   for (GLuint key = 1; key <= num_existing; key++)
+      _mesa_HashInsert(table, key, value(key));
+
+   for (unsigned t = 0; t < ARRAY_SIZE(failed); t++) {
+      threads.push_back(std::thread([this, t, &failed, num_existing] {
+         for (unsigned n = 0; n < 200000; n++) {
+            GLuint key = 1 + (n * 7 + t) % num_existing;
+
+            if (_mesa_HashLookup(table, key) != value(key))
+               failed[t] = true;
+         }
+      }));
+   }
+
+   for (GLuint key = num_existing + 1; key <= num_existing + num_added; key++)
+      _mesa_HashInsert(table, key, value(key));
+
+   for (unsigned t = 0; t < ARRAY_SIZE(failed); t++) {
+      threads[t].join();
+      EXPECT_FALSE(failed[t]);
+   }
+
+   EXPECT_EQ(num_existing + num_added, _mesa_HashNumEntries(table));
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <gtest/gtest.h>
+#include <stdint.h>
+#include <vector>
+
+#include "main/mipmap.h"
+#include "util/format_srgb.h"
+#include "util/macros.h"
+
+/* The widths go up to a bit more than twice the 16 pixels that the widest
+ * SSE2 loop handles at once, so every path gets a partial block.
+ */
+#define MAX_SRC_WIDTH 82
+
+static void
+fill(std::vector<GLubyte> &data, unsigned seed)
+{
+   for (size_t i = 0; i < data.size(); i++) {
+      seed = seed * 1103515245 + 12345;
+      data[i] = seed >> 16;
+   }
+}
+
+static void
+fill(std::vector<GLfloat> &data, unsigned seed)
+{
+   for (size_t i = 0; i < data.size(); i++) {
+      seed = seed * 1103515245 + 12345;
+      data[i] = (seed >> 16 & 0xffff) / 65536.0F;
+   }
+}
+
+/* Halve a srcWidth x 2 image (x 2 slices for 3D) down to one row. */
+template<typename T>
+static std::vector<T>
+generate(GLenum target, GLenum datatype, GLuint comps, GLbitfield srgbMask,
+         int srcWidth, const std::vector<T> &src)
+{
+   const int dstWidth = srcWidth / 2;
+   const int srcRowStride = srcWidth * comps * sizeof(T);
+   const int depth = target == GL_TEXTURE_3D ? 2 : 1;
+   const GLubyte *srcData[2] = {
+      (const GLubyte *) src.data(),
+      (const GLubyte *) src.data() + 2 * srcRowStride,
+   };
+   std::vector<T> dst(dstWidth * comps);
+   GLubyte *dstData[1] = { (GLubyte *) dst.data() };
+
+   _mesa_generate_mipmap_level(target, datatype, comps, srgbMask, 0,
+                               srcWidth, 2, depth, srcData, srcRowStride,
+                               dstWidth, 1, 1, dstData,
+                               dstWidth * comps * sizeof(T));
+   return dst;
+}
+
+TEST(MesaMipmapTest, RowsUnsignedByte)
+{
+   for (GLuint comps = 1; comps <= 4; comps++) {
+      for (int w = 2; w <= MAX_SRC_WIDTH; w++) {
+         std::vector<GLubyte> src(w * 2 * comps);
+         fill(src, w * comps);
+
+         std::vector<GLubyte> dst =
+            generate(GL_TEXTURE_2D, GL_UNSIGNED_BYTE, comps, 0, w, src);
+         const GLubyte *a = src.data(), *b = a + w * comps;
+
+         for (int i = 0; i < w / 2; i++) {
+            for (GLuint c = 0; c < comps; c++) {
+               const int j = 2 * i * comps + c, k = j + comps;
+
+               EXPECT_EQ((a[j] + a[k] + b[j] + b[k]) / 4,
+                         dst[i * comps + c])
+                  << "comps " << comps << " width " << w << " pixel " << i;
+            }
+         }
+      }
+   }
+}
+
+TEST(MesaMipmapTest, RowsFloat)
+{
+   for (GLuint comps = 1; comps <= 4; comps++) {
+      for (int w = 2; w <= MAX_SRC_WIDTH; w++) {
+         std::vector<GLfloat> src(w * 2 * comps);
+         fill(src, w * comps);
+
+         std::vector<GLfloat> dst =
+            generate(GL_TEXTURE_2D, GL_FLOAT, comps, 0, w, src);
+         const GLfloat *a = src.data(), *b = a + w * comps;
+
+         /* Bit-exact: the sums are done in the same order. */
+         for (int i = 0; i < w / 2; i++) {
+            for (GLuint c = 0; c < comps; c++) {
+               const int j = 2 * i * comps + c, k = j + comps;
+
+               EXPECT_EQ((a[j] + a[k] + b[j] + b[k]) * 0.25F,
+                         dst[i * comps + c])
+                  << "comps " << comps << " width " << w << " pixel " << i;
+            }
+         }
+      }
+   }
+}
+
+TEST(MesaMipmapTest, RowsSrgb)
+{
+   const float *linear = util_format_srgb_8unorm_to_linear_float_table;
+
+   /* sRGB, sRGB alpha and sLuminance alpha */
+   static const struct { GLuint comps; GLbitfield mask; } formats[] = {
+      { 3, 0x7 }, { 4, 0x7 }, { 2, 0x1 },
+   };
+
+   for (unsigned f = 0; f < ARRAY_SIZE(formats); f++) {
+      const GLuint comps = formats[f].comps;
+      const GLbitfield mask = formats[f].mask;
+
+      for (int w = 2; w <= MAX_SRC_WIDTH; w++) {
+         std::vector<GLubyte> src(w * 2 * comps);
+         fill(src, w * comps);
+
+         std::vector<GLubyte> dst =
+            generate(GL_TEXTURE_2D, GL_UNSIGNED_BYTE, comps, mask, w, src);
+         const GLubyte *a = src.data(), *b = a + w * comps;
+
+         for (int i = 0; i < w / 2; i++) {
+            for (GLuint c = 0; c < comps; c++) {
+               const int j = 2 * i * comps + c, k = j + comps;
+               const GLubyte expected = (mask & (1 << c)) ?
+                  util_format_linear_float_to_srgb_8unorm(
+                     (linear[a[j]] + linear[a[k]] +
+                      linear[b[j]] + linear[b[k]]) * 0.25F) :
+                  (a[j] + a[k] + b[j] + b[k]) / 4;
+
+               EXPECT_EQ(expected, dst[i * comps + c])
+                  << "comps " << comps << " width " << w << " pixel " << i;
+            }
+         }
+      }
+   }
+}
+
+TEST(MesaMipmapTest, RowsSrgb3D)
+{
+   const float *linear = util_format_srgb_8unorm_to_linear_float_table;
+   const GLuint comps = 4;
+
+   for (int w = 2; w <= MAX_SRC_WIDTH; w++) {
+      std::vector<GLubyte> src(w * 4 * comps);
+      fill(src, w);
+
+      std::vector<GLubyte> dst =
+         generate(GL_TEXTURE_3D, GL_UNSIGNED_BYTE, comps, 0x7, w, src);
+      const GLubyte *a = src.data(), *b = a + w * comps;
+      const GLubyte *c = b + w * comps, *d = c + w * comps;
+
+      for (int i = 0; i < w / 2; i++) {
+         for (GLuint e = 0; e < comps; e++) {
+            const int j = 2 * i * comps + e, k = j + comps;
+            const GLubyte expected = e < 3 ?
+               util_format_linear_float_to_srgb_8unorm(
+                  (linear[a[j]] + linear[a[k]] +
+                   linear[b[j]] + linear[b[k]] +
+                   linear[c[j]] + linear[c[k]] +
+                   linear[d[j]] + linear[d[k]]) * 0.125F) :
+               (a[j] + a[k] + b[j] + b[k] + c[j] + c[k] + d[j] + d[k] + 4) >> 3;
+
+            EXPECT_EQ(expected, dst[i * comps + e])
+               << "width " << w << " pixel " << i;
+         }
+      }
+   }
+}
+
+TEST(MesaMipmapTest, SrgbAlphaIsLinear)
+{
+   /* Black and white, transparent and opaque: the color channels are
+    * averaged in linear space, alpha is not.
+    */
+   std::vector<GLubyte> src(2 * 2 * 4);
+   for (int p = 0; p < 4; p++) {
+      const GLubyte v = (p & 1) ? 255 : 0;
+      for (int c = 0; c < 4; c++)
+         src[p * 4 + c] = v;
+   }
+
+   std::vector<GLubyte> srgb =
+      generate(GL_TEXTURE_2D, GL_UNSIGNED_BYTE, 4, 0x7, 2, src);
+   std::vector<GLubyte> plain =
+      generate(GL_TEXTURE_2D, GL_UNSIGNED_BYTE, 4, 0, 2, src);
+
+   for (int c = 0; c < 3; c++) {
+      EXPECT_EQ(127, plain[c]);
+      EXPECT_EQ(util_format_linear_float_to_srgb_8unorm(0.5F), srgb[c]);
+      EXPECT_GT(srgb[c], 180);
+   }
+   EXPECT_EQ(127, plain[3]);
+   EXPECT_EQ(127, srgb[3]);
+}
@@ -60,6 +60,7 @@
 #include "mipmap.h"
 #include "mtypes.h"
 #include "pack.h"
+#include "parallel_rows.h"
 #include "pbo.h"
 #include "imports.h"
 #include "texcompress.h"
@@ -89,6 +90,39 @@ enum {
 typedef GLboolean (*StoreTexImageFunc)(TEXSTORE_PARAMS);
 
 
+struct memcpy_texture_job {
+   GLubyte *dst;
+   const GLubyte *src;
+   GLint dstRowStride, srcRowStride;
+   GLint bytesPerRow;
+};
+
+
+static void
+memcpy_texture_rows(void *data, size_t y, size_t height)
+{
+   const struct memcpy_texture_job *job =
+      (const struct memcpy_texture_job *) data;
+   GLubyte *dstRow = job->dst + (ptrdiff_t) y * job->dstRowStride;
+   const GLubyte *srcRow = job->src + (ptrdiff_t) y * job->srcRowStride;
+   size_t row;
+
+   if (job->dstRowStride == job->srcRowStride &&
+       job->dstRowStride == job->bytesPerRow) {
+      /* memcpy the whole band */
+      memcpy(dstRow, srcRow, job->bytesPerRow * height);
+   }
+   else {
+      /* memcpy row by row */
+      for (row = 0; row < height; row++) {
+         memcpy(dstRow, srcRow, job->bytesPerRow);
+         dstRow += job->dstRowStride;
+         srcRow += job->srcRowStride;
+      }
+   }
+}
+
+
 /**
  * Teximage storage routine for when a simple memcpy will do.
  * No pixel transfer operations or special texel encodings allowed.
@@ -112,31 +146,19 @@ _mesa_memcpy_texture(struct gl_context *ctx,
    const GLubyte *srcImage = (const GLubyte *) _mesa_image_address(dimensions,
         srcPacking, srcAddr, srcWidth, srcHeight, srcFormat, srcType, 0, 0, 0);
    const GLuint texelBytes = _mesa_get_format_bytes(dstFormat);
-   const GLint bytesPerRow = srcWidth * texelBytes;
+   struct memcpy_texture_job job;
+   GLint img;
 
-   if (dstRowStride == srcRowStride &&
-       dstRowStride == bytesPerRow) {
-      /* memcpy image by image */
-      GLint img;
-      for (img = 0; img < srcDepth; img++) {
-         GLubyte *dstImage = dstSlices[img];
-         memcpy(dstImage, srcImage, bytesPerRow * srcHeight);
-         srcImage += srcImageStride;
-      }
-   }
-   else {
-      /* memcpy row by row */
-      GLint img, row;
-      for (img = 0; img < srcDepth; img++) {
-         const GLubyte *srcRow = srcImage;
-         GLubyte *dstRow = dstSlices[img];
-         for (row = 0; row < srcHeight; row++) {
-            memcpy(dstRow, srcRow, bytesPerRow);
-            dstRow += dstRowStride;
-            srcRow += srcRowStride;
-         }
-         srcImage += srcImageStride;
-      }
+   job.dstRowStride = dstRowStride;
+   job.srcRowStride = srcRowStride;
+   job.bytesPerRow = srcWidth * texelBytes;
+
+   /* Large images are copied in bands of rows on several threads. */
+   for (img = 0; img < srcDepth; img++) {
+      job.dst = dstSlices[img];
+      job.src = srcImage;
+      _mesa_parallel_rows(srcWidth, srcHeight, memcpy_texture_rows, &job);
+      srcImage += srcImageStride;
    }
 }
 
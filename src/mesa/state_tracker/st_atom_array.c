@@ -437,18 +437,48 @@ static void init_velement_lowered(struct st_context *st,
    *attr_idx = idx;
 }
 
+/**
+ * Where the data of one vertex buffer comes from.  The pipe_resource is
+ * looked up at bind time since it changes when the buffer is reallocated.
+ */
+struct st_vbuffer_source
+{
+   struct gl_buffer_object *bufobj;   /**< NULL for user memory */
+   const GLubyte *ptr;                /**< offset into bufobj or user pointer */
+   GLsizei stride;
+};
+
+/**
+ * The translated vertex layout for one set of arrays and vertex shader
+ * inputs.  When all the arrays come from the bound VAO, this is cached on
+ * the VAO (as gl_vertex_array_object::DriverLayout), so that rebinding
+ * the VAO only needs to compare the array pointers instead of translating
+ * the arrays and hashing the vertex elements again.
+ */
+struct st_vao_layout
+{
+   GLuint stamp;          /**< gl_vertex_array_object::LayoutStamp */
+   unsigned num_inputs;
+   const struct gl_vertex_array *arrays[PIPE_MAX_ATTRIBS];
+
+   struct pipe_vertex_element velements[PIPE_MAX_ATTRIBS];
+
+   unsigned num_vbuffers;
+   struct st_vbuffer_source vbuffers[PIPE_MAX_ATTRIBS];
+};
+
 /**
  * Set up for drawing interleaved arrays that all live in one VBO
  * or all live in user space.
- * \param vbuffer  returns vertex buffer info
+ * \param vbuffer  returns vertex buffer source
  * \param velements  returns vertex element info
  */
-static boolean
+static void
 setup_interleaved_attribs(struct st_context *st,
                           const struct st_vertex_program *vp,
                           const struct st_vp_variant *vpv,
                           const struct gl_vertex_array **arrays,
-                          struct pipe_vertex_buffer *vbuffer,
+                          struct st_vbuffer_source *vbuffer,
                           struct pipe_vertex_element velements[])
 {
    GLuint attr;
@@ -520,48 +550,23 @@ setup_interleaved_attribs(struct st_context *st,
    /*
     * Return the vbuffer info and setup user-space attrib info, if needed.
     */
-   if (vpv->num_inputs == 0) {
-      /* just defensive coding here */
-      vbuffer->buffer = NULL;
-      vbuffer->user_buffer = NULL;
-      vbuffer->buffer_offset = 0;
-      vbuffer->stride = 0;
-   }
-   else if (usingVBO) {
-      /* all interleaved arrays in a VBO */
-      struct st_buffer_object *stobj = st_buffer_object(bufobj);
-
-      if (!stobj || !stobj->buffer) {
-         return FALSE; /* out-of-memory error probably */
-      }
-
-      vbuffer->buffer = stobj->buffer;
-      vbuffer->user_buffer = NULL;
-      vbuffer->buffer_offset = pointer_to_offset(low_addr);
-      vbuffer->stride = stride;
-   }
-   else {
-      /* all interleaved arrays in user memory */
-      vbuffer->buffer = NULL;
-      vbuffer->user_buffer = low_addr;
-      vbuffer->buffer_offset = 0;
-      vbuffer->stride = stride;
-   }
-   return TRUE;
+   vbuffer->bufobj = usingVBO ? bufobj : NULL;
+   vbuffer->ptr = low_addr;
+   vbuffer->stride = stride;
 }
 
 /**
- * Set up a separate pipe_vertex_buffer and pipe_vertex_element for each
+ * Set up a separate vertex buffer and pipe_vertex_element for each
  * vertex attribute.
- * \param vbuffer  returns vertex buffer info
+ * \param vbuffer  returns vertex buffer sources
  * \param velements  returns vertex element info
  */
-static boolean
+static void
 setup_non_interleaved_attribs(struct st_context *st,
                               const struct st_vertex_program *vp,
                               const struct st_vp_variant *vpv,
                               const struct gl_vertex_array **arrays,
-                              struct pipe_vertex_buffer vbuffer[],
+                              struct st_vbuffer_source vbuffer[],
                               struct pipe_vertex_element velements[],
                               unsigned *num_vbuffers)
 {
@@ -593,34 +598,26 @@ setup_non_interleaved_attribs(struct st_context *st,
           * Recall that for VBOs, the gl_vertex_array->Ptr field is
           * really an offset from the start of the VBO, not a pointer.
           */
-         struct st_buffer_object *stobj = st_buffer_object(bufobj);
-
-         if (!stobj || !stobj->buffer) {
-            return FALSE; /* out-of-memory error probably */
-         }
-
-         vbuffer[bufidx].buffer = stobj->buffer;
-         vbuffer[bufidx].user_buffer = NULL;
-         vbuffer[bufidx].buffer_offset = pointer_to_offset(array->Ptr);
+         vbuffer[bufidx].bufobj = bufobj;
+         vbuffer[bufidx].ptr = array->Ptr;
       }
       else {
          /* wrap user data */
-         void *ptr;
+         const GLubyte *ptr;
 
          if (array->Ptr) {
-            ptr = (void *) array->Ptr;
+            ptr = array->Ptr;
          }
          else {
             /* no array, use ctx->Current.Attrib[] value */
-            ptr = (void *) ctx->Current.Attrib[mesaAttr];
+            ptr = (const GLubyte *) ctx->Current.Attrib[mesaAttr];
             stride = 0;
          }
 
          assert(ptr);
 
-         vbuffer[bufidx].buffer = NULL;
-         vbuffer[bufidx].user_buffer = ptr;
-         vbuffer[bufidx].buffer_offset = 0;
+         vbuffer[bufidx].bufobj = NULL;
+         vbuffer[bufidx].ptr = ptr;
       }
 
       /* common-case setup */
@@ -636,19 +633,96 @@ setup_non_interleaved_attribs(struct st_context *st,
                             array->InstanceDivisor, bufidx,
                             array->Size, array->Doubles, &attr);
    }
+}
+
+/**
+ * Translate the arrays used by the vertex shader into a vertex layout.
+ */
+static void
+setup_layout(struct st_context *st,
+             const struct st_vertex_program *vp,
+             const struct st_vp_variant *vpv,
+             const struct gl_vertex_array **arrays,
+             struct st_vao_layout *layout)
+{
+   GLuint attr;
+
+   layout->num_inputs = vpv->num_inputs;
+   for (attr = 0; attr < vpv->num_inputs; attr++)
+      layout->arrays[attr] = get_client_array(vp, arrays, attr);
+
+   memset(layout->velements, 0,
+          sizeof(struct pipe_vertex_element) * vpv->num_inputs);
 
-   return TRUE;
+   if (is_interleaved_arrays(vp, vpv, arrays)) {
+      setup_interleaved_attribs(st, vp, vpv, arrays, layout->vbuffers,
+                                layout->velements);
+
+      layout->num_vbuffers = 1;
+      if (vpv->num_inputs == 0)
+         layout->num_vbuffers = 0;
+   }
+   else {
+      setup_non_interleaved_attribs(st, vp, vpv, arrays, layout->vbuffers,
+                                    layout->velements, &layout->num_vbuffers);
+   }
+}
+
+/**
+ * Whether the layout cached on the VAO was built from the same arrays.
+ * The arrays can only change through the VAO, which bumps its stamp.
+ */
+static bool
+layout_is_current(const struct st_vao_layout *layout,
+                  const struct gl_vertex_array_object *vao,
+                  const struct st_vertex_program *vp,
+                  const struct st_vp_variant *vpv,
+                  const struct gl_vertex_array **arrays)
+{
+   GLuint attr;
+
+   if (layout->stamp != vao->LayoutStamp ||
+       layout->num_inputs != vpv->num_inputs)
+      return false;
+
+   for (attr = 0; attr < vpv->num_inputs; attr++) {
+      if (layout->arrays[attr] != get_client_array(vp, arrays, attr))
+         return false;
+   }
+   return true;
+}
+
+/**
+ * Whether all the arrays of the layout are owned by the VAO, as opposed to
+ * current attrib values or temporary arrays set up by the vbo module.
+ */
+static bool
+layout_is_cacheable(const struct st_vao_layout *layout,
+                    const struct gl_vertex_array_object *vao)
+{
+   GLuint attr;
+
+   for (attr = 0; attr < layout->num_inputs; attr++) {
+      const struct gl_vertex_array *array = layout->arrays[attr];
+
+      if (array && (array < vao->_VertexAttrib ||
+                    array >= vao->_VertexAttrib + VERT_ATTRIB_MAX))
+         return false;
+   }
+   return true;
 }
 
 static void update_array(struct st_context *st)
 {
    struct gl_context *ctx = st->ctx;
+   struct gl_vertex_array_object *vao = ctx->Array.VAO;
    const struct gl_vertex_array **arrays = ctx->Array._DrawArrays;
    const struct st_vertex_program *vp;
    const struct st_vp_variant *vpv;
+   const struct st_vao_layout *layout = vao->DriverLayout;
+   struct st_vao_layout new_layout;
    struct pipe_vertex_buffer vbuffer[PIPE_MAX_SHADER_INPUTS];
-   struct pipe_vertex_element velements[PIPE_MAX_ATTRIBS];
-   unsigned num_vbuffers;
+   unsigned i;
 
    st->vertex_array_out_of_memory = FALSE;
 
@@ -660,37 +734,57 @@ static void update_array(struct st_context *st)
    vp = st->vp;
    vpv = st->vp_variant;
 
-   memset(velements, 0, sizeof(struct pipe_vertex_element) * vpv->num_inputs);
-
    /*
-    * Setup the vbuffer[] and velements[] arrays.
+    * Setup the vertex buffer sources and velements[] arrays, unless the
+    * VAO still holds them.
     */
-   if (is_interleaved_arrays(vp, vpv, arrays)) {
-      if (!setup_interleaved_attribs(st, vp, vpv, arrays, vbuffer, velements)) {
-         st->vertex_array_out_of_memory = TRUE;
-         return;
+   if (!layout || !layout_is_current(layout, vao, vp, vpv, arrays)) {
+      setup_layout(st, vp, vpv, arrays, &new_layout);
+      layout = &new_layout;
+
+      if (layout_is_cacheable(&new_layout, vao)) {
+         if (!vao->DriverLayout)
+            vao->DriverLayout = malloc(sizeof(struct st_vao_layout));
+         if (vao->DriverLayout) {
+            new_layout.stamp = vao->LayoutStamp;
+            memcpy(vao->DriverLayout, &new_layout, sizeof(new_layout));
+         }
       }
-
-      num_vbuffers = 1;
-      if (vpv->num_inputs == 0)
-         num_vbuffers = 0;
    }
-   else {
-      if (!setup_non_interleaved_attribs(st, vp, vpv, arrays, vbuffer,
-                                         velements, &num_vbuffers)) {
-         st->vertex_array_out_of_memory = TRUE;
-         return;
+
+   for (i = 0; i < layout->num_vbuffers; i++) {
+      const struct st_vbuffer_source *src = &layout->vbuffers[i];
+
+      if (src->bufobj) {
+         struct st_buffer_object *stobj = st_buffer_object(src->bufobj);
+
+         if (!stobj->buffer) {
+            st->vertex_array_out_of_memory = TRUE;
+            return; /* out-of-memory error probably */
+         }
+
+         vbuffer[i].buffer = stobj->buffer;
+         vbuffer[i].user_buffer = NULL;
+         vbuffer[i].buffer_offset = pointer_to_offset(src->ptr);
+      }
+      else {
+         vbuffer[i].buffer = NULL;
+         vbuffer[i].user_buffer = src->ptr;
+         vbuffer[i].buffer_offset = 0;
       }
+      vbuffer[i].stride = src->stride;
    }
 
-   cso_set_vertex_buffers(st->cso_context, 0, num_vbuffers, vbuffer);
-   if (st->last_num_vbuffers > num_vbuffers) {
+   cso_set_vertex_buffers(st->cso_context, 0, layout->num_vbuffers, vbuffer);
+   if (st->last_num_vbuffers > layout->num_vbuffers) {
       /* Unbind remaining buffers, if any. */
-      cso_set_vertex_buffers(st->cso_context, num_vbuffers,
-                             st->last_num_vbuffers - num_vbuffers, NULL);
+      cso_set_vertex_buffers(st->cso_context, layout->num_vbuffers,
+                             st->last_num_vbuffers - layout->num_vbuffers,
+                             NULL);
    }
-   st->last_num_vbuffers = num_vbuffers;
-   cso_set_vertex_elements(st->cso_context, vpv->num_inputs, velements);
+   st->last_num_vbuffers = layout->num_vbuffers;
+   cso_set_vertex_elements(st->cso_context, vpv->num_inputs,
+                           layout->velements);
 }
 
 
@@ -91,20 +91,68 @@ needs_integer_signed_unsigned_conversion(const struct gl_context *ctx,
    return FALSE;
 }
 
+/**
+ * Return the color format that the download shader can write depth values
+ * to, since depth formats can't be used for shader images.
+ */
+static enum pipe_format
+pbo_image_format(enum pipe_format format)
+{
+   switch (format) {
+   case PIPE_FORMAT_Z16_UNORM:
+      return PIPE_FORMAT_R16_UNORM;
+   case PIPE_FORMAT_Z32_UNORM:
+      return PIPE_FORMAT_R32_UNORM;
+   case PIPE_FORMAT_Z32_FLOAT:
+      return PIPE_FORMAT_R32_FLOAT;
+   default:
+      return format;
+   }
+}
+
+/**
+ * Compute where the pixels being read go in the PBO.  Returns false if
+ * they can't be written there with the download shader.
+ */
 static bool
-try_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
-                   bool invert_y,
-                   GLint x, GLint y, GLsizei width, GLsizei height,
+pbo_readpixels_addresses(struct st_context *st, enum pipe_format dst_format,
+                         GLint x, GLint y, GLsizei width, GLsizei height,
+                         const struct gl_pixelstore_attrib *pack,
+                         void *pixels, struct st_pbo_addresses *addr)
+{
+   struct pipe_screen *screen = st->pipe->screen;
+   const struct util_format_description *desc;
+
+   dst_format = pbo_image_format(dst_format);
+   if (!screen->is_format_supported(screen, dst_format, PIPE_BUFFER, 0,
+                                    PIPE_BIND_SHADER_IMAGE))
+      return false;
+
+   desc = util_format_description(dst_format);
+
+   addr->bytes_per_pixel = desc->block.bits / 8;
+   addr->xoffset = x;
+   addr->yoffset = y;
+   addr->width = width;
+   addr->height = height;
+   addr->depth = 1;
+   return st_pbo_addresses_pixelstore(st, GL_TEXTURE_2D, false, pack, pixels,
+                                      addr);
+}
+
+/**
+ * Write the pixels to the PBO with a fragment shader, without waiting for
+ * the GPU.  The layer of the given texture level is the framebuffer being
+ * read, with addr set up by pbo_readpixels_addresses().
+ */
+static bool
+try_pbo_readpixels(struct st_context *st, struct pipe_resource *texture,
+                   unsigned level, unsigned layer, bool invert_y,
                    enum pipe_format src_format, enum pipe_format dst_format,
-                   const struct gl_pixelstore_attrib *pack, void *pixels)
+                   struct st_pbo_addresses *addr)
 {
    struct pipe_context *pipe = st->pipe;
-   struct pipe_screen *screen = pipe->screen;
    struct cso_context *cso = st->cso_context;
-   struct pipe_surface *surface = strb->surface;
-   struct pipe_resource *texture = strb->texture;
-   const struct util_format_description *desc;
-   struct st_pbo_addresses addr;
    struct pipe_framebuffer_state fb;
    enum pipe_texture_target view_target;
    bool success = false;
@@ -112,21 +160,7 @@ try_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
    if (texture->nr_samples > 1)
       return false;
 
-   if (!screen->is_format_supported(screen, dst_format, PIPE_BUFFER, 0,
-                                    PIPE_BIND_SHADER_IMAGE))
-      return false;
-
-   desc = util_format_description(dst_format);
-
-   /* Compute PBO addresses */
-   addr.bytes_per_pixel = desc->block.bits / 8;
-   addr.xoffset = x;
-   addr.yoffset = y;
-   addr.width = width;
-   addr.height = height;
-   addr.depth = 1;
-   if (!st_pbo_addresses_pixelstore(st, GL_TEXTURE_2D, false, pack, pixels, &addr))
-      return false;
+   dst_format = pbo_image_format(dst_format);
 
    cso_save_state(cso, (CSO_BIT_FRAGMENT_SAMPLER_VIEWS |
                         CSO_BIT_FRAGMENT_SAMPLERS |
@@ -170,14 +204,14 @@ try_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
       }
 
       templ.target = view_target;
-      templ.u.tex.first_level = surface->u.tex.level;
+      templ.u.tex.first_level = level;
       templ.u.tex.last_level = templ.u.tex.first_level;
 
       if (view_target != PIPE_TEXTURE_3D) {
-         templ.u.tex.first_layer = surface->u.tex.first_layer;
-         templ.u.tex.last_layer = templ.u.tex.last_layer;
+         templ.u.tex.first_layer = layer;
+         templ.u.tex.last_layer = templ.u.tex.first_layer;
       } else {
-         addr.constants.layer_offset = surface->u.tex.first_layer;
+         addr->constants.layer_offset = layer;
       }
 
       sampler_view = pipe->create_sampler_view(pipe, texture, &templ);
@@ -196,20 +230,20 @@ try_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
       struct pipe_image_view image;
 
       memset(&image, 0, sizeof(image));
-      image.resource = addr.buffer;
+      image.resource = addr->buffer;
       image.format = dst_format;
       image.access = PIPE_IMAGE_ACCESS_WRITE;
-      image.u.buf.offset = addr.first_element * addr.bytes_per_pixel;
-      image.u.buf.size = (addr.last_element - addr.first_element + 1) *
-                         addr.bytes_per_pixel;
+      image.u.buf.offset = addr->first_element * addr->bytes_per_pixel;
+      image.u.buf.size = (addr->last_element - addr->first_element + 1) *
+                         addr->bytes_per_pixel;
 
       cso_set_shader_images(cso, PIPE_SHADER_FRAGMENT, 0, 1, &image);
    }
 
    /* Set up no-attachment framebuffer */
    memset(&fb, 0, sizeof(fb));
-   fb.width = surface->width;
-   fb.height = surface->height;
+   fb.width = u_minify(texture->width0, level);
+   fb.height = u_minify(texture->height0, level);
    fb.samples = 1;
    fb.layers = 1;
    cso_set_framebuffer(cso, &fb);
@@ -222,7 +256,7 @@ try_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
    cso_set_viewport_dims(cso, fb.width, fb.height, invert_y);
 
    if (invert_y)
-      st_pbo_addresses_invert_y(&addr, fb.height);
+      st_pbo_addresses_invert_y(addr, fb.height);
 
    {
       struct pipe_depth_stencil_alpha_state dsa;
@@ -239,7 +273,7 @@ try_pbo_readpixels(struct st_context *st, struct st_renderbuffer *strb,
       cso_set_fragment_shader_handle(cso, fs);
    }
 
-   success = st_pbo_draw(st, &addr, fb.width, fb.height);
+   success = st_pbo_draw(st, addr, fb.width, fb.height);
 
    /* Buffer written via shader images needs explicit synchronization. */
    pipe->memory_barrier(pipe, PIPE_BARRIER_ALL);
@@ -251,6 +285,108 @@ fail:
    return success;
 }
 
+/**
+ * Resolve the region being read from a multisampled renderbuffer into a
+ * temporary texture of its size, so that it can be downloaded into the PBO
+ * on the GPU as well.
+ */
+static bool
+try_pbo_readpixels_resolve(struct st_context *st, struct st_renderbuffer *strb,
+                           bool invert_y,
+                           GLint x, GLint y, GLsizei width, GLsizei height,
+                           GLenum format,
+                           enum pipe_format src_format,
+                           enum pipe_format dst_format,
+                           const struct gl_pixelstore_attrib *pack,
+                           void *pixels)
+{
+   struct pipe_context *pipe = st->pipe;
+   struct pipe_screen *screen = pipe->screen;
+   struct pipe_resource *src = strb->texture;
+   struct pipe_resource templ;
+   struct pipe_resource *resolved;
+   struct pipe_blit_info blit;
+   struct st_pbo_addresses addr;
+   unsigned bind;
+   bool success;
+
+   if (src->target != PIPE_TEXTURE_2D && src->target != PIPE_TEXTURE_RECT)
+      return false;
+
+   /* The region is resolved to the origin of the temporary texture. */
+   if (!pbo_readpixels_addresses(st, dst_format, 0, 0, width, height,
+                                 pack, pixels, &addr))
+      return false;
+
+   if (util_format_is_depth_or_stencil(src_format))
+      bind = PIPE_BIND_DEPTH_STENCIL;
+   else
+      bind = PIPE_BIND_RENDER_TARGET;
+
+   if (!screen->is_format_supported(screen, src_format, src->target, 0,
+                                    bind | PIPE_BIND_SAMPLER_VIEW))
+      return false;
+
+   memset(&templ, 0, sizeof(templ));
+   templ.target = src->target;
+   templ.format = src_format;
+   templ.width0 = width;
+   templ.height0 = height;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.bind = bind | PIPE_BIND_SAMPLER_VIEW;
+
+   resolved = screen->resource_create(screen, &templ);
+   if (!resolved)
+      return false;
+
+   memset(&blit, 0, sizeof(blit));
+   blit.src.resource = src;
+   blit.src.level = strb->surface->u.tex.level;
+   blit.src.format = src_format;
+   blit.dst.resource = resolved;
+   blit.dst.level = 0;
+   blit.dst.format = src_format;
+   blit.src.box.x = x;
+   blit.src.box.y = invert_y ? (int) strb->surface->height - y - height : y;
+   blit.src.box.z = strb->surface->u.tex.first_layer;
+   blit.src.box.width = width;
+   blit.src.box.height = height;
+   blit.src.box.depth = 1;
+   blit.dst.box = blit.src.box;
+   blit.dst.box.x = 0;
+   blit.dst.box.y = 0;
+   blit.dst.box.z = 0;
+   blit.mask = st_get_blit_mask(strb->Base._BaseFormat, format);
+   blit.filter = PIPE_TEX_FILTER_NEAREST;
+   blit.scissor_enable = FALSE;
+
+   pipe->blit(pipe, &blit);
+
+   success = try_pbo_readpixels(st, resolved, 0, 0, invert_y,
+                                src_format, dst_format, &addr);
+
+   pipe_resource_reference(&resolved, NULL);
+   return success;
+}
+
+void
+st_print_readpix_counters(const struct st_context *st)
+{
+   static const char *names[ST_READPIX_NUM_PATHS] = {
+      [ST_READPIX_PBO_DOWNLOAD] = "pbo download",
+      [ST_READPIX_PBO_DOWNLOAD_RESOLVE] = "pbo download (msaa resolve)",
+      [ST_READPIX_CACHED] = "cached staging texture",
+      [ST_READPIX_BLIT] = "blit to staging texture",
+      [ST_READPIX_FALLBACK] = "_mesa_readpixels",
+   };
+   unsigned i;
+
+   debug_printf("st/readpixels:\n");
+   for (i = 0; i < ST_READPIX_NUM_PATHS; i++)
+      debug_printf("   %-28s %u\n", names[i], st->readpix_counters[i]);
+}
+
 /* Invalidate the readpixels cache to ensure we don't read stale data.
  */
 void st_invalidate_readpix_cache(struct st_context *st)
@@ -419,6 +555,7 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
    struct pipe_transfer *tex_xfer;
    ubyte *map = NULL;
    int dst_x, dst_y;
+   enum st_readpix_path path;
 
    /* Validate state (to be sure we have up-to-date framebuffer surfaces)
     * and flush the bitmap cache prior to reading. */
@@ -475,13 +612,31 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
       goto fallback;
    }
 
+   /* Reading into a PBO never has to wait for the GPU this way, so
+    * glMapBuffer is the first point where the application syncs.
+    */
    if (st->pbo.download_enabled && _mesa_is_bufferobj(pack->BufferObj)) {
-      if (try_pbo_readpixels(st, strb,
-                             st_fb_orientation(ctx->ReadBuffer) == Y_0_TOP,
-                             x, y, width, height,
-                             src_format, dst_format,
-                             pack, pixels))
+      const bool invert_y = st_fb_orientation(ctx->ReadBuffer) == Y_0_TOP;
+      struct st_pbo_addresses addr;
+
+      if (src->nr_samples > 1) {
+         if (try_pbo_readpixels_resolve(st, strb, invert_y,
+                                        x, y, width, height, format,
+                                        src_format, dst_format,
+                                        pack, pixels)) {
+            st->readpix_counters[ST_READPIX_PBO_DOWNLOAD_RESOLVE]++;
+            return;
+         }
+      } else if (pbo_readpixels_addresses(st, dst_format,
+                                          x, y, width, height,
+                                          pack, pixels, &addr) &&
+                 try_pbo_readpixels(st, src, strb->surface->u.tex.level,
+                                    strb->surface->u.tex.first_layer,
+                                    invert_y, src_format, dst_format,
+                                    &addr)) {
+         st->readpix_counters[ST_READPIX_PBO_DOWNLOAD]++;
          return;
+      }
    }
 
    if (needs_integer_signed_unsigned_conversion(ctx, format, type)) {
@@ -497,6 +652,7 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
    if (dst) {
       dst_x = x;
       dst_y = y;
+      path = ST_READPIX_CACHED;
    } else {
       /* See if the texture format already matches the format and type,
        * in which case the memcpy-based fast path will likely be used and
@@ -515,6 +671,7 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
 
       dst_x = 0;
       dst_y = 0;
+      path = ST_READPIX_BLIT;
    }
 
    /* map resources */
@@ -552,9 +709,11 @@ st_ReadPixels(struct gl_context *ctx, GLint x, GLint y,
    pipe_transfer_unmap(pipe, tex_xfer);
    _mesa_unmap_pbo_dest(ctx, pack);
    pipe_resource_reference(&dst, NULL);
+   st->readpix_counters[path]++;
    return;
 
 fallback:
+   st->readpix_counters[ST_READPIX_FALLBACK]++;
    _mesa_readpixels(ctx, x, y, width, height, format, type, pack, pixels);
 }
 
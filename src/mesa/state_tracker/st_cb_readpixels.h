@@ -32,9 +32,26 @@
 #include "main/glheader.h"
 
 struct dd_function_table;
+struct st_context;
+
+/**
+ * The ways in which st_ReadPixels() can read back pixels.  Only the PBO
+ * download paths don't wait for the GPU.
+ */
+enum st_readpix_path {
+   ST_READPIX_PBO_DOWNLOAD,          /**< shader writes into the PBO */
+   ST_READPIX_PBO_DOWNLOAD_RESOLVE,  /**< same, from a resolved MSAA copy */
+   ST_READPIX_CACHED,                /**< memcpy from the readpixels cache */
+   ST_READPIX_BLIT,                  /**< blit to staging, then memcpy */
+   ST_READPIX_FALLBACK,              /**< _mesa_readpixels() */
+   ST_READPIX_NUM_PATHS
+};
 
 extern void
 st_init_readpixels_functions(struct dd_function_table *functions);
 
+extern void
+st_print_readpix_counters(const struct st_context *st);
+
 
 #endif /* ST_CB_READPIXELS_H */
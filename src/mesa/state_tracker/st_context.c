@@ -293,6 +293,9 @@ st_destroy_context_priv(struct st_context *st, bool destroy_pipe)
    st_destroy_perfmon(st);
    st_destroy_pbo_helpers(st);
 
+   if (util_queue_is_initialized(&st->link_queue))
+      util_queue_destroy(&st->link_queue);
+
    for (shader = 0; shader < ARRAY_SIZE(st->state.sampler_views); shader++) {
       for (i = 0; i < ARRAY_SIZE(st->state.sampler_views[0]); i++) {
          pipe_sampler_view_release(st->pipe,
@@ -307,6 +310,9 @@ st_destroy_context_priv(struct st_context *st, bool destroy_pipe)
    /* free glReadPixels cache data */
    st_invalidate_readpix_cache(st);
 
+   if (ST_DEBUG & DEBUG_READPIX)
+      st_print_readpix_counters(st);
+
    cso_destroy_context(st->cso_context);
 
    if (st->pipe && destroy_pipe)
@@ -33,6 +33,8 @@
 #include "state_tracker/st_api.h"
 #include "main/fbobject.h"
 #include "state_tracker/st_atom.h"
+#include "state_tracker/st_cb_readpixels.h"
+#include "util/u_queue.h"
 
 
 #ifdef __cplusplus
@@ -207,6 +209,9 @@ struct st_context
       unsigned hits;
    } readpix_cache;
 
+   /** Number of glReadPixels calls per st_readpix_path */
+   unsigned readpix_counters[ST_READPIX_NUM_PATHS];
+
    /** for glClear */
    struct {
       struct pipe_rasterizer_state raster;
@@ -254,6 +259,11 @@ struct st_context
    struct st_perf_monitor_group *perfmon;
 
    enum pipe_reset_status reset_status;
+
+   /** Threads lowering the GLSL IR of the stages of a program in parallel,
+    * created by the first link with more than one stage.
+    */
+   struct util_queue link_queue;
 };
 
 
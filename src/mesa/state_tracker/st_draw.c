@@ -229,37 +229,91 @@ st_draw_vbo(struct gl_context *ctx,
    assert(!indirect);
 
    /* do actual drawing */
-   for (i = 0; i < nr_prims; i++) {
-      info.mode = translate_prim(ctx, prims[i].mode);
-      info.start = prims[i].start;
-      info.count = prims[i].count;
-      info.start_instance = prims[i].base_instance;
-      info.instance_count = prims[i].num_instances;
-      info.vertices_per_patch = ctx->TessCtrlProgram.patch_vertices;
-      info.index_bias = prims[i].basevertex;
-      info.drawid = prims[i].draw_id;
-      if (!ib) {
-         info.min_index = info.start;
-         info.max_index = info.start + info.count - 1;
-      }
+   info.vertices_per_patch = ctx->TessCtrlProgram.patch_vertices;
 
-      if (ST_DEBUG & DEBUG_DRAW) {
-         debug_printf("st/draw: mode %s  start %u  count %u  indexed %d\n",
-                      u_prim_name(info.mode),
-                      info.start,
-                      info.count,
-                      info.indexed);
-      }
+   if (info.count_from_stream_output) {
+      info.mode = translate_prim(ctx, prims[0].mode);
+      info.start_instance = prims[0].base_instance;
+      info.instance_count = prims[0].num_instances;
+      info.drawid = prims[0].draw_id;
+      cso_draw_vbo(st->cso_context, &info);
+      return;
+   }
 
-      if (info.count_from_stream_output) {
-         cso_draw_vbo(st->cso_context, &info);
+   /* Consecutive prims that only differ in their ranges (as from
+    * glMultiDrawArrays/Elements) are handed to the driver in one call.
+    */
+   for (i = 0; i < nr_prims;) {
+      struct pipe_draw_start_count draws[32];
+      unsigned num_draws = 0;
+      unsigned first = i;
+
+      info.mode = translate_prim(ctx, prims[first].mode);
+      info.start_instance = prims[first].base_instance;
+      info.instance_count = prims[first].num_instances;
+      info.drawid = prims[first].draw_id;
+
+      for (; i < nr_prims && num_draws < ARRAY_SIZE(draws); i++) {
+         unsigned count = prims[i].count;
+
+         if (prims[i].mode != prims[first].mode ||
+             prims[i].base_instance != prims[first].base_instance ||
+             prims[i].num_instances != prims[first].num_instances ||
+             prims[i].draw_id != info.drawid + num_draws)
+            break;
+
+         if (ST_DEBUG & DEBUG_DRAW) {
+            debug_printf("st/draw: mode %s  start %u  count %u  indexed %d\n",
+                         u_prim_name(info.mode),
+                         prims[i].start,
+                         prims[i].count,
+                         info.indexed);
+         }
+
+         /* don't trim with restart, restarts might be inside index list */
+         if (!info.primitive_restart &&
+             !u_trim_pipe_prim(prims[i].mode, &count)) {
+            /* Nothing to draw, but the draw ids must stay consecutive. */
+            if (num_draws == 0) {
+               info.drawid++;
+               continue;
+            }
+            i++;
+            break;
+         }
+
+         draws[num_draws].start = prims[i].start;
+         draws[num_draws].count = count;
+         draws[num_draws].index_bias = prims[i].basevertex;
+         num_draws++;
       }
-      else if (info.primitive_restart) {
-         /* don't trim, restarts might be inside index list */
+
+      if (num_draws == 0)
+         continue;
+
+      if (num_draws == 1) {
+         info.start = draws[0].start;
+         info.count = draws[0].count;
+         info.index_bias = draws[0].index_bias;
+         if (!ib) {
+            info.min_index = info.start;
+            info.max_index = info.start + info.count - 1;
+         }
          cso_draw_vbo(st->cso_context, &info);
       }
-      else if (u_trim_pipe_prim(prims[i].mode, &info.count)) {
-         cso_draw_vbo(st->cso_context, &info);
+      else {
+         if (!ib) {
+            unsigned j;
+
+            info.min_index = ~0u;
+            info.max_index = 0;
+            for (j = 0; j < num_draws; j++) {
+               info.min_index = MIN2(info.min_index, draws[j].start);
+               info.max_index = MAX2(info.max_index,
+                                     draws[j].start + draws[j].count - 1);
+            }
+         }
+         cso_multi_draw_vbo(st->cso_context, &info, draws, num_draws);
       }
    }
 }
@@ -40,6 +40,7 @@
 #include "st_context.h"
 #include "st_program.h"
 #include "st_glsl_types.h"
+#include "st_shader_cache.h"
 
 #include "compiler/nir/nir.h"
 #include "compiler/glsl_types.h"
@@ -209,6 +210,28 @@ st_nir_assign_uniform_locations(struct gl_program *prog,
 
 extern "C" {
 
+static void
+st_nir_opts(nir_shader *nir)
+{
+   bool progress;
+   do {
+      progress = false;
+
+      NIR_PASS_V(nir, nir_lower_vars_to_ssa);
+      NIR_PASS(progress, nir, nir_copy_prop);
+      NIR_PASS(progress, nir, nir_opt_remove_phis);
+      NIR_PASS(progress, nir, nir_opt_dce);
+      NIR_PASS(progress, nir, nir_opt_dead_cf);
+      NIR_PASS(progress, nir, nir_opt_cse);
+      if (nir->options->opt_pre)
+         NIR_PASS(progress, nir, nir_opt_pre);
+      NIR_PASS(progress, nir, nir_opt_peephole_select, 8);
+      NIR_PASS(progress, nir, nir_opt_algebraic);
+      NIR_PASS(progress, nir, nir_opt_constant_folding);
+      NIR_PASS(progress, nir, nir_opt_undef);
+   } while (progress);
+}
+
 /* First half of converting glsl_to_nir.. this leaves things in a pre-
  * nir_lower_io state, so that shader variants can more easily insert/
  * replace variables, etc.
@@ -268,6 +291,12 @@ st_glsl_to_nir(struct st_context *st, struct gl_program *prog,
       }
    }
 
+   /* Optimize once here rather than in every variant, and keep the result
+    * in the disk cache so that the next run doesn't have to get here at all.
+    */
+   st_nir_opts(nir);
+   st_store_nir_in_disk_cache(st, prog);
+
    if (st->ctx->_Shader->Flags & GLSL_DUMP) {
       _mesa_log("\n");
       _mesa_log("NIR IR for linked %s program %d:\n",
@@ -26,8 +26,11 @@
 #include "st_program.h"
 #include "st_shader_cache.h"
 #include "compiler/glsl/program.h"
+#include "compiler/nir/nir_serialize.h"
+#include "pipe/p_screen.h"
 #include "pipe/p_shader_tokens.h"
 #include "program/ir_to_mesa.h"
+#include "program/prog_parameter.h"
 #include "util/u_memory.h"
 
 static void
@@ -138,6 +141,109 @@ st_store_tgsi_in_disk_cache(struct st_context *st, struct gl_program *prog,
    blob_destroy(blob);
 }
 
+/**
+ * Return true if the linked \p stage of a GLSL program is translated to NIR
+ * rather than TGSI.  This has to match what st_link_shader() does.
+ */
+static bool
+st_stage_uses_nir(struct pipe_screen *pscreen, gl_shader_stage stage)
+{
+   if (stage != MESA_SHADER_VERTEX && stage != MESA_SHADER_FRAGMENT)
+      return false;
+
+   return pscreen->get_shader_param(pscreen,
+                                    st_shader_stage_to_ptarget(stage),
+                                    PIPE_SHADER_CAP_PREFERRED_IR) ==
+          PIPE_SHADER_IR_NIR;
+}
+
+/**
+ * Store the optimized NIR of a GLSL program in the on-disk shader cache.
+ */
+void
+st_store_nir_in_disk_cache(struct st_context *st, struct gl_program *prog)
+{
+   if (!st->ctx->Cache)
+      return;
+
+   /* Exit early when we are dealing with a ff shader with no source file to
+    * generate a source from.
+    */
+   static const char zero[sizeof(prog->sh.data->sha1)] = {0};
+   if (memcmp(prog->sh.data->sha1, zero, sizeof(prog->sh.data->sha1)) == 0)
+      return;
+
+   unsigned char *sha1;
+
+   switch (prog->info.stage) {
+   case MESA_SHADER_VERTEX:
+      sha1 = ((struct st_vertex_program *) prog)->sha1;
+      break;
+   case MESA_SHADER_FRAGMENT:
+      sha1 = ((struct st_fragment_program *) prog)->sha1;
+      break;
+   default:
+      unreachable("Unsupported stage");
+   }
+
+   struct blob *blob = blob_create();
+   nir_serialize(blob, prog->nir);
+   disk_cache_put(st->ctx->Cache, sha1, blob->data, blob->size);
+
+   if (st->ctx->_Shader->Flags & GLSL_CACHE_INFO) {
+      char sha1_buf[41];
+      _mesa_sha1_format(sha1_buf, sha1);
+      fprintf(stderr, "putting %s nir in cache: %s (%zu bytes)\n",
+              _mesa_shader_stage_to_string(prog->info.stage), sha1_buf,
+              blob->size);
+   }
+
+   blob_destroy(blob);
+}
+
+static bool
+read_nir_from_cache(struct gl_context *ctx, struct gl_shader_program *prog,
+                    struct gl_program *glprog,
+                    struct blob_reader *blob_reader)
+{
+   struct st_context *st = st_context(ctx);
+   struct pipe_screen *pscreen = st->pipe->screen;
+   const nir_shader_compiler_options *options =
+      (const nir_shader_compiler_options *)
+      pscreen->get_compiler_options(pscreen, PIPE_SHADER_IR_NIR,
+                                    st_shader_stage_to_ptarget(glprog->info.stage));
+
+   nir_shader *nir = nir_deserialize(NULL, options, blob_reader);
+   if (!nir)
+      return false;
+
+   nir_validate_shader(nir);
+
+   /* glsl_to_nir() shares the shader info with the gl_program, and the
+    * program's copy has already been restored along with the metadata.
+    */
+   nir->info = &glprog->info;
+
+   ralloc_free(glprog->nir);
+   glprog->nir = nir;
+
+   /* The translate functions pick the NIR up from here, see
+    * st_glsl_to_nir().
+    */
+   switch (glprog->info.stage) {
+   case MESA_SHADER_VERTEX:
+      ((struct st_vertex_program *) glprog)->shader_program = prog;
+      break;
+   case MESA_SHADER_FRAGMENT:
+      ((struct st_fragment_program *) glprog)->shader_program = prog;
+      break;
+   default:
+      unreachable("Unsupported stage");
+   }
+
+   return true;
+}
+
 static void
 read_stream_out_from_cache(struct blob_reader *blob_reader,
                            struct pipe_shader_state *tgsi)
@@ -157,23 +263,27 @@ read_tgsi_from_cache(struct blob_reader *blob_reader,
 }
 
 bool
-st_load_tgsi_from_disk_cache(struct gl_context *ctx,
-                             struct gl_shader_program *prog)
+st_load_ir_from_disk_cache(struct gl_context *ctx,
+                           struct gl_shader_program *prog)
 {
    if (!ctx->Cache)
       return false;
 
+   struct pipe_screen *pscreen = st_context(ctx)->pipe->screen;
    unsigned char *stage_sha1[MESA_SHADER_STAGES];
+   bool stage_nir[MESA_SHADER_STAGES];
    char sha1_buf[41];
 
    /* Compute and store sha1 for each stage. These will be reused by the
-    * cache store pass if we fail to find the cached tgsi.
+    * cache store pass if we fail to find the cached IR.
     */
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
       if (prog->_LinkedShaders[i] == NULL)
          continue;
 
-      char *buf = ralloc_strdup(NULL, "tgsi_tokens ");
+      stage_nir[i] = st_stage_uses_nir(pscreen, (gl_shader_stage) i);
+
+      char *buf = ralloc_strdup(NULL, stage_nir[i] ? "nir " : "tgsi_tokens ");
       _mesa_sha1_format(sha1_buf,
                         prog->_LinkedShaders[i]->Program->sh.data->sha1);
       ralloc_strcat(&buf, sha1_buf);
@@ -261,6 +371,12 @@ st_load_tgsi_from_disk_cache(struct gl_context *ctx,
             struct st_vertex_program *stvp =
                (struct st_vertex_program *) glprog;
 
+            if (stage_nir[i]) {
+               if (!read_nir_from_cache(ctx, prog, glprog, &blob_reader))
+                  blob_reader.overrun = true;
+               break;
+            }
+
             st_release_vp_variants(st, stvp);
 
             stvp->num_inputs = blob_read_uint32(&blob_reader);
@@ -326,6 +442,12 @@ st_load_tgsi_from_disk_cache(struct gl_context *ctx,
             struct st_fragment_program *stfp =
                (struct st_fragment_program *) glprog;
 
+            if (stage_nir[i]) {
+               if (!read_nir_from_cache(ctx, prog, glprog, &blob_reader))
+                  blob_reader.overrun = true;
+               break;
+            }
+
             st_release_fp_variants(st, stfp);
 
             read_tgsi_from_cache(&blob_reader, &stfp->tgsi.tokens);
@@ -361,11 +483,11 @@ st_load_tgsi_from_disk_cache(struct gl_context *ctx,
             /* Something very bad has gone wrong discard the item from the
              * cache and rebuild/link from source.
              */
-            assert(!"Invalid TGSI shader disk cache item!");
+            assert(!"Invalid shader IR disk cache item!");
 
             if (ctx->_Shader->Flags & GLSL_CACHE_INFO) {
                fprintf(stderr, "Error reading program from cache (invalid "
-                       "TGSI cache item)\n");
+                       "%s cache item)\n", stage_nir[i] ? "NIR" : "TGSI");
             }
 
             disk_cache_remove(ctx->Cache, sha1);
@@ -375,21 +497,36 @@ st_load_tgsi_from_disk_cache(struct gl_context *ctx,
 
          if (ctx->_Shader->Flags & GLSL_CACHE_INFO) {
             _mesa_sha1_format(sha1_buf, sha1);
-            fprintf(stderr, "%s tgsi_tokens retrieved from cache: %s\n",
-                    _mesa_shader_stage_to_string(i), sha1_buf);
+            fprintf(stderr, "%s %s retrieved from cache: %s\n",
+                    _mesa_shader_stage_to_string(i),
+                    stage_nir[i] ? "nir" : "tgsi_tokens", sha1_buf);
          }
 
          st_set_prog_affected_state_flags(glprog);
+         if (stage_nir[i]) {
+            /* See st_nir_get_mesa_program(). */
+            _mesa_reserve_parameter_storage(glprog->Parameters, 8);
+         }
          _mesa_associate_uniform_storage(ctx, prog, glprog->Parameters,
                                          false);
 
          free(buffer);
+         buffer = NULL;
+
+         /* Unlike TGSI, the NIR still needs the input/output mapping
+          * and variants set up, which happens when translating the program.
+          */
+         if (stage_nir[i] &&
+             !ctx->Driver.ProgramStringNotify(ctx,
+                                              _mesa_shader_stage_to_program(i),
+                                              glprog))
+            goto fallback_recompile;
       } else {
          /* Failed to find a matching cached shader so fallback to recompile.
           */
          if (ctx->_Shader->Flags & GLSL_CACHE_INFO) {
-            fprintf(stderr, "TGSI cache item not found falling back to "
-                    "compile.\n");
+            fprintf(stderr, "%s cache item not found falling back to "
+                    "compile.\n", stage_nir[i] ? "NIR" : "TGSI");
          }
 
          goto fallback_recompile;
@@ -33,14 +33,17 @@ extern "C" {
 #endif
 
 bool
-st_load_tgsi_from_disk_cache(struct gl_context *ctx,
-                             struct gl_shader_program *prog);
+st_load_ir_from_disk_cache(struct gl_context *ctx,
+                           struct gl_shader_program *prog);
 
 void
 st_store_tgsi_in_disk_cache(struct st_context *st, struct gl_program *prog,
                             struct pipe_shader_state *out_state,
                             unsigned num_tokens);
 
+void
+st_store_nir_in_disk_cache(struct st_context *st, struct gl_program *prog);
+
 #ifdef __cplusplus
 }
 #endif
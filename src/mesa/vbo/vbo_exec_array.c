@@ -639,6 +639,28 @@ vbo_exec_DrawArraysInstancedBaseInstance(GLenum mode, GLint first,
 }
 
 
+/**
+ * Draw a batch of glMultiDrawArrays ranges, bounded by min_index and
+ * max_index.
+ */
+static void
+vbo_draw_multi_arrays(struct gl_context *ctx, struct _mesa_prim *prim,
+                      GLuint nr_prims, GLuint min_index, GLuint max_index)
+{
+   struct vbo_context *vbo = vbo_context(ctx);
+
+   prim[0].begin = 1;
+   prim[nr_prims - 1].end = 1;
+
+   vbo->draw_prims(ctx, prim, nr_prims, NULL,
+                   GL_TRUE, min_index, max_index, NULL, 0, NULL);
+
+   if (MESA_DEBUG_FLAGS & DEBUG_ALWAYS_FLUSH) {
+      _mesa_flush(ctx);
+   }
+}
+
+
 /**
  * Called from glMultiDrawArrays when in immediate mode.
  */
@@ -647,6 +669,10 @@ vbo_exec_MultiDrawArrays(GLenum mode, const GLint *first,
                          const GLsizei *count, GLsizei primcount)
 {
    GET_CURRENT_CONTEXT(ctx);
+   struct _mesa_prim *prim;
+   GLuint nr_prims = 0, batch_start = 0;
+   GLuint min_index = ~0u, max_index = 0;
+   GLboolean all_in_vbos;
    GLint i;
 
    if (MESA_VERBOSE & VERBOSE_DRAW)
@@ -657,11 +683,42 @@ vbo_exec_MultiDrawArrays(GLenum mode, const GLint *first,
    if (!_mesa_validate_MultiDrawArrays(ctx, mode, count, primcount))
       return;
 
+   if (primcount == 0)
+      return;
+
+   prim = calloc(primcount, sizeof(*prim));
+   if (prim == NULL) {
+      _mesa_error(ctx, GL_OUT_OF_MEMORY, "glMultiDrawArrays");
+      return;
+   }
+
+   vbo_bind_arrays(ctx);
+
+   /* Submit the draws together, so that the state is only validated once
+    * and the driver can batch them.  Drivers upload the vertices of user
+    * arrays between min_index and max_index, so when there are any, a
+    * range that is apart from the ones before it starts a new batch
+    * instead of having the vertices in between uploaded.
+    */
+   all_in_vbos = vbo_all_varyings_in_vbos(ctx->Array._DrawArrays);
+
    for (i = 0; i < primcount; i++) {
       if (count[i] > 0) {
+         const GLuint start = first[i], end = first[i] + count[i] - 1;
+
          if (0)
             check_draw_arrays_data(ctx, first[i], count[i]);
 
+         if (nr_prims > batch_start && !all_in_vbos &&
+             (start > max_index + 1 || end + 1 < min_index)) {
+            vbo_draw_multi_arrays(ctx, &prim[batch_start],
+                                  nr_prims - batch_start,
+                                  min_index, max_index);
+            batch_start = nr_prims;
+            min_index = ~0u;
+            max_index = 0;
+         }
+
          /* The GL_ARB_shader_draw_parameters spec adds the following after the
           * pseudo-code describing glMultiDrawArrays:
           *
@@ -669,12 +726,27 @@ vbo_exec_MultiDrawArrays(GLenum mode, const GLint *first,
           *     read by a vertex shader as <gl_DrawIDARB>, as described in
           *     Section 11.1.3.9."
           */
-         vbo_draw_arrays(ctx, mode, first[i], count[i], 1, 0, i);
+         prim[nr_prims].mode = mode;
+         prim[nr_prims].num_instances = 1;
+         prim[nr_prims].draw_id = i;
+         prim[nr_prims].start = first[i];
+         prim[nr_prims].count = count[i];
+         nr_prims++;
+
+         min_index = MIN2(min_index, start);
+         max_index = MAX2(max_index, end);
 
          if (0)
             print_draw_arrays(ctx, mode, first[i], count[i]);
       }
    }
+
+   if (nr_prims > batch_start) {
+      vbo_draw_multi_arrays(ctx, &prim[batch_start], nr_prims - batch_start,
+                            min_index, max_index);
+   }
+
+   free(prim);
 }
 
 
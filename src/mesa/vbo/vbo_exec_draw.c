@@ -244,7 +244,7 @@ vbo_exec_bind_arrays( struct gl_context *ctx )
             assert(exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Pointer);
             assert(offset >= 0);
             arrays[attr].Ptr = (GLubyte *)
-               exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Offset + offset;
+               (GLintptr) exec->vtx.buffer_used + offset;
          }
          else {
             /* Ptr into ordinary app memory */
@@ -280,16 +280,36 @@ vbo_exec_bind_arrays( struct gl_context *ctx )
 }
 
 
+/**
+ * Whether the VBO is mapped with GL_MAP_PERSISTENT_BIT, in which case it
+ * stays mapped across flushes.
+ */
+static bool
+vbo_exec_vtx_mapped_persistent(const struct vbo_exec_context *exec)
+{
+   return exec->vtx.buffer_map &&
+          (exec->vtx.bufferobj->Mappings[MAP_INTERNAL].AccessFlags &
+           GL_MAP_PERSISTENT_BIT);
+}
+
+
 /**
  * Unmap the VBO.  This is called before drawing.
+ *
+ * A persistent mapping is kept, the vertices written to it are already
+ * visible to the GPU.  Only the start of the buffer space for the next
+ * vertices moves.
  */
 static void
 vbo_exec_vtx_unmap( struct vbo_exec_context *exec )
 {
    if (_mesa_is_bufferobj(exec->vtx.bufferobj)) {
       struct gl_context *ctx = exec->ctx;
+      const GLbitfield access =
+         exec->vtx.bufferobj->Mappings[MAP_INTERNAL].AccessFlags;
 
-      if (ctx->Driver.FlushMappedBufferRange) {
+      if (ctx->Driver.FlushMappedBufferRange &&
+          (access & GL_MAP_FLUSH_EXPLICIT_BIT)) {
          GLintptr offset = exec->vtx.buffer_used -
                            exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Offset;
          GLsizeiptr length = (exec->vtx.buffer_ptr - exec->vtx.buffer_map) *
@@ -307,6 +327,11 @@ vbo_exec_vtx_unmap( struct vbo_exec_context *exec )
       assert(exec->vtx.buffer_used <= VBO_VERT_BUFFER_SIZE);
       assert(exec->vtx.buffer_ptr != NULL);
 
+      if (vbo_exec_vtx_mapped_persistent(exec)) {
+         exec->vtx.buffer_map = exec->vtx.buffer_ptr;
+         return;
+      }
+
       ctx->Driver.UnmapBuffer(ctx, exec->vtx.bufferobj, MAP_INTERNAL);
       exec->vtx.buffer_map = NULL;
       exec->vtx.buffer_ptr = NULL;
@@ -317,27 +342,57 @@ vbo_exec_vtx_unmap( struct vbo_exec_context *exec )
 
 /**
  * Map the vertex buffer to begin storing glVertex, glColor, etc data.
+ *
+ * If the driver supports persistent mappings, the buffer stays mapped
+ * and the vertices of successive flushes are packed one after the other,
+ * so we only get here to map it again when it's full.  The full buffer
+ * is then orphaned, and the driver keeps its old storage around until
+ * the GPU is done with it.
  */
 void
 vbo_exec_vtx_map( struct vbo_exec_context *exec )
 {
    struct gl_context *ctx = exec->ctx;
-   const GLenum accessRange = GL_MAP_WRITE_BIT |  /* for MapBufferRange */
-                              GL_MAP_INVALIDATE_RANGE_BIT |
-                              GL_MAP_UNSYNCHRONIZED_BIT |
-                              GL_MAP_FLUSH_EXPLICIT_BIT |
-                              MESA_MAP_NOWAIT_BIT;
+   const bool persistent = ctx->Extensions.ARB_buffer_storage;
+   GLenum accessRange = GL_MAP_WRITE_BIT |  /* for MapBufferRange */
+                        GL_MAP_UNSYNCHRONIZED_BIT;
+   GLbitfield storageFlags = GL_MAP_WRITE_BIT |
+                             GL_DYNAMIC_STORAGE_BIT |
+                             GL_CLIENT_STORAGE_BIT;
    const GLenum usage = GL_STREAM_DRAW_ARB;
 
    if (!_mesa_is_bufferobj(exec->vtx.bufferobj))
       return;
 
-   assert(!exec->vtx.buffer_map);
+   if (persistent) {
+      accessRange |= GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+      storageFlags |= GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+   }
+   else {
+      accessRange |= GL_MAP_INVALIDATE_RANGE_BIT |
+                     GL_MAP_FLUSH_EXPLICIT_BIT |
+                     MESA_MAP_NOWAIT_BIT;
+   }
+
+   if (exec->vtx.buffer_map) {
+      /* Only persistent mappings are kept around. */
+      assert(vbo_exec_vtx_mapped_persistent(exec));
+
+      if (VBO_VERT_BUFFER_SIZE > exec->vtx.buffer_used + 1024)
+         return;
+
+      ctx->Driver.UnmapBuffer(ctx, exec->vtx.bufferobj, MAP_INTERNAL);
+      exec->vtx.buffer_map = NULL;
+      exec->vtx.buffer_ptr = NULL;
+   }
+
    assert(!exec->vtx.buffer_ptr);
 
    if (VBO_VERT_BUFFER_SIZE > exec->vtx.buffer_used + 1024) {
       /* The VBO exists and there's room for more */
-      if (exec->vtx.bufferobj->Size > 0) {
+      if (exec->vtx.bufferobj->Size > 0 &&
+          (exec->vtx.bufferobj->StorageFlags & GL_MAP_PERSISTENT_BIT) ==
+          (storageFlags & GL_MAP_PERSISTENT_BIT)) {
          exec->vtx.buffer_map =
             (fi_type *)ctx->Driver.MapBufferRange(ctx,
                                                   exec->vtx.buffer_used,
@@ -360,9 +415,7 @@ vbo_exec_vtx_map( struct vbo_exec_context *exec )
       if (ctx->Driver.BufferData(ctx, GL_ARRAY_BUFFER_ARB,
                                  VBO_VERT_BUFFER_SIZE,
                                  NULL, usage,
-                                 GL_MAP_WRITE_BIT |
-                                 GL_DYNAMIC_STORAGE_BIT |
-                                 GL_CLIENT_STORAGE_BIT,
+                                 storageFlags,
                                  exec->vtx.bufferobj)) {
          /* buffer allocation worked, now map the buffer */
          exec->vtx.buffer_map =
@@ -441,15 +494,18 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
 				       exec->vtx.vert_count - 1,
 				       NULL, 0, NULL);
 
-         /* Get new storage -- unless asked not to. */
-         if (!keepUnmapped)
+         /* Get new storage -- unless asked not to.  A persistent mapping
+          * is kept anyway, but it may need to move to a new buffer.
+          */
+         if (!keepUnmapped || vbo_exec_vtx_mapped_persistent(exec))
             vbo_exec_vtx_map( exec );
       }
    }
 
    /* May have to unmap explicitly if we didn't draw:
     */
-   if (keepUnmapped && exec->vtx.buffer_map) {
+   if (keepUnmapped && exec->vtx.buffer_map &&
+       !vbo_exec_vtx_mapped_persistent(exec)) {
       vbo_exec_vtx_unmap( exec );
    }
 
@@ -479,7 +479,13 @@ _save_compile_vertex_list(struct gl_context *ctx)
 
    assert(node->attrsz[VBO_ATTRIB_POS] != 0 || node->count == 0);
 
-   if (save->dangling_attr_ref)
+   /* A node with dangling references is replayed with loopback.  If it
+    * holds whole glBegin/End pairs, this can be done for the node on its
+    * own.  Otherwise it continues or is continued by other nodes and the
+    * whole list has to go through loopback.
+    */
+   if (save->dangling_attr_ref &&
+       !(node->prim[0].begin && node->prim[node->prim_count - 1].end))
       ctx->ListState.CurrentList->Flags |= DLIST_DANGLING_REFS;
 
    save->vertex_store->used += save->vertex_size * node->count;
@@ -280,7 +280,7 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data)
                      "draw operation inside glBegin/End");
          goto end;
       }
-      else if (save->replay_flags) {
+      else if (save->replay_flags || node->dangling_attr_ref) {
 	 /* Various degenerate cases: translate into immediate mode
 	  * calls rather than trying to execute in place.
 	  */
@@ -27,11 +27,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
-
-/* Android defines SIZE_MAX in limits.h, instead of the standard stdint.h */
-#ifdef ANDROID
-#include <limits.h>
-#endif
+#include <limits.h> /* Android defines SIZE_MAX here, instead of stdint.h */
 
 /* Some versions of MinGW are missing _vscprintf's declaration, although they
  * still provide the symbol in the import library. */
@@ -81,12 +77,25 @@ struct
    struct ralloc_header *next;
 
    void (*destructor)(void *);
+
+   /* The arena children of this node are carved out of, if any. */
+   struct ralloc_arena *arena;
 };
 
 typedef struct ralloc_header ralloc_header;
 
 static void unlink_block(ralloc_header *info);
-static void unsafe_free(ralloc_header *info);
+static void unsafe_free(const ralloc_header *parent, ralloc_header *info);
+static bool arena_takes(const struct ralloc_arena *arena, size_t size);
+static void *arena_alloc(struct ralloc_arena *arena, size_t size);
+static ralloc_header *arena_resize(ralloc_header *old, size_t size);
+static void arena_free(const ralloc_header *parent, ralloc_header *info);
+static void arena_reparented(ralloc_header *info,
+                             const ralloc_header *old_parent);
+static void arena_owner_moved(struct ralloc_arena *arena,
+                              const ralloc_header *old, ralloc_header *info);
+static void arena_begin_free(struct ralloc_arena *arena);
+
 
 static ralloc_header *
 get_header(const void *ptr)
@@ -101,6 +110,12 @@ get_header(const void *ptr)
 
 #define PTR_FROM_HEADER(info) (((char *) info) + sizeof(ralloc_header))
 
+/* Whether the memory of a node comes from an arena.  The node owning the
+ * arena is itself malloc'd.
+ */
+static inline bool
+is_arena_node(const ralloc_header *info);
+
 static void
 add_child(ralloc_header *parent, ralloc_header *info)
 {
@@ -123,9 +138,18 @@ ralloc_context(const void *ctx)
 void *
 ralloc_size(const void *ctx, size_t size)
 {
-   void *block = malloc(size + sizeof(ralloc_header));
+   ralloc_header *parent = ctx != NULL ? get_header(ctx) : NULL;
+   struct ralloc_arena *arena = parent != NULL ? parent->arena : NULL;
+   void *block;
    ralloc_header *info;
-   ralloc_header *parent;
+
+   if (arena != NULL && !arena_takes(arena, size + sizeof(ralloc_header)))
+      arena = NULL;
+
+   if (arena != NULL)
+      block = arena_alloc(arena, size + sizeof(ralloc_header));
+   else
+      block = malloc(size + sizeof(ralloc_header));
 
    if (unlikely(block == NULL))
       return NULL;
@@ -140,8 +164,7 @@ ralloc_size(const void *ctx, size_t size)
    info->prev = NULL;
    info->next = NULL;
    info->destructor = NULL;
-
-   parent = ctx != NULL ? get_header(ctx) : NULL;
+   info->arena = arena;
 
    add_child(parent, info);
 
@@ -170,11 +193,18 @@ resize(void *ptr, size_t size)
    ralloc_header *child, *old, *info;
 
    old = get_header(ptr);
-   info = realloc(old, size + sizeof(ralloc_header));
+   if (is_arena_node(old))
+      info = arena_resize(old, size + sizeof(ralloc_header));
+   else
+      info = realloc(old, size + sizeof(ralloc_header));
 
    if (info == NULL)
       return NULL;
 
+   /* An arena owner may move as well. */
+   if (info != old && info->arena != NULL)
+      arena_owner_moved(info->arena, old, info);
+
    /* Update parent and sibling's links to the reallocated node. */
    if (info != old && info->parent != NULL) {
       if (info->parent->child == old)
@@ -234,14 +264,15 @@ reralloc_array_size(const void *ctx, void *ptr, size_t size, unsigned count)
 void
 ralloc_free(void *ptr)
 {
-   ralloc_header *info;
+   ralloc_header *info, *parent;
 
    if (ptr == NULL)
       return;
 
    info = get_header(ptr);
+   parent = info->parent;
    unlink_block(info);
-   unsafe_free(info);
+   unsafe_free(parent, info);
 }
 
 static void
@@ -264,37 +295,49 @@ unlink_block(ralloc_header *info)
 }
 
 static void
-unsafe_free(ralloc_header *info)
+unsafe_free(const ralloc_header *parent, ralloc_header *info)
 {
    /* Recursively free any children...don't waste time unlinking them. */
    ralloc_header *temp;
+
+   if (info->arena != NULL && !is_arena_node(info))
+      arena_begin_free(info->arena);
+
    while (info->child != NULL) {
       temp = info->child;
       info->child = temp->next;
-      unsafe_free(temp);
+      unsafe_free(info, temp);
    }
 
    /* Free the block itself.  Call the destructor first, if any. */
    if (info->destructor != NULL)
       info->destructor(PTR_FROM_HEADER(info));
 
-   free(info);
+   /* Arena nodes go away together with their arena. */
+   if (info->arena != NULL)
+      arena_free(parent, info);
+   else
+      free(info);
 }
 
 void
 ralloc_steal(const void *new_ctx, void *ptr)
 {
-   ralloc_header *info, *parent;
+   ralloc_header *info, *parent, *old_parent;
 
    if (unlikely(ptr == NULL))
       return;
 
    info = get_header(ptr);
    parent = get_header(new_ctx);
+   old_parent = info->parent;
 
    unlink_block(info);
 
    add_child(parent, info);
+
+   if (info->arena != NULL)
+      arena_reparented(info, old_parent);
 }
 
 void
@@ -315,11 +358,15 @@ ralloc_adopt(const void *new_ctx, void *old_ctx)
    /* Set all the children's parent to new_ctx; get a pointer to the last child. */
    for (child = old_info->child; child->next != NULL; child = child->next) {
       child->parent = new_info;
+      if (child->arena != NULL)
+         arena_reparented(child, old_info);
    }
 
    /* Connect the two lists together; parent them to new_ctx; make old_ctx empty. */
    child->next = new_info->child;
    child->parent = new_info;
+   if (child->arena != NULL)
+      arena_reparented(child, old_info);
    new_info->child = old_info->child;
    old_info->child = NULL;
 }
@@ -610,24 +657,38 @@ create_linear_node(void *ralloc_ctx, unsigned min_size)
    return node;
 }
 
-void *
-linear_alloc_child(void *parent, unsigned size)
+/* The number of bytes to skip at the current offset of a buffer so that the
+ * suballocation after the next linear_size_chunk is aligned to align.
+ */
+static inline unsigned
+linear_padding(const linear_header *node, unsigned align)
+{
+   uintptr_t ptr = (uintptr_t) &node[1] + node->offset +
+                   sizeof(linear_size_chunk);
+
+   return -ptr & (align - 1);
+}
+
+static inline void *
+linear_alloc_child_aligned(void *parent, unsigned size, unsigned align)
 {
    linear_header *first = LINEAR_PARENT_TO_HEADER(parent);
    linear_header *latest = first->latest;
    linear_header *new_node;
    linear_size_chunk *ptr;
-   unsigned full_size;
+   unsigned padding, full_size;
 
    assert(first->magic == LMAGIC);
    assert(!latest->next);
 
-   size = ALIGN_POT(size, SUBALLOC_ALIGNMENT);
-   full_size = sizeof(linear_size_chunk) + size;
+   size = ALIGN_POT(size, align);
+   padding = linear_padding(latest, align);
+   full_size = padding + sizeof(linear_size_chunk) + size;
 
    if (unlikely(latest->offset + full_size > latest->size)) {
-      /* allocate a new node */
-      new_node = create_linear_node(latest->ralloc_parent, size);
+      /* allocate a new node, with room for the padding */
+      new_node = create_linear_node(latest->ralloc_parent,
+                                    size + align - SUBALLOC_ALIGNMENT);
       if (unlikely(!new_node))
          return NULL;
 
@@ -635,14 +696,23 @@ linear_alloc_child(void *parent, unsigned size)
       latest->latest = new_node;
       latest->next = new_node;
       latest = new_node;
+
+      padding = linear_padding(latest, align);
+      full_size = padding + sizeof(linear_size_chunk) + size;
    }
 
-   ptr = (linear_size_chunk *)((char*)&latest[1] + latest->offset);
+   ptr = (linear_size_chunk *)((char*)&latest[1] + latest->offset + padding);
    ptr->size = size;
    latest->offset += full_size;
    return &ptr[1];
 }
 
+void *
+linear_alloc_child(void *parent, unsigned size)
+{
+   return linear_alloc_child_aligned(parent, size, SUBALLOC_ALIGNMENT);
+}
+
 void *
 linear_alloc_parent(void *ralloc_ctx, unsigned size)
 {
@@ -876,3 +946,273 @@ linear_strcat(void *parent, char **dest, const char *str)
 {
    return linear_cat(parent, dest, str, strlen(str));
 }
+
+/***************************************************************************
+ * Arena and pool contexts.
+ ***************************************************************************
+ *
+ * Every descendant of an arena's owner is carved out of a linear buffer
+ * owned by the arena.  Those descendants are complete ralloc nodes, so
+ * ralloc_parent, ralloc_steal and destructors keep working, but freeing one
+ * only unlinks it and runs destructors.  The buffers are released when the
+ * owner is freed, after all of its children.
+ *
+ * Arena nodes can be stolen to a parent outside of the arena, like the
+ * dead_ctx of some NIR passes.  Each such subtree holds a reference on the
+ * arena, which keeps the buffers alive until the subtree is freed as well.
+ *
+ * A pool is an arena that also keeps the blocks of freed nodes on free
+ * lists, one per POOL_GRANULARITY-sized class, and hands them out again.
+ */
+
+/* Arena blocks start with a ralloc_header, so they need the same alignment
+ * as malloc'd ones.  The pool size classes are multiples of this as well.
+ */
+#define ARENA_ALIGNMENT  16
+
+#define POOL_GRANULARITY ARENA_ALIGNMENT
+#define POOL_CLASSES     64
+
+struct ralloc_arena {
+   ralloc_header *owner; /* node whose descendants live in the arena */
+   void *buffers;        /* ralloc context owning the linear buffers */
+   void *linear;         /* linear parent the nodes are allocated from */
+   size_t size;          /* bytes carved out of the buffers so far */
+   unsigned refs;        /* the owner, plus subtrees stolen out of it */
+   bool is_pool;
+   bool freeing;         /* the owner is being freed */
+   void *free_list[POOL_CLASSES];
+};
+
+static inline bool
+is_arena_node(const ralloc_header *info)
+{
+   return info->arena != NULL && info->arena->owner != info;
+}
+
+static bool
+arena_create(const void *ctx, bool is_pool)
+{
+   ralloc_header *info = get_header(ctx);
+   struct ralloc_arena *arena;
+
+   /* The owner's own memory must not come from another arena. */
+   if (info->arena != NULL)
+      return false;
+
+   arena = calloc(1, sizeof(struct ralloc_arena));
+   if (unlikely(arena == NULL))
+      return false;
+
+   arena->buffers = ralloc_context(NULL);
+   arena->linear = arena->buffers ?
+      linear_alloc_parent(arena->buffers, 0) : NULL;
+   if (unlikely(arena->linear == NULL)) {
+      ralloc_free(arena->buffers);
+      free(arena);
+      return false;
+   }
+
+   arena->owner = info;
+   arena->refs = 1;
+   arena->is_pool = is_pool;
+   info->arena = arena;
+   return true;
+}
+
+void *
+ralloc_arena_context(const void *ctx)
+{
+   void *arena_ctx = ralloc_context(NULL);
+
+   if (unlikely(arena_ctx == NULL))
+      return NULL;
+
+   if (unlikely(!arena_create(arena_ctx, false))) {
+      ralloc_free(arena_ctx);
+      return NULL;
+   }
+
+   /* The arena context is malloc'd even if ctx lives in an arena itself. */
+   if (ctx != NULL)
+      add_child(get_header(ctx), get_header(arena_ctx));
+
+   return arena_ctx;
+}
+
+bool
+ralloc_enable_pool(void *ctx)
+{
+   return arena_create(ctx, true);
+}
+
+size_t
+ralloc_arena_size(const void *ctx)
+{
+   ralloc_header *info = get_header(ctx);
+
+   assert(info->arena != NULL && info->arena->owner == info);
+   return info->arena->size;
+}
+
+static void
+arena_owner_moved(struct ralloc_arena *arena,
+                  const ralloc_header *old, ralloc_header *info)
+{
+   if (arena->owner == old)
+      arena->owner = info;
+}
+
+static void
+arena_begin_free(struct ralloc_arena *arena)
+{
+   arena->freeing = true;
+}
+
+static void
+arena_unref(struct ralloc_arena *arena)
+{
+   assert(arena->refs > 0);
+   if (--arena->refs == 0) {
+      ralloc_free(arena->buffers);
+      free(arena);
+   }
+}
+
+/* Whether the arena node info is the root of a subtree outside of its arena
+ * when its parent is parent.
+ */
+static inline bool
+arena_node_outside(const ralloc_header *info, const ralloc_header *parent)
+{
+   return parent == NULL || parent->arena != info->arena;
+}
+
+static void
+arena_reparented(ralloc_header *info, const ralloc_header *old_parent)
+{
+   bool was_outside, is_outside;
+
+   if (!is_arena_node(info))
+      return;
+
+   was_outside = arena_node_outside(info, old_parent);
+   is_outside = arena_node_outside(info, info->parent);
+
+   if (is_outside && !was_outside)
+      info->arena->refs++;
+   else if (was_outside && !is_outside)
+      arena_unref(info->arena);
+}
+
+/* The size of a block carved out of the linear buffers. */
+static unsigned
+arena_block_size(const void *block)
+{
+   return ((const linear_size_chunk *) block)[-1].size;
+}
+
+/* Large blocks are rarely the same size twice, so pools leave them to
+ * malloc rather than carving out memory they could never hand out again.
+ */
+static bool
+arena_takes(const struct ralloc_arena *arena, size_t size)
+{
+   return !arena->is_pool || size <= POOL_GRANULARITY * POOL_CLASSES;
+}
+
+static void *
+arena_alloc(struct ralloc_arena *arena, size_t size)
+{
+   if (unlikely(size > UINT_MAX - ARENA_ALIGNMENT))
+      return NULL;
+
+   size = ALIGN_POT(size, ARENA_ALIGNMENT);
+
+   if (arena->is_pool) {
+      unsigned class = size / POOL_GRANULARITY - 1;
+      void *block = arena->free_list[class];
+
+      if (block != NULL) {
+         arena->free_list[class] = *(void **) block;
+         return block;
+      }
+
+   }
+
+   arena->size += size;
+   return linear_alloc_child_aligned(arena->linear, size, ARENA_ALIGNMENT);
+}
+
+static void
+arena_free_block(struct ralloc_arena *arena, void *block)
+{
+   unsigned size = arena_block_size(block);
+
+   if (arena->is_pool) {
+      unsigned class = (size - 1) / POOL_GRANULARITY;
+
+      assert(size % POOL_GRANULARITY == 0 && class < POOL_CLASSES);
+      *(void **) block = arena->free_list[class];
+      arena->free_list[class] = block;
+   }
+}
+
+static ralloc_header *
+arena_resize(ralloc_header *old, size_t size)
+{
+   struct ralloc_arena *arena = old->arena;
+   unsigned old_size = arena_block_size(old);
+   ralloc_header *info;
+
+   if (size <= old_size)
+      return old;
+
+   if (arena_takes(arena, size)) {
+      info = arena_alloc(arena, size);
+   } else {
+      info = malloc(size);
+      if (likely(info != NULL))
+         old->arena = NULL;
+   }
+   if (unlikely(info == NULL))
+      return NULL;
+
+   memcpy(info, old, old_size);
+   arena_free_block(arena, old);
+
+   /* A node that moved to malloc no longer pins the arena, but its arena
+    * children are now outside of it.
+    */
+   if (info->arena == NULL) {
+      ralloc_header *child;
+
+      for (child = info->child; child != NULL; child = child->next) {
+         if (child->arena == arena)
+            arena->refs++;
+      }
+      if (info->parent == NULL || info->parent->arena != arena)
+         arena_unref(arena);
+   }
+
+   return info;
+}
+
+static void
+arena_free(const ralloc_header *parent, ralloc_header *info)
+{
+   struct ralloc_arena *arena = info->arena;
+
+   if (is_arena_node(info)) {
+      /* There is no point in recycling blocks of a dying arena. */
+      if (!arena->freeing)
+         arena_free_block(arena, info);
+      if (arena_node_outside(info, parent))
+         arena_unref(arena);
+      return;
+   }
+
+   arena->owner = NULL;
+   free(info);
+   arena_unref(arena);
+}
@@ -91,6 +91,39 @@ extern "C" {
  */
 void *ralloc_context(const void *ctx);
 
+/**
+ * Allocate a new arena context.
+ *
+ * Everything allocated beneath an arena context, directly or through other
+ * nodes, is carved out of a few large buffers instead of being malloc'd one
+ * block at a time.  Those allocations behave like any other ralloc node,
+ * except that freeing one only runs destructors: the memory is returned in
+ * bulk when the arena context itself is freed.  Allocations stolen to a
+ * context outside of the arena keep its memory alive until they are freed.
+ */
+void *ralloc_arena_context(const void *ctx);
+
+/**
+ * Turn an existing context into the owner of a pool.
+ *
+ * A pool is an arena whose freed blocks are kept on free lists and reused by
+ * later allocations of a similar size, which suits contexts that see a lot
+ * of churn, like a shader being optimized.  Only allocations made beneath
+ * \p ctx after this call come from the pool.  The same lifetime rule as for
+ * arena contexts applies.
+ *
+ * Returns false, leaving \p ctx as it was, if \p ctx itself was allocated
+ * from an arena or pool, or if the pool could not be created.
+ */
+bool ralloc_enable_pool(void *ctx);
+
+/**
+ * Return the number of bytes carved out of an arena or pool so far.
+ *
+ * Arena memory is never reused, so this is also the arena's high-water mark.
+ */
+size_t ralloc_arena_size(const void *ctx);
+
 /**
  * Allocate memory chained off of the given context.
  *
@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Force assertions, even on release builds. */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "ralloc.h"
+
+static int destroyed;
+
+static void
+destructor(void *ptr)
+{
+   (void) ptr;
+   destroyed++;
+}
+
+int
+main(int argc, char **argv)
+{
+   void *parent, *arena;
+   char *nodes[64];
+
+   (void) argc;
+   (void) argv;
+
+   parent = ralloc_context(NULL);
+   arena = ralloc_arena_context(parent);
+   assert(ralloc_parent(arena) == parent);
+
+   for (unsigned i = 0; i < 64; i++) {
+      nodes[i] = ralloc_size(i ? nodes[i / 2] : arena, 16 + i);
+      ralloc_set_destructor(nodes[i], destructor);
+   }
+
+   /* nodes[i] hangs off nodes[i / 2], so freeing nodes[2] runs the
+    * destructors of the 31 nodes of its subtree and no others.
+    */
+   ralloc_free(nodes[2]);
+   assert(destroyed == 31);
+   memset(nodes[3], 0, 16 + 3);
+
+   ralloc_free(nodes[3]);
+   assert(destroyed == 62);
+
+   /* Freeing the arena's parent frees the arena with everything in it. */
+   ralloc_free(parent);
+   assert(destroyed == 64);
+
+   return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Force assertions, even on release builds. */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "ralloc.h"
+
+#define ALIGNED(p) (((uintptr_t) (p) & 15) == 0)
+
+static void
+check_fill(const unsigned char *p, unsigned char c, size_t size)
+{
+   for (size_t i = 0; i < size; i++)
+      assert(p[i] == c);
+}
+
+int
+main(int argc, char **argv)
+{
+   void *arena;
+   unsigned char *p, *child;
+   size_t before;
+
+   (void) argc;
+   (void) argv;
+
+   arena = ralloc_arena_context(NULL);
+   assert(arena && ALIGNED(arena));
+   assert(ralloc_arena_size(arena) == 0);
+
+   /* Every size, directly under the arena and one level further down. */
+   for (size_t size = 1; size < 100; size++) {
+      p = ralloc_size(arena, size);
+      assert(ALIGNED(p));
+      memset(p, 0xaa, size);
+      child = ralloc_size(p, size);
+      assert(ALIGNED(child));
+      memset(child, 0x55, size);
+      check_fill(p, 0xaa, size);
+   }
+   assert(ralloc_arena_size(arena) > 0);
+
+   /* Growing an allocation keeps its contents, whether or not it moves,
+    * and the arena only ever grows.
+    */
+   p = ralloc_size(arena, 8);
+   memset(p, 0x11, 8);
+   for (size_t size = 16; size <= 64 * 1024; size *= 2) {
+      before = ralloc_arena_size(arena);
+      p = reralloc_size(arena, p, size);
+      assert(p && ALIGNED(p));
+      check_fill(p, 0x11, size / 2);
+      memset(p, 0x11, size);
+      assert(ralloc_arena_size(arena) >= before);
+   }
+
+   /* Shrinking keeps the prefix. */
+   p = reralloc_size(arena, p, 5);
+   assert(ALIGNED(p));
+   check_fill(p, 0x11, 5);
+
+   /* Allocations bigger than an arena buffer. */
+   p = ralloc_size(arena, 1024 * 1024);
+   assert(ALIGNED(p));
+   memset(p, 0x22, 1024 * 1024);
+
+   /* Many small reallocs interleaved with other allocations. */
+   for (unsigned i = 0; i < 5000; i++) {
+      size_t size = (i * 37) % 3000 + 1;
+
+      p = ralloc_size(arena, size);
+      assert(ALIGNED(p));
+      memset(p, i & 0xff, size);
+      p = reralloc_size(arena, p, size + 100);
+      assert(ALIGNED(p));
+      check_fill(p, i & 0xff, size);
+   }
+
+   ralloc_free(arena);
+
+   return 0;
+}
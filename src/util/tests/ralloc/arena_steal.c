@@ -0,0 +1,95 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Force assertions, even on release builds. */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "ralloc.h"
+
+static int destroyed;
+
+static void
+destructor(void *ptr)
+{
+   (void) ptr;
+   destroyed++;
+}
+
+int
+main(int argc, char **argv)
+{
+   void *arena, *ctx;
+   char *node, *child, *outside;
+
+   (void) argc;
+   (void) argv;
+
+   arena = ralloc_arena_context(NULL);
+   ctx = ralloc_context(NULL);
+
+   /* Steal a node and its child out of the arena, then free the arena.
+    * Both must stay usable and keep their destructors.
+    */
+   node = ralloc_size(arena, 32);
+   child = ralloc_size(node, 24);
+   ralloc_set_destructor(child, destructor);
+   memset(child, 7, 24);
+   ralloc_steal(ctx, node);
+   assert(ralloc_parent(node) == ctx);
+   assert(ralloc_parent(child) == node);
+
+   /* Anything allocated under the stolen node comes from the arena too. */
+   char *late = ralloc_size(node, 16);
+   assert(((uintptr_t) late & 15) == 0);
+
+   ralloc_free(arena);
+   assert(destroyed == 0);
+   memset(node, 1, 32);
+   memset(late, 2, 16);
+   assert(child[23] == 7);
+
+   /* Steal a malloc'd node into a new arena, and one back and forth. */
+   arena = ralloc_arena_context(NULL);
+   outside = ralloc_size(ctx, 64);
+   ralloc_set_destructor(outside, destructor);
+   ralloc_steal(arena, outside);
+   assert(ralloc_parent(outside) == arena);
+
+   node = ralloc_size(arena, 10);
+   ralloc_steal(ctx, node);
+   ralloc_steal(arena, node);
+   ralloc_steal(ctx, node);
+   assert(ralloc_parent(node) == ctx);
+
+   ralloc_free(arena);
+   assert(destroyed == 1);
+   memset(node, 0, 10);
+
+   ralloc_free(ctx);
+   assert(destroyed == 2);
+
+   return 0;
+}
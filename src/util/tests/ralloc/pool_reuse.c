@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Force assertions, even on release builds. */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "ralloc.h"
+
+
+#define ALIGNED(p) (((uintptr_t) (p) & 15) == 0)
+
+int
+main(int argc, char **argv)
+{
+   void *ctx, *inner;
+   void *ptrs[1000];
+   size_t size;
+
+   (void) argc;
+   (void) argv;
+
+   ctx = ralloc_context(NULL);
+   assert(ralloc_enable_pool(ctx));
+
+   /* Pools can't be nested, or enabled on a node inside an arena. */
+   inner = ralloc_context(ctx);
+   assert(!ralloc_enable_pool(inner));
+
+   /* Allocate and free the same mix of sizes over and over: once the free
+    * lists are populated, the pool must stop growing.
+    */
+   for (unsigned round = 0; round < 50; round++) {
+      for (unsigned i = 0; i < 1000; i++) {
+         ptrs[i] = ralloc_size(ctx, (i * 13) % 1100 + 1);
+         assert(ALIGNED(ptrs[i]));
+         memset(ptrs[i], i & 0xff, (i * 13) % 1100 + 1);
+      }
+      for (unsigned i = 0; i < 1000; i++)
+         ralloc_free(ptrs[i]);
+
+      if (round == 0)
+         size = ralloc_arena_size(ctx);
+      else
+         assert(ralloc_arena_size(ctx) == size);
+   }
+
+   /* Growing a pool node through the free lists keeps its contents. */
+   unsigned char *p = ralloc_size(ctx, 1);
+   p[0] = 0x42;
+   for (size_t s = 2; s <= 4096; s++) {
+      p = reralloc_size(ctx, p, s);
+      assert(ALIGNED(p));
+      for (size_t i = 0; i < s - 1; i++)
+         assert(p[i] == 0x42);
+      p[s - 1] = 0x42;
+   }
+
+   ralloc_free(ctx);
+
+   return 0;
+}
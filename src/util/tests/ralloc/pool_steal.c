@@ -0,0 +1,103 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Force assertions, even on release builds. */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "ralloc.h"
+
+
+static int destroyed;
+
+static void
+destructor(void *ptr)
+{
+   (void) ptr;
+   destroyed++;
+}
+
+int
+main(int argc, char **argv)
+{
+   void *shader, *other, *rubbish;
+   char *node, *child, *big;
+   void *live[50];
+
+   (void) argc;
+   (void) argv;
+
+   /* Steal every other node out of the pool, then free the pool owner
+    * first: the stolen nodes and their children must survive it.
+    */
+   shader = ralloc_context(NULL);
+   assert(ralloc_enable_pool(shader));
+   other = ralloc_context(NULL);
+   for (unsigned i = 0; i < 100; i++) {
+      node = ralloc_size(shader, 40);
+      child = ralloc_size(node, 24);
+      ralloc_set_destructor(child, destructor);
+      memset(child, 7, 24);
+      if (i & 1)
+         ralloc_steal(other, node);
+   }
+   ralloc_free(shader);
+   assert(destroyed == 50);
+   ralloc_free(other);
+   assert(destroyed == 100);
+
+   /* The nir_sweep pattern: move everything to a rubbish context, steal
+    * the live nodes back and free the rest.
+    */
+   shader = ralloc_context(NULL);
+   assert(ralloc_enable_pool(shader));
+   for (unsigned round = 0; round < 20; round++) {
+      for (unsigned i = 0; i < 50; i++) {
+         live[i] = ralloc_size(shader, 64);
+         ralloc_set_destructor(ralloc_size(shader, 32), destructor);
+      }
+      rubbish = ralloc_context(NULL);
+      ralloc_adopt(rubbish, shader);
+      for (unsigned i = 0; i < 50; i++)
+         ralloc_steal(shader, live[i]);
+      ralloc_free(rubbish);
+      assert(destroyed == 100 + 50 * (round + 1));
+   }
+
+   /* A node reallocated out of the pool's size classes, with a pool child
+    * stolen away from it.
+    */
+   big = ralloc_size(shader, 16);
+   child = ralloc_size(big, 16);
+   big = reralloc_size(shader, big, 5000);
+   memset(big, 3, 5000);
+   other = ralloc_context(NULL);
+   ralloc_steal(other, child);
+   ralloc_free(shader);
+   memset(child, 1, 16);
+   ralloc_free(other);
+
+   return 0;
+}
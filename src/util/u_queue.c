@@ -178,12 +178,16 @@ util_queue_thread_func(void *input)
       }
    }
 
-   /* signal remaining jobs before terminating */
+   /* signal remaining jobs before terminating, they won't be executed */
    mtx_lock(&queue->lock);
    while (queue->jobs[queue->read_idx].job) {
-      util_queue_fence_signal(queue->jobs[queue->read_idx].fence);
+      struct util_queue_job *job = &queue->jobs[queue->read_idx];
 
-      queue->jobs[queue->read_idx].job = NULL;
+      util_queue_fence_signal(job->fence);
+      if (job->cleanup)
+         job->cleanup(job->job, thread_index);
+
+      job->job = NULL;
       queue->read_idx = (queue->read_idx + 1) % queue->max_jobs;
    }
    queue->num_queued = 0; /* reset this when exiting the thread */
@@ -288,7 +292,7 @@ util_queue_destroy(struct util_queue *queue)
    free(queue->threads);
 }
 
-void
+bool
 util_queue_add_job(struct util_queue *queue,
                    void *job,
                    struct util_queue_fence *fence,
@@ -302,10 +306,10 @@ util_queue_add_job(struct util_queue *queue,
    mtx_lock(&queue->lock);
    if (queue->kill_threads) {
       mtx_unlock(&queue->lock);
-      /* well no good option here, but any leaks will be
-       * short-lived as things are shutting down..
+      /* The threads are gone, e.g. because we are in exit().  The caller
+       * still owns the job and has to run it itself.
        */
-      return;
+      return false;
    }
 
    fence->signalled = false;
@@ -327,6 +331,7 @@ util_queue_add_job(struct util_queue *queue,
    queue->num_queued++;
    cnd_signal(&queue->has_queued_cond);
    mtx_unlock(&queue->lock);
+   return true;
 }
 
 int64_t
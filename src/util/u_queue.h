@@ -86,8 +86,15 @@ void util_queue_destroy(struct util_queue *queue);
 void util_queue_fence_init(struct util_queue_fence *fence);
 void util_queue_fence_destroy(struct util_queue_fence *fence);
 
-/* optional cleanup callback is called after fence is signaled: */
-void util_queue_add_job(struct util_queue *queue,
+/* optional cleanup callback is called after fence is signaled, also for
+ * jobs that are dropped without being executed because the queue is being
+ * destroyed.
+ *
+ * Returns false if the queue has been killed (by util_queue_destroy or at
+ * exit).  The job is not queued and the fence is left signalled in that
+ * case, so the caller has to execute and clean up the job itself.
+ */
+bool util_queue_add_job(struct util_queue *queue,
                         void *job,
                         struct util_queue_fence *fence,
                         util_queue_execute_func execute,